@@ -0,0 +1,239 @@
+/**
+ * @file corpus.cpp
+ * @brief Implementation of the benchmark corpus generator.
+ *
+ * This file contains the generators for each kind of benchmark document.
+ */
+
+#include "corpus.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+const QStringList kIdentifiers = {
+    "state", "render", "props", "element", "value", "options", "config", "items",
+    "handler", "result", "index", "count", "update", "node", "parent", "children",
+    "request", "response", "callback", "listener", "context", "buffer", "cache"
+};
+
+const QStringList kTags = {
+    "div", "section", "article", "span", "ul", "li", "p", "a", "nav", "header", "footer"
+};
+
+const QStringList kProperties = {
+    "color", "background-color", "margin", "padding", "border", "display", "width",
+    "height", "font-size", "line-height", "transform", "transition", "grid-template-columns"
+};
+
+QString pick(QRandomGenerator &random, const QStringList &words)
+{
+    return words.at(random.bounded(words.size()));
+}
+
+/** A statement of typical application code, without indentation or terminator. */
+QString statement(QRandomGenerator &random)
+{
+    const QString a = pick(random, kIdentifiers);
+    const QString b = pick(random, kIdentifiers);
+    switch (random.bounded(6)) {
+    case 0:
+        return QStringLiteral("const %1 = %2.%3(%4, \"%5\")").arg(a, b, pick(random, kIdentifiers))
+            .arg(random.bounded(1000)).arg(pick(random, kIdentifiers));
+    case 1:
+        return QStringLiteral("if (%1 !== null && %2.length > %3) { return %1; }").arg(a, b)
+            .arg(random.bounded(64));
+    case 2:
+        return QStringLiteral("for (let i = 0; i < %1.length; ++i) { %2 += %1[i] * %3.5; }").arg(a, b)
+            .arg(random.bounded(10));
+    case 3:
+        return QStringLiteral("%1.addEventListener('click', function (event) { %2(event, `%1-${%3}`); })")
+            .arg(a, b, pick(random, kIdentifiers));
+    case 4:
+        return QStringLiteral("// TODO: cache %1 by %2 before rendering").arg(a, b);
+    default:
+        return QStringLiteral("let %1 = typeof %2 === 'undefined' ? false : new Map()").arg(a, b);
+    }
+}
+
+/** A long, conventionally formatted script. */
+QString applicationScript(QRandomGenerator &random, int lines)
+{
+    QString script;
+    script.reserve(lines * 48);
+    int written = 0;
+    while (written < lines) {
+        script += QStringLiteral("/**\n * Handles %1 for the %2 view.\n */\n")
+                      .arg(pick(random, kIdentifiers), pick(random, kIdentifiers));
+        script += QStringLiteral("export function %1%2(%3, %4) {\n")
+                      .arg(pick(random, kIdentifiers)).arg(written)
+                      .arg(pick(random, kIdentifiers), pick(random, kIdentifiers));
+        written += 4;
+        const int body = 4 + random.bounded(12);
+        for (int i = 0; i < body; ++i) {
+            script += QStringLiteral("    ") + statement(random) + QStringLiteral(";\n");
+        }
+        script += QStringLiteral("}\n\n");
+        written += body + 2;
+    }
+    return script;
+}
+
+/** A minified bundle: the same kind of code squeezed onto a handful of lines. */
+QString minifiedBundle(QRandomGenerator &random, int bytes)
+{
+    QString bundle;
+    bundle.reserve(bytes + 256);
+    while (bundle.size() < bytes) {
+        bundle += QStringLiteral("!function(e,t){\"use strict\";");
+        const int statements = 200 + random.bounded(200);
+        for (int i = 0; i < statements; ++i) {
+            bundle += statement(random).remove(QLatin1Char(' ')) + QLatin1Char(';');
+        }
+        bundle += QStringLiteral("}(window,document);\n");
+    }
+    return bundle;
+}
+
+/** Markup nested @p depth elements deep, with attributes, entities and comments. */
+QString nestedHtml(QRandomGenerator &random, int depth, int repeats)
+{
+    QString html = QStringLiteral("<!DOCTYPE html>\n<html lang=\"en\">\n<head>\n"
+                                  "<meta charset=\"UTF-8\">\n<title>Nested</title>\n"
+                                  "<style>\n.box { margin: 4px; padding: 2px 8px; color: #334455; }\n</style>\n"
+                                  "</head>\n<body>\n");
+    for (int r = 0; r < repeats; ++r) {
+        QStringList open;
+        for (int d = 0; d < depth; ++d) {
+            const QString tag = pick(random, kTags);
+            open.append(tag);
+            html += QString(d % 64, QLatin1Char(' '));
+            html += QStringLiteral("<%1 class=\"box level-%2\" data-%3='%4'>")
+                        .arg(tag).arg(d).arg(pick(random, kIdentifiers)).arg(random.bounded(100000));
+            if (d % 7 == 0) {
+                html += QStringLiteral("Text &amp; more text &#8212; %1").arg(pick(random, kIdentifiers));
+            }
+            if (d % 31 == 0) {
+                html += QStringLiteral("<!-- level %1 -->").arg(d);
+            }
+            html += QLatin1Char('\n');
+        }
+        while (!open.isEmpty()) {
+            html += QString(open.size() % 64, QLatin1Char(' '));
+            html += QStringLiteral("</%1>\n").arg(open.takeLast());
+        }
+    }
+    html += QStringLiteral("<script>\n");
+    for (int i = 0; i < 200; ++i) {
+        html += statement(random) + QStringLiteral(";\n");
+    }
+    html += QStringLiteral("</script>\n</body>\n</html>\n");
+    return html;
+}
+
+/** A stylesheet of roughly @p lines lines. */
+QString largeStylesheet(QRandomGenerator &random, int lines)
+{
+    QString css;
+    css.reserve(lines * 32);
+    int written = 0;
+    while (written < lines) {
+        if (random.bounded(20) == 0) {
+            css += QStringLiteral("/* %1 section */\n").arg(pick(random, kIdentifiers));
+            ++written;
+        }
+        css += QStringLiteral(".%1-%2 > %3:hover, #%4 .%1::before {\n")
+                   .arg(pick(random, kIdentifiers)).arg(written)
+                   .arg(pick(random, kTags), pick(random, kIdentifiers));
+        const int declarations = 3 + random.bounded(6);
+        for (int i = 0; i < declarations; ++i) {
+            const QString property = pick(random, kProperties);
+            if (property.contains(QLatin1String("color"))) {
+                css += QStringLiteral("    %1: #%2;\n").arg(property)
+                           .arg(random.bounded(0x1000000), 6, 16, QLatin1Char('0'));
+            } else if (property == QLatin1String("transform")) {
+                css += QStringLiteral("    transform: translate(%1px, %2%) rotate(%3deg);\n")
+                           .arg(random.bounded(100)).arg(random.bounded(100)).arg(random.bounded(360));
+            } else {
+                css += QStringLiteral("    %1: %2.%3em;\n").arg(property)
+                           .arg(random.bounded(10)).arg(random.bounded(10));
+            }
+        }
+        css += QStringLiteral("}\n\n");
+        written += declarations + 3;
+    }
+    return css;
+}
+
+/** A document of a few lines, each hundreds of thousands of characters long. */
+QString longLines(QRandomGenerator &random, int lines, int lineLength)
+{
+    QString html = QStringLiteral("<!DOCTYPE html>\n");
+    for (int l = 0; l < lines; ++l) {
+        QString line;
+        line.reserve(lineLength + 128);
+        while (line.size() < lineLength) {
+            line += QStringLiteral("<%1 class=\"c%2\" style=\"width:%3px\">%4 &lt;%5&gt;</%1>")
+                        .arg(pick(random, kTags)).arg(random.bounded(1000)).arg(random.bounded(1000))
+                        .arg(pick(random, kIdentifiers), pick(random, kIdentifiers));
+        }
+        html += line + QLatin1Char('\n');
+    }
+    return html;
+}
+
+int scaled(int value, double scale)
+{
+    return qMax(1, int(value * scale));
+}
+}
+
+/**
+ * @brief Generates the standard corpus.
+ *
+ * @param scale Multiplies the size of every document; 1 is the reference size.
+ * @return The documents, in a stable order.
+ */
+QList<Corpus::Document> Corpus::generate(double scale)
+{
+    QRandomGenerator random(20250101);
+
+    QList<Document> documents;
+    documents.append({QStringLiteral("bundle.min.js"), minifiedBundle(random, scaled(2 * 1024 * 1024, scale))});
+    documents.append({QStringLiteral("application.js"), applicationScript(random, scaled(50000, scale))});
+    documents.append({QStringLiteral("nested.html"), nestedHtml(random, scaled(1500, scale), 8)});
+    documents.append({QStringLiteral("large.css"), largeStylesheet(random, scaled(100000, scale))});
+    documents.append({QStringLiteral("long-lines.html"), longLines(random, 4, scaled(500000, scale))});
+    return documents;
+}
+
+/**
+ * @brief Reads every HTML, CSS and JavaScript file in a directory.
+ *
+ * @param directory The directory to read, recursively.
+ * @return The documents found, sorted by name.
+ */
+QList<Corpus::Document> Corpus::load(const QString &directory)
+{
+    QList<Document> documents;
+    const QDir root(directory);
+    QDirIterator it(directory, {"*.html", "*.htm", "*.css", "*.js"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        documents.append({root.relativeFilePath(path), QString::fromUtf8(file.readAll())});
+    }
+
+    std::sort(documents.begin(), documents.end(), [](const Document &a, const Document &b) {
+        return a.name < b.name;
+    });
+    return documents;
+}
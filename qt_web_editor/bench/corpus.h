@@ -0,0 +1,52 @@
+/**
+ * @file corpus.h
+ * @brief Declaration of the benchmark corpus generator.
+ *
+ * This file contains the Corpus class which produces the documents rapid_bench
+ * measures the editor against.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <QList>
+#include <QString>
+
+/**
+ * @brief The Corpus class generates realistic HTML, CSS and JavaScript files.
+ *
+ * The documents are generated from a fixed seed, so every build is measured
+ * against exactly the same input. They cover the shapes that stress the editor:
+ * a minified bundle, a long hand-written script, deeply nested markup, a very
+ * large stylesheet and a document made of a few extremely long lines.
+ */
+class Corpus
+{
+public:
+    /**
+     * @brief A generated document.
+     */
+    struct Document
+    {
+        QString name;     /**< File name, whose suffix selects the language. */
+        QString content;  /**< Contents of the file. */
+    };
+
+    /**
+     * @brief Generates the standard corpus.
+     *
+     * @param scale Multiplies the size of every document; 1 is the reference size.
+     * @return The documents, in a stable order.
+     */
+    static QList<Document> generate(double scale = 1.0);
+
+    /**
+     * @brief Reads every HTML, CSS and JavaScript file in a directory.
+     *
+     * @param directory The directory to read, recursively.
+     * @return The documents found, sorted by name.
+     */
+    static QList<Document> load(const QString &directory);
+};
+
+#endif // CORPUS_H
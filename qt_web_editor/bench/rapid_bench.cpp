@@ -0,0 +1,344 @@
+/**
+ * @file rapid_bench.cpp
+ * @brief Entry point of the rapid_bench benchmark.
+ *
+ * This file contains the rapid_bench tool which measures loading, syntax
+ * highlighting and preview generation over a corpus of web documents and
+ * writes the results as JSON, so that builds can be compared with each other.
+ *
+ * The tool runs headless on the offscreen platform unless QT_QPA_PLATFORM says
+ * otherwise, and keeps its settings apart from those of the editor.
+ */
+
+#include "corpus.h"
+#include "core/application.h"
+#include "core/editorwidget.h"
+#include "core/previewdocument.h"
+#include "utils/syntaxhighlighter.h"
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPlainTextDocumentLayout>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+
+#ifndef RAPID_BENCH_BUILD_TYPE
+#define RAPID_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+/** Number of single-character edits timed per document. */
+constexpr int kEditsPerDocument = 20;
+
+/** Number of preview documents built per measurement. */
+constexpr int kPreviewRepeats = 10;
+
+/**
+ * @brief Summarizes a set of timings.
+ *
+ * @param samples The timings in milliseconds.
+ * @return An object with the minimum, median, mean and sample count.
+ */
+QJsonObject summarize(QVector<double> samples)
+{
+    QJsonObject summary;
+    if (samples.isEmpty()) {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double sample : qAsConst(samples)) {
+        total += sample;
+    }
+    const int middle = int(samples.size()) / 2;
+    const double median = samples.size() % 2 ? samples.at(middle)
+                                             : (samples.at(middle - 1) + samples.at(middle)) / 2;
+
+    summary["min_ms"] = samples.first();
+    summary["median_ms"] = median;
+    summary["mean_ms"] = total / samples.size();
+    summary["max_ms"] = samples.last();
+    summary["samples"] = int(samples.size());
+    return summary;
+}
+
+/**
+ * @brief Times a piece of work.
+ *
+ * @param work The work to time.
+ * @return The elapsed time in milliseconds.
+ */
+double timeMs(const std::function<void()> &work)
+{
+    QElapsedTimer timer;
+    timer.start();
+    work();
+    return timer.nsecsElapsed() / 1e6;
+}
+
+/**
+ * @brief Lets a highlighter finish its background pass.
+ *
+ * @param highlighter The highlighter to wait for.
+ */
+void finishHighlighting(SyntaxHighlighter *highlighter)
+{
+    while (!highlighter->isHighlightingComplete()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+    }
+}
+
+/**
+ * @brief Lets an editor finish loading a file in the background.
+ *
+ * @param editor The editor to wait for.
+ */
+void finishLoading(EditorWidget *editor)
+{
+    while (editor->isLoading()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+    }
+}
+
+/**
+ * @brief A document set up for highlighting outside of an editor.
+ */
+struct HighlightedDocument
+{
+    explicit HighlightedDocument(const QString &content)
+    {
+        document.setDocumentLayout(new QPlainTextDocumentLayout(&document));
+        document.setPlainText(content);
+        highlighter = new SyntaxHighlighter(&document);
+    }
+
+    QTextDocument document;
+    SyntaxHighlighter *highlighter = nullptr;
+};
+
+/**
+ * @brief Measures EditorWidget::load() on a file.
+ *
+ * Files large enough to be loaded in the background are timed until the
+ * last chunk is in the editor, not just until the load has started.
+ *
+ * @param path The file to load.
+ * @param iterations Number of runs.
+ * @return The timings in milliseconds.
+ */
+QVector<double> measureLoad(const QString &path, int iterations)
+{
+    QVector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        EditorWidget editor;
+        samples.append(timeMs([&]() {
+            editor.load(path);
+            finishLoading(&editor);
+        }));
+    }
+    return samples;
+}
+
+/**
+ * @brief Measures highlighting a whole document, background pass included.
+ *
+ * @param language The language name passed to the highlighter.
+ * @param content The document.
+ * @param iterations Number of runs.
+ * @return The timings in milliseconds.
+ */
+QVector<double> measureFullHighlight(const QString &language, const QString &content, int iterations)
+{
+    QVector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        HighlightedDocument doc(content);
+        samples.append(timeMs([&]() {
+            doc.highlighter->setLanguage(language);
+            finishHighlighting(doc.highlighter);
+        }));
+    }
+    return samples;
+}
+
+/**
+ * @brief Measures rehighlighting after inserting or removing one character.
+ *
+ * The edits are spread over the document, and each is timed until the
+ * highlighter has caught up with it.
+ *
+ * @param language The language name passed to the highlighter.
+ * @param content The document.
+ * @return The timings in milliseconds.
+ */
+QVector<double> measureIncrementalHighlight(const QString &language, const QString &content)
+{
+    HighlightedDocument doc(content);
+    doc.highlighter->setLanguage(language);
+    finishHighlighting(doc.highlighter);
+
+    QVector<double> samples;
+    const int blockCount = doc.document.blockCount();
+    for (int i = 0; i < kEditsPerDocument; ++i) {
+        const QTextBlock block = doc.document.findBlockByNumber(int(qint64(blockCount) * i / kEditsPerDocument));
+        QTextCursor cursor(block);
+        cursor.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor, block.length() / 2);
+
+        samples.append(timeMs([&]() {
+            cursor.insertText(QStringLiteral("x"));
+            finishHighlighting(doc.highlighter);
+        }));
+        samples.append(timeMs([&]() {
+            cursor.deletePreviousChar();
+            finishHighlighting(doc.highlighter);
+        }));
+    }
+    return samples;
+}
+
+/**
+ * @brief Measures building the preview document.
+ *
+ * @param name The file name, which selects the kind of page.
+ * @param content The document.
+ * @param iterations Number of runs.
+ * @return The timings in milliseconds.
+ */
+QVector<double> measurePreview(const QString &name, const QString &content, int iterations)
+{
+    QVector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        int length = 0;
+        samples.append(timeMs([&]() {
+            for (int r = 0; r < kPreviewRepeats; ++r) {
+                length += int(PreviewDocument::htmlFor(name, content).size());
+            }
+        }) / kPreviewRepeats);
+        Q_UNUSED(length);
+    }
+    return samples;
+}
+
+/**
+ * @brief Describes the build and machine the results were taken on.
+ *
+ * @return The environment object of the report.
+ */
+QJsonObject environment()
+{
+    QJsonObject env;
+    env["qt_version"] = QString::fromLatin1(qVersion());
+    env["build_type"] = QStringLiteral(RAPID_BENCH_BUILD_TYPE);
+    env["os"] = QSysInfo::prettyProductName();
+    env["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    env["platform"] = QGuiApplication::platformName();
+    env["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    return env;
+}
+}
+
+/**
+ * @brief Main entry point of the benchmark.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Array of command-line arguments.
+ * @return 0 on success, 1 if the corpus or the report could not be written.
+ */
+int main(int argc, char *argv[])
+{
+    // Run headless and leave the user's settings alone
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QStandardPaths::setTestModeEnabled(true);
+
+    Application app(argc, argv);
+    app.setApplicationName("rapid_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures loading, highlighting and preview generation in Rapid.");
+    parser.addHelpOption();
+    QCommandLineOption outputOption({"o", "output"}, "Write the JSON report to <file> instead of stdout.", "file");
+    QCommandLineOption iterationsOption({"n", "iterations"}, "Number of runs per measurement (default 5).", "count", "5");
+    QCommandLineOption scaleOption("scale", "Size factor of the generated corpus (default 1).", "factor", "1");
+    QCommandLineOption corpusOption("corpus", "Measure the files in <dir> instead of the generated corpus.", "dir");
+    QCommandLineOption filterOption("filter", "Only measure documents whose name contains <text>.", "text");
+    parser.addOptions({outputOption, iterationsOption, scaleOption, corpusOption, filterOption});
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const QList<Corpus::Document> documents = parser.isSet(corpusOption)
+        ? Corpus::load(parser.value(corpusOption))
+        : Corpus::generate(qMax(0.01, parser.value(scaleOption).toDouble()));
+
+    // EditorWidget loads from disk, so the documents are written out first
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        qCritical() << "Could not create a temporary directory:" << workDir.errorString();
+        return 1;
+    }
+
+    QJsonArray results;
+    for (const Corpus::Document &document : documents) {
+        if (parser.isSet(filterOption) && !document.name.contains(parser.value(filterOption))) {
+            continue;
+        }
+
+        const QString path = workDir.filePath(QFileInfo(document.name).fileName());
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Could not write" << path << file.errorString();
+            return 1;
+        }
+        file.write(document.content.toUtf8());
+        file.close();
+
+        const QString language = QFileInfo(document.name).suffix().toLower();
+        qInfo().noquote() << "Measuring" << document.name;
+
+        QJsonObject metrics;
+        metrics["load"] = summarize(measureLoad(path, iterations));
+        metrics["full_highlight"] = summarize(measureFullHighlight(language, document.content, iterations));
+        metrics["incremental_highlight"] = summarize(measureIncrementalHighlight(language, document.content));
+        metrics["preview_generation"] = summarize(measurePreview(document.name, document.content, iterations));
+
+        QJsonObject result;
+        result["document"] = document.name;
+        result["characters"] = int(document.content.size());
+        result["lines"] = int(document.content.count(QLatin1Char('\n'))) + 1;
+        result["metrics"] = metrics;
+        results.append(result);
+    }
+
+    QJsonObject report;
+    report["environment"] = environment();
+    report["iterations"] = iterations;
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate) || output.write(json) != json.size()) {
+            qCritical() << "Could not write the report to" << output.fileName() << output.errorString();
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
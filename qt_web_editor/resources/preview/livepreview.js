@@ -0,0 +1,188 @@
+/*
+ * Rapid live preview runtime.
+ *
+ * Injected into every preview page (in the application world, together with
+ * qwebchannel.js). Keeps a copy of the body source, applies the splices sent
+ * by the editor and morphs the live DOM so only changed nodes are touched.
+ * Linked stylesheets can be swapped for inline rules without a reload.
+ */
+(function () {
+    'use strict';
+
+    if (window.__rapidLivePreview || typeof qt === 'undefined' || !qt.webChannelTransport) {
+        return;
+    }
+    window.__rapidLivePreview = true;
+
+    var source = null;
+    var serial = -1;
+    var stylesheets = {};
+
+    function sameKind(a, b) {
+        return a.nodeType === b.nodeType && a.nodeName === b.nodeName;
+    }
+
+    function syncAttributes(from, to) {
+        var i, attr;
+        for (i = from.attributes.length - 1; i >= 0; --i) {
+            attr = from.attributes[i];
+            if (!to.hasAttribute(attr.name)) {
+                from.removeAttribute(attr.name);
+            }
+        }
+        for (i = 0; i < to.attributes.length; ++i) {
+            attr = to.attributes[i];
+            if (from.getAttribute(attr.name) !== attr.value) {
+                from.setAttribute(attr.name, attr.value);
+            }
+        }
+    }
+
+    function morphNode(from, to) {
+        if (from.nodeType === Node.TEXT_NODE || from.nodeType === Node.COMMENT_NODE) {
+            if (from.nodeValue !== to.nodeValue) {
+                from.nodeValue = to.nodeValue;
+            }
+            return;
+        }
+        syncAttributes(from, to);
+        if (from.nodeName === 'TEMPLATE') {
+            morphChildren(from.content, to.content);
+        } else {
+            morphChildren(from, to);
+        }
+    }
+
+    function morphChildren(fromParent, toParent) {
+        var from = fromParent.firstChild;
+        var to = toParent.firstChild;
+
+        while (to) {
+            var nextTo = to.nextSibling;
+
+            if (!from) {
+                fromParent.appendChild(document.importNode(to, true));
+            } else if (from.isEqualNode(to)) {
+                from = from.nextSibling;
+            } else if (from.nextSibling && from.nextSibling.isEqualNode(to)) {
+                // A node was removed from the source
+                var removed = from;
+                from = from.nextSibling;
+                fromParent.removeChild(removed);
+                from = from.nextSibling;
+            } else if (nextTo && from.isEqualNode(nextTo)) {
+                // A node was inserted into the source
+                fromParent.insertBefore(document.importNode(to, true), from);
+            } else if (sameKind(from, to)) {
+                morphNode(from, to);
+                from = from.nextSibling;
+            } else {
+                var replaced = from;
+                from = from.nextSibling;
+                fromParent.replaceChild(document.importNode(to, true), replaced);
+            }
+
+            to = nextTo;
+        }
+
+        while (from) {
+            var next = from.nextSibling;
+            fromParent.removeChild(from);
+            from = next;
+        }
+    }
+
+    function findStylesheet(url) {
+        var i, nodes = document.querySelectorAll('style[data-rapid-href]');
+        for (i = 0; i < nodes.length; ++i) {
+            if (nodes[i].getAttribute('data-rapid-href') === url) {
+                return nodes[i];
+            }
+        }
+        nodes = document.querySelectorAll('link[rel~="stylesheet" i][href]');
+        for (i = 0; i < nodes.length; ++i) {
+            if (nodes[i].href === url) {
+                return nodes[i];
+            }
+        }
+        return null;
+    }
+
+    function applyStylesheet(url, css) {
+        var node = findStylesheet(url);
+        if (!node) {
+            return false;
+        }
+        if (node.nodeName !== 'STYLE') {
+            // Swap the link for a style element in the same cascade position
+            var style = document.createElement('style');
+            style.setAttribute('data-rapid-href', url);
+            if (node.media) {
+                style.media = node.media;
+            }
+            node.parentNode.replaceChild(style, node);
+            node = style;
+        }
+        if (node.textContent !== css) {
+            node.textContent = css;
+        }
+        return true;
+    }
+
+    function applySource(text) {
+        var template = document.createElement('template');
+        template.innerHTML = text;
+        morphChildren(document.body, template.content);
+
+        // Morphing restores links written in the body; swap them back
+        for (var url in stylesheets) {
+            applyStylesheet(url, stylesheets[url]);
+        }
+    }
+
+    new QWebChannel(qt.webChannelTransport, function (channel) {
+        var bridge = channel.objects.rapidPreview;
+        if (!bridge) {
+            return;
+        }
+
+        bridge.sourceReset.connect(function (newSerial, bodySource) {
+            serial = newSerial;
+            source = bodySource;
+        });
+
+        bridge.bodyPatched.connect(function (newSerial, baseSerial, position, removed, inserted) {
+            var ok = false;
+            if (source !== null && baseSerial === serial && document.body) {
+                try {
+                    source = source.slice(0, position) + inserted + source.slice(position + removed);
+                    applySource(source);
+                    serial = newSerial;
+                    ok = true;
+                } catch (e) {
+                    console.error('Rapid live preview: ' + e);
+                }
+            }
+            if (!ok) {
+                source = null;
+            }
+            bridge.patchApplied(newSerial, ok);
+        });
+
+        bridge.stylesheetUpdated.connect(function (newSerial, url, css) {
+            var ok = false;
+            try {
+                stylesheets[url] = css;
+                ok = applyStylesheet(url, css);
+            } catch (e) {
+                console.error('Rapid live preview: ' + e);
+            }
+            if (source !== null) {
+                serial = newSerial;
+            }
+            bridge.stylesheetApplied(newSerial, ok);
+        });
+
+        bridge.runtimeReady();
+    });
+})();
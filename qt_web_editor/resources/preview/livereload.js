@@ -0,0 +1,92 @@
+/*
+ * Rapid live reload client.
+ *
+ * Added by the development server to every HTML page it serves. Listens on a
+ * WebSocket for changed files: stylesheets the page links are re-fetched in
+ * place, and the page reloads if it is the changed file or has loaded it.
+ */
+(function () {
+    'use strict';
+
+    if (window.__rapidLiveReload || typeof WebSocket === 'undefined') {
+        return;
+    }
+    window.__rapidLiveReload = true;
+
+    function pathOf(url) {
+        try {
+            return new URL(url, location.href).pathname;
+        } catch (e) {
+            return null;
+        }
+    }
+
+    function swapStylesheets(path) {
+        var links = document.querySelectorAll('link[rel~="stylesheet" i][href]');
+        var found = false;
+        for (var i = 0; i < links.length; ++i) {
+            var link = links[i];
+            if (pathOf(link.href) !== path) {
+                continue;
+            }
+            // Load the new sheet next to the old one so the page never goes unstyled
+            var url = new URL(link.href);
+            url.searchParams.set('rapid', Date.now());
+            var next = link.cloneNode(false);
+            next.href = url.href;
+            next.onload = next.onerror = (function (old) {
+                return function () {
+                    if (old.parentNode) {
+                        old.parentNode.removeChild(old);
+                    }
+                };
+            })(link);
+            link.parentNode.insertBefore(next, link.nextSibling);
+            found = true;
+        }
+        return found;
+    }
+
+    function usesResource(path) {
+        if (location.pathname === path
+            || (location.pathname.slice(-1) === '/' && location.pathname + 'index.html' === path)) {
+            return true;
+        }
+        var entries = performance.getEntriesByType('resource');
+        for (var i = 0; i < entries.length; ++i) {
+            if (pathOf(entries[i].name) === path) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    function connect() {
+        var socket = new WebSocket('ws://' + location.host + '/__rapid/socket');
+
+        socket.onmessage = function (event) {
+            var message;
+            try {
+                message = JSON.parse(event.data);
+            } catch (e) {
+                return;
+            }
+            if (message.type !== 'change') {
+                return;
+            }
+            if (message.css && swapStylesheets(message.path)) {
+                return;
+            }
+            if (usesResource(message.path)) {
+                location.reload();
+            }
+        };
+
+        // The editor may restart the server; keep trying to reconnect
+        socket.onclose = function () {
+            setTimeout(connect, 1000);
+        };
+    }
+
+    connect();
+})();
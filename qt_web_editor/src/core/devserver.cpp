@@ -0,0 +1,652 @@
+/**
+ * @file devserver.cpp
+ * @brief Implementation of the DevServer class.
+ *
+ * This file contains the implementation of the embedded development server,
+ * including the HTTP connection handling and the live reload channel.
+ */
+
+#include "devserver.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <QDebug>
+
+#include <memory>
+
+namespace {
+/** Path of the live reload client script. */
+const QByteArray kClientScriptPath = QByteArrayLiteral("/__rapid/livereload.js");
+
+/** Path the live reload client connects its WebSocket to. */
+const QByteArray kSocketPath = QByteArrayLiteral("/__rapid/socket");
+
+/** Largest request head accepted before the connection is dropped. */
+constexpr qint64 kMaxHeaderSize = 16 * 1024;
+
+/** Bytes handed to the socket per write while streaming a file. */
+constexpr qint64 kStreamChunkSize = 256 * 1024;
+
+/** Seconds an idle keep-alive connection is held open. */
+constexpr int kKeepAliveTimeout = 5;
+
+/**
+ * @brief A parsed HTTP request head.
+ */
+struct RequestHead
+{
+    QByteArray method;
+    QByteArray target;
+    QByteArray version;
+    QHash<QByteArray, QByteArray> headers;  /**< Header values by lower-case name. */
+};
+
+/**
+ * @brief Parses the request line and headers of an HTTP request.
+ *
+ * @param data The request head without the terminating empty line.
+ * @param head Receives the parsed request.
+ * @return True if the request line is well formed.
+ */
+bool parseRequestHead(const QByteArray &data, RequestHead *head)
+{
+    const QList<QByteArray> lines = data.split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/1.")) {
+        return false;
+    }
+
+    head->method = requestLine.at(0);
+    head->target = requestLine.at(1);
+    head->version = requestLine.at(2);
+
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray &line = lines.at(i);
+        const int colon = line.indexOf(':');
+        if (colon > 0) {
+            head->headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the reason phrase for the status codes the server sends.
+ */
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return QByteArrayLiteral("OK");
+    case 400: return QByteArrayLiteral("Bad Request");
+    case 403: return QByteArrayLiteral("Forbidden");
+    case 404: return QByteArrayLiteral("Not Found");
+    case 405: return QByteArrayLiteral("Method Not Allowed");
+    case 413: return QByteArrayLiteral("Payload Too Large");
+    case 431: return QByteArrayLiteral("Request Header Fields Too Large");
+    default: return QByteArrayLiteral("Internal Server Error");
+    }
+}
+
+/**
+ * @brief Adds the live reload client to an HTML page.
+ *
+ * @param html The page source.
+ * @return The page with the client script inserted before the body end tag.
+ */
+QByteArray injectClientScript(QByteArray html)
+{
+    const QByteArray tag = "<script src=\"" + kClientScriptPath + "\"></script>";
+    const int bodyEnd = html.toLower().lastIndexOf("</body>");
+    if (bodyEnd >= 0) {
+        html.insert(bodyEnd, tag);
+    } else {
+        html.append(tag);
+    }
+    return html;
+}
+
+/**
+ * @brief Resolves symbolic links so paths compare against the canonical root.
+ */
+QString resolvedPath(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    const QString canonicalPath = info.canonicalFilePath();
+    return canonicalPath.isEmpty() ? info.absoluteFilePath() : canonicalPath;
+}
+
+bool isHtmlFile(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    return suffix == "html" || suffix == "htm";
+}
+}
+
+/**
+ * @brief One HTTP connection to the server.
+ *
+ * Requests on a connection are answered one at a time, in order; pipelined
+ * requests wait in the socket until the previous response has been written.
+ */
+class DevServer::Connection : public QObject
+{
+public:
+    Connection(QTcpSocket *socket, DevServer *server)
+        : QObject(server)
+        , m_server(server)
+        , m_socket(socket)
+    {
+        m_socket->setParent(this);
+        m_server->m_connections.append(this);
+
+        m_idleTimer.setSingleShot(true);
+        m_idleTimer.setInterval(kKeepAliveTimeout * 1000);
+        connect(&m_idleTimer, &QTimer::timeout, m_socket, &QTcpSocket::disconnectFromHost);
+
+        connect(m_socket, &QTcpSocket::readyRead, this, [this]() { processRequests(); });
+        connect(m_socket, &QTcpSocket::bytesWritten, this, [this]() { pump(); });
+        connect(m_socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+
+        m_idleTimer.start();
+    }
+
+    ~Connection() override
+    {
+        m_server->m_connections.removeOne(this);
+        finishStream();
+    }
+
+private:
+    /**
+     * @brief Answers every complete request waiting in the socket.
+     */
+    void processRequests()
+    {
+        while (!m_file && m_socket && m_socket->state() == QAbstractSocket::ConnectedState) {
+            // Peek first: an upgrade request must reach the WebSocket server untouched
+            const QByteArray pending = m_socket->peek(kMaxHeaderSize);
+            const int headEnd = pending.indexOf("\r\n\r\n");
+            if (headEnd < 0) {
+                if (m_socket->bytesAvailable() >= kMaxHeaderSize) {
+                    m_socket->readAll();
+                    sendError(431, true);
+                }
+                return;
+            }
+
+            RequestHead head;
+            if (!parseRequestHead(pending.left(headEnd), &head)) {
+                m_socket->readAll();
+                sendError(400, true);
+                return;
+            }
+
+            // A page on another site can point its own host name at this
+            // machine; only requests addressed to the server itself, and
+            // live reload connections from its own pages, are answered
+            if (!m_server->isAllowedHost(head.headers.value("host"))) {
+                m_socket->readAll();
+                sendError(403, true);
+                return;
+            }
+
+            const QByteArray path = head.target.split('?').value(0);
+            if (path == kSocketPath && head.headers.value("upgrade").toLower() == "websocket") {
+                if (!m_server->isAllowedOrigin(head.headers.value("origin"))) {
+                    m_socket->readAll();
+                    sendError(403, true);
+                    return;
+                }
+                upgrade();
+                return;
+            }
+
+            m_socket->read(headEnd + 4);
+            m_idleTimer.stop();
+
+            // HTTP/1.1 keeps connections open unless asked not to; 1.0 only if asked to
+            const QByteArray connectionHeader = head.headers.value("connection").toLower();
+            m_closeAfterResponse = head.version == "HTTP/1.0"
+                ? !connectionHeader.contains("keep-alive")
+                : connectionHeader.contains("close");
+
+            if (head.headers.value("content-length", "0").toLongLong() > 0
+                || head.headers.contains("transfer-encoding")) {
+                // Request bodies are never accepted; the stream cannot be resynchronised
+                sendError(413, true);
+                return;
+            }
+
+            respond(head, path);
+        }
+    }
+
+    /**
+     * @brief Writes the response to a single request.
+     */
+    void respond(const RequestHead &head, const QByteArray &path)
+    {
+        const bool headOnly = head.method == "HEAD";
+        if (head.method != "GET" && !headOnly) {
+            sendError(405, m_closeAfterResponse);
+            return;
+        }
+
+        if (path == kClientScriptPath) {
+            QFile script(QStringLiteral(":/preview/livereload.js"));
+            script.open(QIODevice::ReadOnly);
+            sendData(PreviewSchemeHandler::contentTypeForFile(script.fileName()), script.readAll(), headOnly);
+            return;
+        }
+
+        const QString requestPath = QUrl::fromPercentEncoding(path);
+        QString filePath = m_server->localPathFor(requestPath);
+        if (filePath.isEmpty()) {
+            sendError(403, m_closeAfterResponse);
+            return;
+        }
+        if (QFileInfo(filePath).isDir()) {
+            filePath = QDir(filePath).filePath(QStringLiteral("index.html"));
+        }
+
+        const QByteArray contentType = PreviewSchemeHandler::contentTypeForFile(filePath);
+
+        // Unsaved edits take precedence over the file on disk
+        TextSnapshot contents;
+        if (m_server->m_bufferProvider && m_server->m_bufferProvider(filePath, &contents)) {
+            QByteArray body = contents.toUtf8();
+            if (isHtmlFile(filePath)) {
+                body = injectClientScript(body);
+            }
+            sendData(contentType, body, headOnly);
+            return;
+        }
+
+        auto file = std::make_unique<QFile>(filePath);
+        if (!file->open(QIODevice::ReadOnly)) {
+            sendError(404, m_closeAfterResponse);
+            return;
+        }
+
+        if (isHtmlFile(filePath)) {
+            sendData(contentType, injectClientScript(file->readAll()), headOnly);
+            return;
+        }
+
+        writeHead(200, contentType, file->size());
+        if (headOnly || file->size() == 0) {
+            finishResponse();
+            return;
+        }
+
+        // Serve straight from the page cache; fall back to reads if mapping fails
+        m_file = std::move(file);
+        m_mapped = m_file->map(0, m_file->size());
+        m_offset = 0;
+        pump();
+    }
+
+    /**
+     * @brief Feeds the next part of the file being streamed to the socket.
+     */
+    void pump()
+    {
+        if (!m_file) {
+            return;
+        }
+
+        const qint64 size = m_file->size();
+        while (m_offset < size && m_socket->bytesToWrite() < kStreamChunkSize) {
+            const qint64 length = qMin(kStreamChunkSize, size - m_offset);
+            qint64 written;
+            if (m_mapped) {
+                written = m_socket->write(reinterpret_cast<const char *>(m_mapped) + m_offset, length);
+            } else {
+                written = m_socket->write(m_file->read(length));
+            }
+            if (written <= 0) {
+                m_socket->abort();
+                return;
+            }
+            m_offset += written;
+        }
+
+        if (m_offset >= size) {
+            finishStream();
+            finishResponse();
+        }
+    }
+
+    void finishStream()
+    {
+        if (m_file) {
+            if (m_mapped) {
+                m_file->unmap(m_mapped);
+                m_mapped = nullptr;
+            }
+            m_file.reset();
+        }
+    }
+
+    /**
+     * @brief Completes a response and goes on with the next request, if any.
+     */
+    void finishResponse()
+    {
+        if (m_closeAfterResponse) {
+            m_socket->disconnectFromHost();
+            return;
+        }
+        m_idleTimer.start();
+        if (m_socket->bytesAvailable() > 0) {
+            QTimer::singleShot(0, this, [this]() { processRequests(); });
+        }
+    }
+
+    void writeHead(int status, const QByteArray &contentType, qint64 contentLength)
+    {
+        QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+        if (!contentType.isEmpty()) {
+            head += "Content-Type: " + contentType + "\r\n";
+        }
+        head += "Content-Length: " + QByteArray::number(contentLength) + "\r\n";
+        head += "Cache-Control: no-store\r\n";
+        if (m_closeAfterResponse) {
+            head += "Connection: close\r\n";
+        } else {
+            head += "Connection: keep-alive\r\n";
+            head += "Keep-Alive: timeout=" + QByteArray::number(kKeepAliveTimeout) + "\r\n";
+        }
+        head += "\r\n";
+        m_socket->write(head);
+    }
+
+    void sendData(const QByteArray &contentType, const QByteArray &body, bool headOnly)
+    {
+        writeHead(200, contentType, body.size());
+        if (!headOnly) {
+            m_socket->write(body);
+        }
+        finishResponse();
+    }
+
+    void sendError(int status, bool close)
+    {
+        m_closeAfterResponse = close;
+        const QByteArray body = QByteArray::number(status) + ' ' + reasonPhrase(status) + '\n';
+        sendData(QByteArrayLiteral("text/plain; charset=utf-8"), body, false);
+    }
+
+    /**
+     * @brief Hands the connection over to the WebSocket server.
+     */
+    void upgrade()
+    {
+        m_idleTimer.stop();
+        m_socket->disconnect(this);
+        m_socket->setParent(nullptr);
+        m_server->m_socketServer->handleConnection(m_socket);
+        m_socket = nullptr;
+        deleteLater();
+    }
+
+    DevServer *m_server;
+    QTcpSocket *m_socket;
+    QTimer m_idleTimer;
+    std::unique_ptr<QFile> m_file;       /**< File being streamed, if any. */
+    uchar *m_mapped = nullptr;           /**< Mapping of m_file, or null to read it. */
+    qint64 m_offset = 0;                 /**< Bytes of m_file written so far. */
+    bool m_closeAfterResponse = false;
+};
+
+/**
+ * @brief Constructs a DevServer with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+DevServer::DevServer(QObject *parent)
+    : QObject(parent)
+    , m_httpServer(new QTcpServer(this))
+    , m_socketServer(new QWebSocketServer(QStringLiteral("Rapid"), QWebSocketServer::NonSecureMode, this))
+{
+    connect(m_httpServer, &QTcpServer::newConnection, this, &DevServer::acceptConnection);
+    connect(m_socketServer, &QWebSocketServer::newConnection, this, &DevServer::acceptClient);
+}
+
+/**
+ * @brief Destroys the DevServer, closing all connections.
+ */
+DevServer::~DevServer()
+{
+    stop();
+}
+
+/**
+ * @brief Starts serving a folder, restarting the server if needed.
+ *
+ * The server listens on the loopback interface only, on a port chosen by the
+ * system. Restarting for another folder keeps the port when it is still free so
+ * that open browser tabs reconnect.
+ *
+ * @param rootPath The folder to serve.
+ * @return True if the server is listening.
+ */
+bool DevServer::start(const QString &rootPath)
+{
+    const QString canonicalRoot = QFileInfo(rootPath).canonicalFilePath();
+    if (canonicalRoot.isEmpty()) {
+        return false;
+    }
+    if (isRunning() && canonicalRoot == m_rootPath) {
+        return true;
+    }
+
+    const quint16 previousPort = port();
+    stop();
+    m_rootPath = canonicalRoot;
+
+    if (previousPort != 0 && m_httpServer->listen(QHostAddress::LocalHost, previousPort)) {
+        return true;
+    }
+    if (!m_httpServer->listen(QHostAddress::LocalHost, 0)) {
+        qWarning() << "Could not start the development server:" << m_httpServer->errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stops the server and closes all connections.
+ */
+void DevServer::stop()
+{
+    m_httpServer->close();
+
+    const QList<Connection*> connections = m_connections;
+    qDeleteAll(connections);
+
+    const QList<QWebSocket*> clients = m_clients;
+    m_clients.clear();
+    for (QWebSocket *client : clients) {
+        client->disconnect(this);
+        client->close(QWebSocketProtocol::CloseCodeGoingAway);
+        client->deleteLater();
+    }
+    if (!clients.isEmpty()) {
+        emit clientCountChanged(0);
+    }
+}
+
+/**
+ * @brief Returns whether the server is listening.
+ *
+ * @return True if the server is listening.
+ */
+bool DevServer::isRunning() const
+{
+    return m_httpServer->isListening();
+}
+
+/**
+ * @brief Returns the port the server listens on.
+ *
+ * @return The port, or 0 when stopped.
+ */
+quint16 DevServer::port() const
+{
+    return isRunning() ? m_httpServer->serverPort() : 0;
+}
+
+/**
+ * @brief Checks whether a file lies inside the served folder.
+ *
+ * @param filePath The file path.
+ * @return True if the file can be served.
+ */
+bool DevServer::contains(const QString &filePath) const
+{
+    if (m_rootPath.isEmpty()) {
+        return false;
+    }
+    const QString absolutePath = resolvedPath(filePath);
+    return absolutePath == m_rootPath || absolutePath.startsWith(m_rootPath + QLatin1Char('/'));
+}
+
+/**
+ * @brief Builds the http:// URL under which a file is served.
+ *
+ * @param filePath The file path.
+ * @return The URL, or an empty URL if the file is not served.
+ */
+QUrl DevServer::urlForFile(const QString &filePath) const
+{
+    if (!isRunning() || !contains(filePath)) {
+        return QUrl();
+    }
+
+    QUrl url;
+    url.setScheme(QStringLiteral("http"));
+    url.setHost(QStringLiteral("127.0.0.1"));
+    url.setPort(port());
+    url.setPath(QLatin1Char('/') + QDir(m_rootPath).relativeFilePath(resolvedPath(filePath)));
+    return url;
+}
+
+/**
+ * @brief Sets the callback used to find unsaved editor contents.
+ *
+ * @param provider The buffer lookup callback.
+ */
+void DevServer::setBufferProvider(BufferProvider provider)
+{
+    m_bufferProvider = std::move(provider);
+}
+
+/**
+ * @brief Tells connected browsers that a file has changed.
+ *
+ * Each page decides for itself whether the file concerns it: stylesheets it
+ * links are swapped in place, and the page reloads if it is the file or has
+ * loaded it as a resource.
+ *
+ * @param filePath The file that changed.
+ */
+void DevServer::notifyFileChanged(const QString &filePath)
+{
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    const QUrl url = urlForFile(filePath);
+    if (url.isEmpty()) {
+        return;
+    }
+
+    QJsonObject message;
+    message.insert(QStringLiteral("type"), QStringLiteral("change"));
+    message.insert(QStringLiteral("path"), url.path(QUrl::FullyEncoded));
+    message.insert(QStringLiteral("css"), QFileInfo(filePath).suffix().compare(QLatin1String("css"), Qt::CaseInsensitive) == 0);
+    const QString text = QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+
+    for (QWebSocket *client : qAsConst(m_clients)) {
+        client->sendTextMessage(text);
+    }
+}
+
+/**
+ * @brief Accepts pending HTTP connections.
+ */
+void DevServer::acceptConnection()
+{
+    while (QTcpSocket *socket = m_httpServer->nextPendingConnection()) {
+        new Connection(socket, this);
+    }
+}
+
+/**
+ * @brief Accepts pending live reload clients.
+ */
+void DevServer::acceptClient()
+{
+    while (QWebSocket *client = m_socketServer->nextPendingConnection()) {
+        m_clients.append(client);
+        connect(client, &QWebSocket::disconnected, this, [this, client]() {
+            m_clients.removeOne(client);
+            client->deleteLater();
+            emit clientCountChanged(m_clients.size());
+        });
+        emit clientCountChanged(m_clients.size());
+    }
+}
+
+/**
+ * @brief Checks the Host header of a request.
+ *
+ * @param host The value of the header.
+ * @return True if the request is addressed to this server by loopback address or localhost.
+ */
+bool DevServer::isAllowedHost(const QByteArray &host) const
+{
+    const QByteArray port = QByteArray::number(this->port());
+    const QByteArray value = host.trimmed().toLower();
+    return value == "127.0.0.1:" + port || value == "localhost:" + port;
+}
+
+/**
+ * @brief Checks the Origin header of a live reload connection.
+ *
+ * @param origin The value of the header.
+ * @return True if the connection comes from a page served by this server.
+ */
+bool DevServer::isAllowedOrigin(const QByteArray &origin) const
+{
+    const QByteArray value = origin.trimmed().toLower();
+    return value.startsWith("http://") && isAllowedHost(value.mid(int(qstrlen("http://"))));
+}
+
+/**
+ * @brief Maps the path of a request to a file in the served folder.
+ *
+ * @param requestPath The decoded path of the request URL.
+ * @return The local file path, or an empty string if it lies outside the folder.
+ */
+QString DevServer::localPathFor(const QString &requestPath) const
+{
+    if (m_rootPath.isEmpty() || !requestPath.startsWith(QLatin1Char('/'))) {
+        return QString();
+    }
+
+    // contains() resolves symbolic links, so links out of the folder are refused too
+    const QString filePath = QDir::cleanPath(m_rootPath + requestPath);
+    return contains(filePath) ? filePath : QString();
+}
@@ -0,0 +1,162 @@
+/**
+ * @file devserver.h
+ * @brief Declaration of the DevServer class.
+ *
+ * This file contains the DevServer class, a small HTTP server bound to the
+ * loopback interface that serves the opened folder to external browsers and
+ * pushes live-reload events to them over a WebSocket.
+ */
+
+#ifndef DEVSERVER_H
+#define DEVSERVER_H
+
+#include "previewschemehandler.h"
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+class QTcpServer;
+class QWebSocket;
+class QWebSocketServer;
+
+/**
+ * @brief The DevServer class serves a folder over http://127.0.0.1.
+ *
+ * Requests are answered from the unsaved buffer of an open editor when there is
+ * one and from the file on disk otherwise, so a browser sees exactly what is in
+ * the editor without the file being saved first. Connections are kept alive
+ * between requests. Static files are mapped into memory and fed to the socket
+ * window by window as it drains instead of being read into memory up front.
+ *
+ * Every HTML page gets a small client script (resources/preview/livereload.js)
+ * that connects back to the server over a WebSocket on the same port. When a
+ * file changes, connected pages reload if they use it; changed stylesheets are
+ * swapped in place without a reload.
+ *
+ * Requests must name the server as 127.0.0.1 or localhost in their Host header,
+ * and live reload connections must come from a page of the server, so a site
+ * whose host name is rebound to the loopback address cannot read the folder.
+ */
+class DevServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** @brief Looks up the unsaved contents of an open file. */
+    using BufferProvider = PreviewSchemeHandler::BufferProvider;
+
+    /**
+     * @brief Constructs a DevServer with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit DevServer(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the DevServer, closing all connections.
+     */
+    ~DevServer() override;
+
+    /**
+     * @brief Starts serving a folder, restarting the server if needed.
+     *
+     * @param rootPath The folder to serve.
+     * @return True if the server is listening.
+     */
+    bool start(const QString &rootPath);
+
+    /**
+     * @brief Stops the server and closes all connections.
+     */
+    void stop();
+
+    /** @return True if the server is listening. */
+    bool isRunning() const;
+
+    /** @return The canonical path of the folder being served. */
+    QString rootPath() const { return m_rootPath; }
+
+    /** @return The port the server listens on, or 0 when stopped. */
+    quint16 port() const;
+
+    /**
+     * @brief Checks whether a file lies inside the served folder.
+     *
+     * @param filePath The file path.
+     * @return True if the file can be served.
+     */
+    bool contains(const QString &filePath) const;
+
+    /**
+     * @brief Builds the http:// URL under which a file is served.
+     *
+     * @param filePath The file path.
+     * @return The URL, or an empty URL if the file is not served.
+     */
+    QUrl urlForFile(const QString &filePath) const;
+
+    /**
+     * @brief Sets the callback used to find unsaved editor contents.
+     *
+     * @param provider The buffer lookup callback.
+     */
+    void setBufferProvider(BufferProvider provider);
+
+public slots:
+    /**
+     * @brief Tells connected browsers that a file has changed.
+     *
+     * @param filePath The file that changed.
+     */
+    void notifyFileChanged(const QString &filePath);
+
+signals:
+    /**
+     * @brief Emitted when a browser connects to or disconnects from live reload.
+     *
+     * @param count The number of connected browsers.
+     */
+    void clientCountChanged(int count);
+
+private slots:
+    void acceptConnection();
+    void acceptClient();
+
+private:
+    class Connection;
+
+    /**
+     * @brief Checks the Host header of a request.
+     *
+     * @param host The value of the header.
+     * @return True if the request is addressed to this server by loopback address or localhost.
+     */
+    bool isAllowedHost(const QByteArray &host) const;
+
+    /**
+     * @brief Checks the Origin header of a live reload connection.
+     *
+     * @param origin The value of the header.
+     * @return True if the connection comes from a page served by this server.
+     */
+    bool isAllowedOrigin(const QByteArray &origin) const;
+
+    /**
+     * @brief Maps the path of a request to a file in the served folder.
+     *
+     * @param requestPath The decoded path of the request URL.
+     * @return The local file path, or an empty string if it lies outside the folder.
+     */
+    QString localPathFor(const QString &requestPath) const;
+
+    QTcpServer *m_httpServer = nullptr;         /**< Accepts HTTP connections. */
+    QWebSocketServer *m_socketServer = nullptr; /**< Upgrades live reload connections. */
+    QList<Connection*> m_connections;           /**< Open HTTP connections. */
+    QList<QWebSocket*> m_clients;               /**< Browsers listening for changes. */
+    QString m_rootPath;                         /**< Canonical path of the served folder. */
+    BufferProvider m_bufferProvider;            /**< Finds unsaved contents of open files. */
+};
+
+#endif // DEVSERVER_H
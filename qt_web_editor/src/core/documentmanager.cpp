@@ -0,0 +1,210 @@
+/**
+ * @file documentmanager.cpp
+ * @brief Implementation of the Document and DocumentManager classes.
+ *
+ * This file contains the indexing of open files by canonical path and file
+ * identity, and the reference counting of the views showing them.
+ */
+
+#include "documentmanager.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QWidget>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Gets the identity of a file.
+ *
+ * @param filePath The file.
+ * @return Its identity, invalid if it does not exist or the system has none.
+ */
+FileId FileId::of(const QString &filePath)
+{
+    FileId id;
+#ifdef Q_OS_UNIX
+    struct stat info;
+    if (::stat(QFile::encodeName(filePath).constData(), &info) == 0) {
+        id.device = quint64(info.st_dev);
+        id.inode = quint64(info.st_ino);
+    }
+#else
+    Q_UNUSED(filePath);
+#endif
+    return id;
+}
+
+/**
+ * @brief Constructs a document for a file.
+ *
+ * @param filePath The file.
+ * @param parent The manager owning the document.
+ */
+Document::Document(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+{
+}
+
+/**
+ * @brief Constructs an empty DocumentManager.
+ *
+ * @param parent The parent QObject.
+ */
+DocumentManager::DocumentManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Gets the path a file is indexed under.
+ *
+ * @param filePath The file.
+ * @return The file with symbolic links resolved, or its absolute path if it does not exist.
+ */
+QString DocumentManager::canonicalPath(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    const QString canonical = info.canonicalFilePath();
+    return canonical.isEmpty() ? QDir::cleanPath(info.absoluteFilePath()) : canonical;
+}
+
+/**
+ * @brief Finds the document of a file.
+ *
+ * The canonical path is looked up first. Failing that, the identity of the
+ * file is; an identity match is only trusted if the document's own file still
+ * has it, since a replaced file frees its inode for reuse.
+ *
+ * @param filePath The file, by any path naming it.
+ * @return The document, or nullptr if the file is not open.
+ */
+Document *DocumentManager::find(const QString &filePath) const
+{
+    if (filePath.isEmpty()) {
+        return nullptr;
+    }
+    if (Document *document = m_byPath.value(canonicalPath(filePath))) {
+        return document;
+    }
+
+    const FileId id = FileId::of(filePath);
+    if (!id.isValid()) {
+        return nullptr;
+    }
+    Document *document = m_byId.value(id);
+    return document && FileId::of(document->m_filePath) == id ? document : nullptr;
+}
+
+/**
+ * @brief Lists the open documents.
+ *
+ * @return The documents, in no particular order.
+ */
+QList<Document*> DocumentManager::documents() const
+{
+    return findChildren<Document*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+/**
+ * @brief Attaches a view to the document of a file, opening it if needed.
+ *
+ * The view is detached again when it is destroyed.
+ *
+ * @param view The view.
+ * @param filePath The file, empty to only detach the view.
+ * @return The document, or nullptr for an empty path.
+ */
+Document *DocumentManager::attach(QWidget *view, const QString &filePath)
+{
+    Document *document = find(filePath);
+    Document *previous = m_viewDocuments.value(view);
+    if (previous && previous == document) {
+        return document;
+    }
+    if (previous) {
+        detach(view);
+    }
+    if (filePath.isEmpty()) {
+        return nullptr;
+    }
+
+    if (!document) {
+        document = new Document(filePath, this);
+        index(document);
+    }
+    document->m_views.append(view);
+    m_viewDocuments.insert(view, document);
+    connect(view, &QObject::destroyed, this, [this, view]() { detach(view); });
+    return document;
+}
+
+/**
+ * @brief Detaches a view from its document, dropping the document if it was the last view.
+ *
+ * @param view The view.
+ */
+void DocumentManager::detach(QWidget *view)
+{
+    Document *document = m_viewDocuments.take(view);
+    if (!document) {
+        return;
+    }
+    disconnect(view, &QObject::destroyed, this, nullptr);
+
+    document->m_views.removeOne(view);
+    if (document->m_views.isEmpty()) {
+        const QString filePath = document->m_filePath;
+        unindex(document);
+        delete document;
+        emit documentClosed(filePath);
+    }
+}
+
+/**
+ * @brief Indexes a document again after its file was replaced.
+ *
+ * @param document The document.
+ */
+void DocumentManager::refresh(Document *document)
+{
+    unindex(document);
+    index(document);
+}
+
+/**
+ * @brief Adds a document to the indexes.
+ *
+ * A document indexed later under the same key, such as a file saved over
+ * another open one, takes the key.
+ *
+ * @param document The document.
+ */
+void DocumentManager::index(Document *document)
+{
+    document->m_canonicalPath = canonicalPath(document->m_filePath);
+    document->m_fileId = FileId::of(document->m_filePath);
+    m_byPath.insert(document->m_canonicalPath, document);
+    if (document->m_fileId.isValid()) {
+        m_byId.insert(document->m_fileId, document);
+    }
+}
+
+/**
+ * @brief Removes a document from the indexes.
+ *
+ * @param document The document.
+ */
+void DocumentManager::unindex(Document *document)
+{
+    if (m_byPath.value(document->m_canonicalPath) == document) {
+        m_byPath.remove(document->m_canonicalPath);
+    }
+    if (m_byId.value(document->m_fileId) == document) {
+        m_byId.remove(document->m_fileId);
+    }
+}
@@ -0,0 +1,209 @@
+/**
+ * @file documentmanager.h
+ * @brief Declaration of the Document and DocumentManager classes.
+ *
+ * This file contains the DocumentManager class which keeps a registry of the
+ * open files, independent of the tabs and views that show them.
+ */
+
+#ifndef DOCUMENTMANAGER_H
+#define DOCUMENTMANAGER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QWidget;
+
+/**
+ * @brief Identity of a file on disk: its device and inode.
+ *
+ * Two paths naming the same file, through a hard link or a case-insensitive
+ * file system, share it. Only POSIX systems provide one; elsewhere it is
+ * always invalid and files are told apart by their canonical path alone.
+ */
+struct FileId
+{
+    quint64 device = 0;  /**< Device holding the file. */
+    quint64 inode = 0;   /**< Inode of the file on its device. */
+
+    /** @return True if the file exists and has an identity. */
+    bool isValid() const { return inode != 0; }
+
+    /**
+     * @brief Gets the identity of a file.
+     *
+     * @param filePath The file.
+     * @return Its identity, invalid if it does not exist or the system has none.
+     */
+    static FileId of(const QString &filePath);
+
+    friend bool operator==(const FileId &a, const FileId &b)
+    {
+        return a.device == b.device && a.inode == b.inode;
+    }
+    friend bool operator!=(const FileId &a, const FileId &b) { return !(a == b); }
+};
+
+/**
+ * @brief Hashes a file identity.
+ *
+ * @param id The identity.
+ * @param seed The hash seed.
+ * @return The hash.
+ */
+inline size_t qHash(const FileId &id, size_t seed = 0)
+{
+    return ::qHash(id.device, seed) ^ ::qHash(id.inode, seed);
+}
+
+/**
+ * @brief The Document class is an open file, shared by the views showing it.
+ *
+ * A document lives as long as at least one view refers to it: an editor, a
+ * read-only view of a huge file, or the placeholder of a tab not loaded yet.
+ * The first view is its primary one, which holds the text.
+ */
+class Document : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** @return The file, as it was opened or last saved as. */
+    QString filePath() const { return m_filePath; }
+
+    /** @return The file with symbolic links resolved, or its absolute path if it does not exist. */
+    QString canonicalPath() const { return m_canonicalPath; }
+
+    /** @return The identity of the file when it was last indexed. */
+    FileId fileId() const { return m_fileId; }
+
+    /** @return The views showing the document, the primary one first. */
+    QList<QWidget*> views() const { return m_views; }
+
+    /** @return The view holding the text. */
+    QWidget *primaryView() const { return m_views.value(0); }
+
+private:
+    friend class DocumentManager;
+
+    /**
+     * @brief Constructs a document for a file.
+     *
+     * @param filePath The file.
+     * @param parent The manager owning the document.
+     */
+    Document(const QString &filePath, QObject *parent);
+
+    QString m_filePath;       /**< The file. */
+    QString m_canonicalPath;  /**< Key of the document in the path index. */
+    FileId m_fileId;          /**< Key of the document in the identity index. */
+    QList<QWidget*> m_views;  /**< Views referring to the document. */
+};
+
+/**
+ * @brief The DocumentManager class keeps the registry of open documents.
+ *
+ * Documents are indexed by canonical path and by file identity, so a file
+ * opened through a symbolic link, a relative path or a hard link is found
+ * as the document already open, in constant time rather than by walking the
+ * tabs. Views attach to the document of their file and detach when they are
+ * destroyed or move to another file; a document without views is dropped.
+ *
+ * Atomic saves replace a file by a new one, with a new identity; refresh()
+ * indexes the document again after a save.
+ */
+class DocumentManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs an empty DocumentManager.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit DocumentManager(QObject *parent = nullptr);
+
+    /**
+     * @brief Gets the path a file is indexed under.
+     *
+     * @param filePath The file.
+     * @return The file with symbolic links resolved, or its absolute path if it does not exist.
+     */
+    static QString canonicalPath(const QString &filePath);
+
+    /**
+     * @brief Finds the document of a file.
+     *
+     * @param filePath The file, by any path naming it.
+     * @return The document, or nullptr if the file is not open.
+     */
+    Document *find(const QString &filePath) const;
+
+    /**
+     * @brief Gets the document a view shows.
+     *
+     * @param view The view.
+     * @return The document, or nullptr for a view of no file.
+     */
+    Document *documentOf(QWidget *view) const { return m_viewDocuments.value(view); }
+
+    /** @return The open documents. */
+    QList<Document*> documents() const;
+
+    /**
+     * @brief Attaches a view to the document of a file, opening it if needed.
+     *
+     * A view attached to another document is detached from it first.
+     *
+     * @param view The view.
+     * @param filePath The file, empty to only detach the view.
+     * @return The document, or nullptr for an empty path.
+     */
+    Document *attach(QWidget *view, const QString &filePath);
+
+    /**
+     * @brief Detaches a view from its document, dropping the document if it was the last view.
+     *
+     * @param view The view.
+     */
+    void detach(QWidget *view);
+
+    /**
+     * @brief Indexes a document again after its file was replaced.
+     *
+     * @param document The document.
+     */
+    void refresh(Document *document);
+
+signals:
+    /**
+     * @brief Emitted when the last view of a document is detached.
+     *
+     * @param filePath The file of the document.
+     */
+    void documentClosed(const QString &filePath);
+
+private:
+    /**
+     * @brief Adds a document to the indexes.
+     *
+     * @param document The document.
+     */
+    void index(Document *document);
+
+    /**
+     * @brief Removes a document from the indexes.
+     *
+     * @param document The document.
+     */
+    void unindex(Document *document);
+
+    QHash<QString, Document*> m_byPath;        /**< Documents by canonical path. */
+    QHash<FileId, Document*> m_byId;           /**< Documents by file identity. */
+    QHash<QWidget*, Document*> m_viewDocuments; /**< Document of each attached view. */
+};
+
+#endif // DOCUMENTMANAGER_H
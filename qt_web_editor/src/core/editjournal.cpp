@@ -0,0 +1,519 @@
+/**
+ * @file editjournal.cpp
+ * @brief Implementation of the EditJournal class.
+ *
+ * This file contains the recording and batching of edits, the journal file
+ * format written on the background thread, and the replay of journals left
+ * behind by a crash.
+ */
+
+#include "editjournal.h"
+#include "../utils/textdecoder.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUuid>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+/** First bytes of a journal file, "RJNL". */
+constexpr quint32 kMagic = 0x524A4E4C;
+/** Version of the journal format. */
+constexpr quint32 kVersion = 1;
+/** Record of an edit: position, length removed and text inserted. */
+constexpr quint8 kEditRecord = 1;
+/** Record of the whole text. */
+constexpr quint8 kTextRecord = 2;
+/** Delay before recorded edits are written. */
+constexpr int kFlushDelayMs = 500;
+/** Size of edit records beyond which the journal may be compacted. */
+constexpr qint64 kCompactionBytes = 1024 * 1024;
+
+/**
+ * @brief Returns the directory holding the journal directories of all instances.
+ */
+QString journalRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/journal");
+}
+
+/**
+ * @brief Returns the name of the lock file held by the instance owning a journal directory.
+ */
+QString lockFilePath(const QString &directory)
+{
+    return directory + QStringLiteral("/instance.lock");
+}
+
+/**
+ * @brief The journal directory of this instance and its lock.
+ */
+struct Session
+{
+    QString directory;                /**< The directory, empty if it could not be created. */
+    std::unique_ptr<QLockFile> lock;  /**< Held while the instance runs. */
+};
+
+/**
+ * @brief Returns the journal directory of this instance, creating and locking it on first use.
+ */
+Session &session()
+{
+    static Session session = []() {
+        Session session;
+        const QString directory = journalRoot() + QLatin1Char('/')
+            + QUuid::createUuid().toString(QUuid::WithoutBraces);
+        if (QDir().mkpath(directory)) {
+            session.lock = std::make_unique<QLockFile>(lockFilePath(directory));
+            if (session.lock->tryLock(0)) {
+                session.directory = directory;
+            }
+        }
+        if (session.directory.isEmpty()) {
+            qWarning() << "EditJournal: could not create" << directory << "- unsaved edits are not journaled";
+        }
+        return session;
+    }();
+    return session;
+}
+
+/**
+ * @brief Returns the thread pool the journals are written on.
+ *
+ * It has a single thread, so the writes to a journal happen in the order they
+ * were requested. It belongs to the application, which waits for the last
+ * writes when it quits.
+ */
+QThreadPool *writerPool()
+{
+    static QThreadPool *pool = []() {
+        auto *pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * @brief Hashes a text as it is stored in a journal header.
+ */
+QByteArray hashText(const QByteArray &utf8)
+{
+    return QCryptographicHash::hash(utf8, QCryptographicHash::Sha1);
+}
+}
+
+/**
+ * @brief Constructs an empty journal with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+EditJournal::EditJournal(QObject *parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+}
+
+/**
+ * @brief Destroys the journal and removes its file.
+ *
+ * The edits are no longer needed: the document was saved, or the user chose
+ * not to keep them.
+ */
+EditJournal::~EditJournal()
+{
+    if (m_fileExists) {
+        const QString journalPath = m_journalPath;
+        writerPool()->start([journalPath]() {
+            QFile::remove(journalPath);
+        });
+    }
+}
+
+/**
+ * @brief Starts over from a text with no unsaved edits.
+ *
+ * @param filePath The file holding the text, empty for an untitled document.
+ * @param base The text of the file.
+ */
+void EditJournal::start(const QString &filePath, const TextSnapshot &base)
+{
+    m_filePath = filePath;
+    m_base = base;
+    m_records.clear();
+    m_recordBytes = 0;
+    m_written = 0;
+    m_rewrite = true;
+    if (m_fileExists) {
+        scheduleFlush();
+    }
+}
+
+/**
+ * @brief Records an edit.
+ *
+ * @param revision Revision of the text after the edit.
+ * @param position Where the edit starts, in UTF-16 code units.
+ * @param removed Number of UTF-16 code units removed.
+ * @param text The text inserted.
+ */
+void EditJournal::recordEdit(quint64 revision, qint64 position, qint64 removed, QStringView text)
+{
+    Record record;
+    record.revision = revision;
+    QDataStream out(&record.data, QIODevice::WriteOnly);
+    out << kEditRecord << position << removed << text.toUtf8();
+
+    m_recordBytes += record.data.size();
+    m_records.append(record);
+    scheduleFlush();
+}
+
+/**
+ * @brief Records the whole text, replacing the records before it.
+ *
+ * Used to compact the journal, and when the text no longer derives from the
+ * base by recorded edits. The text is encoded when it is written.
+ *
+ * @param text The text.
+ */
+void EditJournal::recordText(const TextSnapshot &text)
+{
+    Record record;
+    record.revision = text.revision();
+    record.text = text;
+
+    m_records = {record};
+    m_recordBytes = 0;
+    m_written = 0;
+    m_rewrite = true;
+    scheduleFlush();
+}
+
+/**
+ * @brief Checks whether the recorded edits have grown past the text.
+ *
+ * @param textSize Size of the text in bytes.
+ * @return True if recordText() would make the journal smaller.
+ */
+bool EditJournal::isCompactionDue(qint64 textSize) const
+{
+    return m_recordBytes > kCompactionBytes && m_recordBytes > textSize;
+}
+
+/**
+ * @brief Takes a saved text as the new base, dropping the edits it holds.
+ *
+ * Edits made while the file was being written are kept. Without them the
+ * journal file is removed.
+ *
+ * @param filePath The file written.
+ * @param base The text written; edits of a later revision are kept.
+ */
+void EditJournal::rebase(const QString &filePath, const TextSnapshot &base)
+{
+    m_filePath = filePath;
+    m_base = base;
+    m_records.erase(std::remove_if(m_records.begin(), m_records.end(), [&base](const Record &record) {
+        return record.revision <= base.revision();
+    }), m_records.end());
+
+    m_recordBytes = 0;
+    for (const Record &record : qAsConst(m_records)) {
+        m_recordBytes += record.data.size();
+    }
+    m_written = 0;
+    m_rewrite = true;
+    if (m_fileExists || !m_records.isEmpty()) {
+        scheduleFlush();
+    }
+}
+
+/**
+ * @brief Makes sure the records are written within the flush delay.
+ *
+ * The delay is not restarted by further edits, so continuous typing is still
+ * written twice a second.
+ */
+void EditJournal::scheduleFlush()
+{
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+/**
+ * @brief Hands the records not yet written to the background thread.
+ *
+ * New records are appended to the file. After start(), rebase() or
+ * recordText() the file is written again from the header, or removed if no
+ * record is left.
+ */
+void EditJournal::flush()
+{
+    m_flushTimer->stop();
+
+    if (m_records.isEmpty()) {
+        if (m_fileExists) {
+            const QString journalPath = m_journalPath;
+            writerPool()->start([journalPath]() {
+                QFile::remove(journalPath);
+            });
+            m_fileExists = false;
+        }
+        m_written = 0;
+        m_rewrite = false;
+        return;
+    }
+
+    if (m_journalPath.isEmpty()) {
+        const QString directory = session().directory;
+        if (directory.isEmpty()) {
+            // Nowhere to write; keep memory from growing
+            m_records.clear();
+            m_recordBytes = 0;
+            return;
+        }
+        m_journalPath = directory + QLatin1Char('/')
+            + QUuid::createUuid().toString(QUuid::WithoutBraces) + QStringLiteral(".journal");
+    }
+
+    const bool rewrite = m_rewrite || !m_fileExists;
+    const QVector<Record> records = rewrite ? m_records : m_records.mid(m_written);
+    const QString journalPath = m_journalPath;
+    const QString filePath = m_filePath;
+    const TextSnapshot base = m_base;
+    writerPool()->start([journalPath, rewrite, filePath, base, records]() {
+        write(journalPath, rewrite, filePath, base, records);
+    });
+
+    m_written = m_records.size();
+    m_rewrite = false;
+    m_fileExists = true;
+}
+
+/**
+ * @brief Writes records; runs on the background thread.
+ *
+ * A journal file is a header, holding the file edited and the size and hash
+ * of its base text, followed by records. A rewrite replaces the file
+ * atomically; appends are flushed to the operating system, which keeps them
+ * should the application crash.
+ *
+ * @param journalPath The journal.
+ * @param rewrite True to write the header and the records to a new file, false to append.
+ * @param filePath The file edited.
+ * @param base The base text.
+ * @param records The records to write.
+ */
+void EditJournal::write(const QString &journalPath, bool rewrite, const QString &filePath,
+                        const TextSnapshot &base, const QVector<Record> &records)
+{
+    const auto writeRecords = [&records](QIODevice *device) {
+        QDataStream out(device);
+        for (const Record &record : records) {
+            if (!record.data.isEmpty()) {
+                out.writeRawData(record.data.constData(), record.data.size());
+                continue;
+            }
+            out << kTextRecord << record.text.size();
+            for (int i = 0; i < record.text.pieceCount(); ++i) {
+                const QByteArrayView piece = record.text.piece(i);
+                out.writeRawData(piece.data(), piece.size());
+            }
+        }
+        return out.status() == QDataStream::Ok;
+    };
+
+    if (!rewrite) {
+        QFile file(journalPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || !writeRecords(&file) || !file.flush()) {
+            qWarning() << "EditJournal: could not write" << journalPath << file.errorString();
+        }
+        return;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (int i = 0; i < base.pieceCount(); ++i) {
+        const QByteArrayView piece = base.piece(i);
+        hash.addData(piece.data(), piece.size());
+    }
+
+    QSaveFile file(journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "EditJournal: could not write" << journalPath << file.errorString();
+        return;
+    }
+    QDataStream out(&file);
+    out << kMagic << kVersion << filePath << base.size() << hash.result();
+    if (out.status() != QDataStream::Ok || !writeRecords(&file) || !file.commit()) {
+        qWarning() << "EditJournal: could not write" << journalPath << file.errorString();
+    }
+}
+
+/**
+ * @brief Lists the journals of instances that did not shut down.
+ *
+ * A journal directory whose lock can be taken belongs to an instance that is
+ * no longer running. Such directories without journals are removed.
+ *
+ * @return Paths of the journals.
+ */
+QStringList EditJournal::orphanedJournals()
+{
+    QStringList journals;
+    const QString ownDirectory = session().directory;
+    const QFileInfoList directories = QDir(journalRoot()).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : directories) {
+        const QString directory = entry.absoluteFilePath();
+        if (directory == ownDirectory) {
+            continue;
+        }
+
+        // Another instance holds the lock while it runs
+        QLockFile lock(lockFilePath(directory));
+        lock.setStaleLockTime(0);
+        if (!lock.tryLock(0)) {
+            continue;
+        }
+        const QStringList names = QDir(directory).entryList({QStringLiteral("*.journal")}, QDir::Files, QDir::Time);
+        lock.unlock();
+
+        if (names.isEmpty()) {
+            QDir(directory).removeRecursively();
+            continue;
+        }
+        for (const QString &name : names) {
+            journals.append(directory + QLatin1Char('/') + name);
+        }
+    }
+    return journals;
+}
+
+/**
+ * @brief Replays a journal onto its file.
+ *
+ * The edits are applied to the file as it is now, which must still hold the
+ * base text of the journal, unless the journal starts with the whole text.
+ * A record cut short by the crash ends the replay.
+ *
+ * @param journalPath The journal.
+ * @return The recovered text.
+ */
+EditJournal::Recovery EditJournal::recover(const QString &journalPath)
+{
+    Recovery recovery;
+    recovery.journalPath = journalPath;
+
+    QFile file(journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        recovery.errorString = file.errorString();
+        return recovery;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 baseSize = 0;
+    QByteArray baseHash;
+    in >> magic >> version;
+    if (magic != kMagic || version != kVersion) {
+        recovery.errorString = tr("The journal is damaged or was written by another version");
+        return recovery;
+    }
+    in >> recovery.filePath >> baseSize >> baseHash;
+    if (in.status() != QDataStream::Ok) {
+        recovery.errorString = tr("The journal is damaged or was written by another version");
+        return recovery;
+    }
+
+    if (!recovery.filePath.isEmpty() && QFileInfo::exists(recovery.filePath)) {
+        QFile source(recovery.filePath);
+        if (!source.open(QIODevice::ReadOnly)) {
+            recovery.errorString = source.errorString();
+            return recovery;
+        }
+        recovery.diskText = TextDecoder::decode(source.readAll()).text;
+    }
+
+    QString text = recovery.diskText;
+    bool baseChecked = false;
+    while (true) {
+        quint8 kind = 0;
+        in >> kind;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+
+        if (kind == kTextRecord) {
+            qint64 size = 0;
+            in >> size;
+            if (in.status() != QDataStream::Ok || size < 0 || size > file.size()) {
+                break;
+            }
+            QByteArray bytes(size, Qt::Uninitialized);
+            if (in.readRawData(bytes.data(), size) != size) {
+                break;
+            }
+            text = QString::fromUtf8(bytes);
+            baseChecked = true;
+            continue;
+        }
+        if (kind != kEditRecord) {
+            break;
+        }
+
+        qint64 position = 0;
+        qint64 removed = 0;
+        QByteArray inserted;
+        in >> position >> removed >> inserted;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+
+        // Edits only apply to the text they were made on
+        if (!baseChecked) {
+            const QByteArray utf8 = text.toUtf8();
+            if (utf8.size() != baseSize || hashText(utf8) != baseHash) {
+                recovery.errorString = tr("The file has changed since the edits were made");
+                return recovery;
+            }
+            baseChecked = true;
+        }
+        if (position < 0 || removed < 0 || position + removed > text.size()) {
+            recovery.errorString = tr("The journal is damaged");
+            return recovery;
+        }
+        text.replace(position, removed, QString::fromUtf8(inserted));
+    }
+
+    recovery.text = text;
+    return recovery;
+}
+
+/**
+ * @brief Removes a journal that was recovered or is not wanted.
+ *
+ * The directory of the journal goes with its last journal.
+ *
+ * @param journalPath The journal.
+ */
+void EditJournal::discard(const QString &journalPath)
+{
+    QFile::remove(journalPath);
+    QDir().rmdir(QFileInfo(journalPath).absolutePath());
+}
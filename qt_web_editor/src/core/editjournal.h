@@ -0,0 +1,174 @@
+/**
+ * @file editjournal.h
+ * @brief Declaration of the EditJournal class.
+ *
+ * This file contains the EditJournal class which keeps an append-only log of
+ * the unsaved edits of a document, so they can be recovered after a crash.
+ */
+
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include "../utils/piecetable.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QTimer;
+
+/**
+ * @brief The EditJournal class records the unsaved edits of a document.
+ *
+ * The journal starts from the text of the file as last loaded or saved, its
+ * base, and records every edit made since: where it starts, how much it
+ * removes and what it inserts. Recording an edit costs as much as the edit,
+ * not the document. Edits are batched and appended to the journal file on a
+ * background thread every half second.
+ *
+ * A journal whose edits outgrow the text is compacted into a single record of
+ * the whole text, and saving drops the edits the file now holds. A document
+ * without unsaved edits has no journal file.
+ *
+ * Journal files live in a directory of the running instance, locked while it
+ * runs. Journals left behind by an instance that did not shut down are listed
+ * by orphanedJournals() and replayed onto their file by recover().
+ */
+class EditJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The text recovered from a journal.
+     */
+    struct Recovery
+    {
+        QString journalPath;   /**< The journal. */
+        QString filePath;      /**< The file edited, empty for an untitled document. */
+        QString diskText;      /**< The text the file holds now, empty if it does not exist. */
+        QString text;          /**< The text with the recorded edits. */
+        QString errorString;   /**< Why the edits could not be recovered, empty on success. */
+    };
+
+    /**
+     * @brief Constructs an empty journal with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit EditJournal(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the journal and removes its file.
+     */
+    ~EditJournal() override;
+
+    /**
+     * @brief Starts over from a text with no unsaved edits.
+     *
+     * @param filePath The file holding the text, empty for an untitled document.
+     * @param base The text of the file.
+     */
+    void start(const QString &filePath, const TextSnapshot &base);
+
+    /**
+     * @brief Records an edit.
+     *
+     * @param revision Revision of the text after the edit.
+     * @param position Where the edit starts, in UTF-16 code units.
+     * @param removed Number of UTF-16 code units removed.
+     * @param text The text inserted.
+     */
+    void recordEdit(quint64 revision, qint64 position, qint64 removed, QStringView text);
+
+    /**
+     * @brief Records the whole text, replacing the records before it.
+     *
+     * @param text The text.
+     */
+    void recordText(const TextSnapshot &text);
+
+    /**
+     * @brief Checks whether the recorded edits have grown past the text.
+     *
+     * @param textSize Size of the text in bytes.
+     * @return True if recordText() would make the journal smaller.
+     */
+    bool isCompactionDue(qint64 textSize) const;
+
+    /**
+     * @brief Takes a saved text as the new base, dropping the edits it holds.
+     *
+     * @param filePath The file written.
+     * @param base The text written; edits of a later revision are kept.
+     */
+    void rebase(const QString &filePath, const TextSnapshot &base);
+
+    /**
+     * @brief Hands the records not yet written to the background thread.
+     */
+    void flush();
+
+    /**
+     * @brief Lists the journals of instances that did not shut down.
+     *
+     * @return Paths of the journals.
+     */
+    static QStringList orphanedJournals();
+
+    /**
+     * @brief Replays a journal onto its file.
+     *
+     * @param journalPath The journal.
+     * @return The recovered text.
+     */
+    static Recovery recover(const QString &journalPath);
+
+    /**
+     * @brief Removes a journal that was recovered or is not wanted.
+     *
+     * @param journalPath The journal.
+     */
+    static void discard(const QString &journalPath);
+
+private:
+    /**
+     * @brief An edit, or the whole text, in the form it is written.
+     */
+    struct Record
+    {
+        quint64 revision = 0;  /**< Revision of the text after the record. */
+        QByteArray data;       /**< The encoded edit; empty for a record of the whole text. */
+        TextSnapshot text;     /**< The whole text, encoded when written. */
+    };
+
+    /**
+     * @brief Writes records; runs on the background thread.
+     *
+     * @param journalPath The journal.
+     * @param rewrite True to write the header and the records to a new file, false to append.
+     * @param filePath The file edited.
+     * @param base The base text.
+     * @param records The records to write.
+     */
+    static void write(const QString &journalPath, bool rewrite, const QString &filePath,
+                      const TextSnapshot &base, const QVector<Record> &records);
+
+    /**
+     * @brief Makes sure the records are written within the flush delay.
+     */
+    void scheduleFlush();
+
+    QTimer *m_flushTimer;         /**< Batches records into one write. */
+    QString m_journalPath;        /**< The journal file, chosen when first written. */
+    QString m_filePath;           /**< The file edited. */
+    TextSnapshot m_base;          /**< The text of the file. */
+    QVector<Record> m_records;    /**< Records since the base. */
+    qint64 m_recordBytes = 0;     /**< Size of the edit records. */
+    int m_written = 0;            /**< Number of records handed to the background thread. */
+    bool m_rewrite = false;       /**< Whether the file must be written from the header again. */
+    bool m_fileExists = false;    /**< Whether the journal file has been written. */
+};
+
+#endif // EDITJOURNAL_H
@@ -7,23 +7,40 @@
  */
 
 #include "editorwidget.h"
+#include "fileloader.h"
+#include "filesaver.h"
+#include "editjournal.h"
 #include "../utils/syntaxhighlighter.h"
+#include "../utils/textdecoder.h"
 #include "application.h"
 #include "settings.h"
 
-#include <QDir>
 #include <QFileInfo>
+#include <QFile>
 #include <QPainter>
 #include <QTextBlock>
-#include <QTextStream>
+#include <QTextCursor>
 #include <QFileInfo>
-#include <QMessageBox>
 #include <QApplication>
 #include <QDebug>
 #include <QScrollBar>
 #include <QRegularExpression>
 #include <QStringConverter>
 
+namespace {
+/** Files larger than this are loaded in the background. */
+constexpr qint64 kBackgroundLoadThreshold = 1024 * 1024;
+
+/** Lines longer than this are only highlighted in part; see SyntaxHighlighter. */
+constexpr int kLongLineLength = 10000;
+
+/** Estimated memory of a block beyond its text: block data, layout and highlighting formats. */
+constexpr qint64 kEstimatedBlockBytes = 256;
+
+/** Estimated memory of an undo step beyond the text it holds. */
+constexpr qint64 kEstimatedUndoStepBytes = 128;
+}
+
 /**
  * @brief Constructs an EditorWidget with the given parent.
  * 
@@ -36,6 +53,7 @@ EditorWidget::EditorWidget(QWidget *parent)
     : QPlainTextEdit(parent)
     , m_lineNumberArea(new LineNumberArea(this))
     , m_updateTimer(new QTimer(this))
+    , m_journal(new EditJournal(this))
 {
     setupEditor();
     setupConnections();
@@ -64,6 +82,9 @@ EditorWidget::EditorWidget(QWidget *parent)
     connect(document(), &QTextDocument::contentsChanged, this, [this]() {
         m_updateTimer->start();
     });
+    
+    // Keep the UTF-8 buffer in step with every edit
+    connect(document(), &QTextDocument::contentsChange, this, &EditorWidget::updateBuffer);
 }
 
 /**
@@ -124,16 +145,21 @@ void EditorWidget::setupConnections()
     // Update line number area when scrolled or resized
     connect(this, &EditorWidget::updateRequest, 
             this, &EditorWidget::updateLineNumberArea);
+    
+    // Let the highlighter color what is on screen first
+    connect(this, &EditorWidget::updateRequest, 
+            this, &EditorWidget::updateVisibleBlocks);
 }
 
 /**
  * @brief Loads content from a file into the editor.
  * 
  * Attempts to open and read the specified file, loading its contents into the editor.
- * Sets up appropriate syntax highlighting based on the file extension.
+ * Sets up appropriate syntax highlighting based on the file extension. Files
+ * above a size threshold are loaded in the background instead.
  * 
  * @param filePath Path to the file to load.
- * @return true if the file was loaded successfully, false otherwise.
+ * @return true if the file was loaded or its loading has started, false otherwise.
  */
 bool EditorWidget::load(const QString &filePath)
 {
@@ -141,22 +167,42 @@ bool EditorWidget::load(const QString &filePath)
         return false;
     }
     
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return false;
+    // Drop a background load still in progress; its chunks are ignored from here on
+    if (m_loader) {
+        m_loader->cancel();
+        m_loader->deleteLater();
+        m_loader = nullptr;
+        m_loadProgress = 100;
+        setReadOnly(false);
+        document()->setUndoRedoEnabled(true);
     }
     
-    QTextStream in(&file);
-    in.setAutoDetectUnicode(true);
-    
-    // Set the encoding to UTF-8
-    in.setEncoding(QStringConverter::Utf8);
+    if (QFileInfo(filePath).size() > kBackgroundLoadThreshold) {
+        return loadInBackground(filePath);
+    }
     
-    // Read the content
-    QString content = in.readAll();
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
     
-    // Set the content
-    setPlainText(content);
+    // Detect the encoding and read the content
+    setLoadedContent(filePath, TextDecoder::decode(file.readAll()).text);
+    return true;
+}
+
+/**
+ * @brief Shows the content of a file that was read and decoded elsewhere.
+ * 
+ * @param filePath Path to the file the content came from.
+ * @param text The decoded content of the file.
+ */
+void EditorWidget::setLoadedContent(const QString &filePath, const QString &text)
+{
+    // Set the content; it is not an edit to journal
+    m_settingContent = true;
+    setPlainText(text);
+    m_settingContent = false;
     
     // Set the file path and name
     setFilePath(filePath);
@@ -166,60 +212,316 @@ bool EditorWidget::load(const QString &filePath)
     
     // Mark as unmodified
     document()->setModified(false);
-    
-    return true;
+    m_diskText = m_buffer.snapshot();
+    m_journal->start(filePath, m_diskText);
 }
 
 /**
- * @brief Saves the current content to the current file.
+ * @brief Saves the current content to the current file in the background.
  * 
  * If no file is currently associated with the editor, does nothing.
  * 
- * @return true if the save was successful, false otherwise.
+ * @return true if the save has started, false otherwise.
  * @see saveAs()
  */
 bool EditorWidget::save()
 {
-    if (m_filePath.isEmpty()) {
+    if (m_filePath.isEmpty() || isLoading()) {
         return false;
     }
     return saveAs(m_filePath);
 }
 
 /**
- * @brief Saves the current content to the specified file.
+ * @brief Saves the content to the specified file in the background.
  * 
- * Saves the editor's content to the given file path and updates the editor's
- * state accordingly. Handles file I/O errors and provides user feedback.
+ * The document is snapshotted right away and written on a worker thread, so
+ * editing can go on during the save. saveFinished() reports the outcome; on
+ * success the editor takes the new file path, and is marked unmodified unless
+ * it was edited in the meantime. A save requested while another is running is
+ * started once that one is done.
  * 
  * @param filePath The path where to save the file.
- * @return true if the save was successful, false otherwise.
+ * @return true if the save has started, false otherwise.
  */
 bool EditorWidget::saveAs(const QString &filePath)
 {
-    if (filePath.isEmpty()) {
+    // A partly loaded document must not overwrite the file
+    if (filePath.isEmpty() || isLoading()) {
         return false;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Error"), 
-                           tr("Could not save file %1: %2")
-                           .arg(QDir::toNativeSeparators(filePath), file.errorString()));
-        return false;
+    if (m_saver) {
+        m_pendingSavePath = filePath;
+    } else {
+        startSave(filePath);
+    }
+    return true;
+}
+
+/**
+ * @brief Blocks until saves in progress, including a queued one, have completed.
+ * 
+ * saveFinished() is emitted for each of them before this returns.
+ * 
+ * @return true if the last save succeeded.
+ */
+bool EditorWidget::waitForSaved()
+{
+    while (m_saver) {
+        m_saver->waitForFinished();
     }
+    return m_lastSaveOk;
+}
 
-    // Write content to file with UTF-8 encoding
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);
-    out << toPlainText();
-    file.close();
+/**
+ * @brief Starts writing a snapshot of the document.
+ * 
+ * @param filePath The file to write.
+ */
+void EditorWidget::startSave(const QString &filePath)
+{
+    m_saveRevision = document()->revision();
+    m_savingText = m_buffer.snapshot();
+    m_saver = new FileSaver(this);
+    connect(m_saver, &FileSaver::finished, this, &EditorWidget::finishSave);
+    m_saver->start(filePath, m_savingText, Application::instance()->settings()->saveDurability());
+}
 
-    // Update the file path and mark as unmodified
-    setFilePath(filePath);
-    document()->setModified(false);
+/**
+ * @brief Records the text of the file on disk.
+ * 
+ * The crash recovery journal starts over from it. Unsaved changes that do not
+ * derive from it by recorded edits, as after a merge, are journaled as the
+ * whole text.
+ * 
+ * @param text The text the file now holds.
+ */
+void EditorWidget::setDiskText(const TextSnapshot &text)
+{
+    m_diskText = text;
+    m_journal->start(m_filePath, text);
+    if (isModified()) {
+        m_journal->recordText(m_buffer.snapshot());
+    }
+}
+
+/**
+ * @brief Replaces lines of the text, as a single undoable edit.
+ * 
+ * Edits are applied from the last to the first, so the line numbers of those
+ * still to come stay valid. A line past the end stands for the end of the
+ * document.
+ * 
+ * @param edits The edits, in order, with line numbers of the current text.
+ */
+void EditorWidget::applyLineEdits(const QVector<TextDiff::LineEdit> &edits)
+{
+    if (edits.isEmpty()) {
+        return;
+    }
     
-    return true;
+    const int documentEnd = document()->characterCount() - 1;
+    const auto linePosition = [this, documentEnd](int line) {
+        const QTextBlock block = document()->findBlockByNumber(line);
+        return block.isValid() ? block.position() : documentEnd;
+    };
+    
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    for (auto it = edits.crbegin(); it != edits.crend(); ++it) {
+        cursor.setPosition(linePosition(it->firstLine));
+        cursor.setPosition(linePosition(it->firstLine + it->lineCount), QTextCursor::KeepAnchor);
+        cursor.insertText(it->text);
+    }
+    cursor.endEditBlock();
+}
+
+/**
+ * @brief Estimates the memory the editor holds for its text.
+ * 
+ * @return The estimated size in bytes.
+ */
+qint64 EditorWidget::estimatedMemory() const
+{
+    const QTextDocument *doc = document();
+    return qint64(doc->characterCount()) * 2
+        + m_buffer.size()
+        + qint64(doc->blockCount()) * kEstimatedBlockBytes
+        + qint64(doc->availableUndoSteps()) * kEstimatedUndoStepBytes;
+}
+
+/**
+ * @brief Makes this editor a second view on the document of another editor.
+ * 
+ * The document's layout and the highlighter's formats live in the document,
+ * so they are computed once for all views. Neither view wraps lines, since
+ * the shared layout can only be as wide as one of them. The view reports the
+ * blocks it shows to the shared highlighter, and falls back to an empty
+ * document of its own when the other editor is destroyed.
+ * 
+ * @param source The editor whose document to show, or nullptr to show an empty document.
+ */
+void EditorWidget::showDocumentOf(EditorWidget *source)
+{
+    if (source && source == m_source) {
+        return;
+    }
+    if (m_source) {
+        disconnect(m_source, nullptr, this, nullptr);
+    }
+    disconnect(document(), &QTextDocument::blockCountChanged,
+               this, &EditorWidget::updateLineNumberAreaWidth);
+    if (m_highlighter) {
+        m_highlighter->removeView(this);
+    }
+    
+    m_source = source;
+    if (source) {
+        setDocument(source->document());
+        m_highlighter = source->m_highlighter;
+        m_filePath = source->m_filePath;
+        m_fileName = source->m_fileName;
+        // One layout serves both views, so it cannot wrap at either one's width
+        source->setLineWrapMode(QPlainTextEdit::NoWrap);
+        setLineWrapMode(QPlainTextEdit::NoWrap);
+        watchPendingBlocks();
+        
+        // The document goes with its editor; let go of it first
+        connect(source, &QObject::destroyed, this, [this]() { showDocumentOf(nullptr); });
+        connect(source, &EditorWidget::filePathChanged, this, [this, source]() {
+            m_filePath = source->m_filePath;
+            m_fileName = source->m_fileName;
+            if (m_highlighter && m_highlighter != source->m_highlighter) {
+                m_highlighter->removeView(this);
+            }
+            m_highlighter = source->m_highlighter;
+            watchPendingBlocks();
+            updateVisibleBlocks();
+        });
+    } else {
+        setDocument(nullptr);
+        document()->setDocumentMargin(0);
+        m_highlighter = nullptr;
+        m_filePath.clear();
+        m_fileName.clear();
+    }
+    connect(document(), &QTextDocument::blockCountChanged,
+            this, &EditorWidget::updateLineNumberAreaWidth);
+    
+    updateLineNumberAreaWidth(0);
+    highlightCurrentLine();
+    updateVisibleBlocks();
+}
+
+/**
+ * @brief Applies a change of the document to the UTF-8 buffer.
+ * 
+ * Only the changed range is copied out of the document. Highlighting also
+ * reports changes, with as many characters removed as added and the text
+ * untouched. They leave the document's revision alone, which is how they
+ * are skipped without looking at the text; only while undo is off, as when
+ * a file is being loaded, is the text compared instead. A change that brings
+ * in a line too long to be highlighted as a whole emits longLinesFound().
+ * Edits other than loading a file are recorded in the crash recovery
+ * journal.
+ * 
+ * @param position Where the change starts.
+ * @param charsRemoved Number of characters removed.
+ * @param charsAdded Number of characters added.
+ */
+void EditorWidget::updateBuffer(int position, int charsRemoved, int charsAdded)
+{
+    // Every edit moves the revision, but only while undo is on
+    const bool undoEnabled = document()->isUndoRedoEnabled();
+    if (charsRemoved == charsAdded && undoEnabled && document()->revision() == m_bufferRevision) {
+        return;
+    }
+    m_bufferRevision = document()->revision();
+    
+    // Counts can include the paragraph separator that ends every document
+    const qint64 documentLength = document()->characterCount() - 1;
+    const qint64 removed = qBound<qint64>(0, charsRemoved, m_buffer.length() - position);
+    const qint64 added = qBound<qint64>(0, charsAdded, documentLength - position);
+    
+    QString text;
+    if (added > 0) {
+        QTextCursor cursor(document());
+        cursor.setPosition(position);
+        cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+        text = cursor.selectedText();
+        text.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+        text.replace(QChar::LineSeparator, QLatin1Char('\n'));
+    }
+    
+    if (!undoEnabled && removed == added && m_buffer.text(position, removed) == text) {
+        return;
+    }
+    
+    if (position == 0 && removed == m_buffer.length()) {
+        // The whole text was replaced, as when a file is opened
+        m_buffer.setText(text);
+        m_hasLongLines = false;
+    } else {
+        m_buffer.remove(position, removed);
+        m_buffer.insert(position, text);
+    }
+    
+    Q_ASSERT(m_buffer.length() == documentLength);
+    
+    if (!isLoading() && !m_settingContent) {
+        // Journaling costs as much as the edit; compaction bounds the journal by the text
+        m_journal->recordEdit(m_buffer.revision(), position, removed, text);
+        if (m_journal->isCompactionDue(m_buffer.size())) {
+            m_journal->recordText(m_buffer.snapshot());
+        }
+    }
+    
+    // Only a change adding that many characters can make a line that long
+    if (!m_hasLongLines && added > kLongLineLength) {
+        const QTextBlock last = document()->findBlock(position + added);
+        for (QTextBlock block = document()->findBlock(position); block.isValid(); block = block.next()) {
+            if (block.length() > kLongLineLength) {
+                m_hasLongLines = true;
+                emit longLinesFound();
+                break;
+            }
+            if (block == last) {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Ends a save and starts a queued one.
+ * 
+ * @param ok true if the file was written.
+ */
+void EditorWidget::finishSave(bool ok)
+{
+    FileSaver *saver = m_saver;
+    m_saver = nullptr;
+    saver->deleteLater();
+    m_lastSaveOk = ok;
+
+    const QString filePath = saver->filePath();
+    if (ok) {
+        m_diskText = m_savingText;
+        m_journal->rebase(filePath, m_savingText);
+        // Update the file path and mark as unmodified if nothing changed since the snapshot
+        setFilePath(filePath);
+        if (document()->revision() == m_saveRevision) {
+            document()->setModified(false);
+        }
+    }
+    emit saveFinished(ok, filePath, saver->errorString());
+
+    if (!m_pendingSavePath.isEmpty()) {
+        const QString pendingPath = m_pendingSavePath;
+        m_pendingSavePath.clear();
+        startSave(pendingPath);
+    }
 }
 
 /**
@@ -268,7 +570,9 @@ void EditorWidget::setSyntaxForFile(const QString &filePath)
     // Create or update syntax highlighter
     if (!m_highlighter) {
         m_highlighter = new SyntaxHighlighter(document());
+        watchPendingBlocks();
     }
+    updateVisibleBlocks();
     
     // Set syntax based on file extension
     if (suffix == "cpp" || suffix == "h" || suffix == "hpp" || suffix == "cxx" || suffix == "cc") {
@@ -609,9 +913,15 @@ void EditorWidget::lineNumberAreaPaintEvent(QPaintEvent *event)
     // Draw line numbers for all visible blocks
     while (block.isValid() && top <= event->rect().bottom()) {
         if (block.isVisible() && bottom >= event->rect().top()) {
+            // Mark lines still waiting for the background highlighting pass
+            const bool pending = m_highlighter && m_highlighter->isBlockPending(block);
+            if (pending) {
+                painter.fillRect(0, top, 2, bottom - top, QColor(160, 160, 160));
+            }
+            
             // Convert to 1-based line numbers for display
             QString number = QString::number(blockNumber + 1);
-            painter.setPen(Qt::black);
+            painter.setPen(pending ? QColor(140, 140, 140) : QColor(Qt::black));
             // Draw the line number right-aligned with some right padding
             painter.drawText(0, top, m_lineNumberArea->width() - 3, fontMetrics().height(),
                            Qt::AlignRight, number);
@@ -652,3 +962,131 @@ int EditorWidget::lineNumberAreaWidth() const
     
     return space;
 }
+
+/**
+ * @brief Repaints the line numbers as the highlighter's pending blocks change.
+ */
+void EditorWidget::watchPendingBlocks()
+{
+    if (m_highlighter) {
+        connect(m_highlighter, &SyntaxHighlighter::pendingBlocksChanged,
+                m_lineNumberArea, QOverload<>::of(&QWidget::update), Qt::UniqueConnection);
+    }
+}
+
+/**
+ * @brief Tells the syntax highlighter which blocks are on screen.
+ * 
+ * Large documents are highlighted in the background; the visible blocks are
+ * done first so the user does not wait for the rest of the file.
+ */
+void EditorWidget::updateVisibleBlocks()
+{
+    if (!m_highlighter) {
+        return;
+    }
+    
+    const int firstBlock = firstVisibleBlock().blockNumber();
+    const int visibleLines = viewport()->height() / qMax(1, fontMetrics().height());
+    m_highlighter->setVisibleBlocks(this, firstBlock, firstBlock + visibleLines + 1);
+}
+
+/**
+ * @brief Starts loading a large file in the background.
+ * 
+ * The file is decoded on a worker thread and appended chunk by chunk, so the
+ * first screen shows almost immediately and the editor stays responsive. The
+ * document is read-only and keeps no undo history while it fills up.
+ * 
+ * @param filePath Path to the file to load.
+ * @return true if loading has started.
+ */
+bool EditorWidget::loadInBackground(const QString &filePath)
+{
+    auto *loader = new FileLoader(this);
+    connect(loader, &FileLoader::chunkLoaded, this, [this, loader](const QString &text, bool first) {
+        if (loader == m_loader) {
+            appendLoadedChunk(text, first);
+        }
+    });
+    connect(loader, &FileLoader::progress, this, [this, loader](qint64 bytesRead, qint64 bytesTotal) {
+        if (loader == m_loader) {
+            m_loadProgress = bytesTotal > 0 ? int(bytesRead * 100 / bytesTotal) : 100;
+            emit loadProgressChanged(m_loadProgress);
+        }
+    });
+    connect(loader, &FileLoader::finished, this, [this, loader](bool ok) {
+        if (loader == m_loader) {
+            finishLoad(ok);
+        }
+    });
+    
+    if (!loader->start(filePath)) {
+        delete loader;
+        return false;
+    }
+    
+    m_loader = loader;
+    m_loadProgress = 0;
+    
+    document()->setUndoRedoEnabled(false);
+    setReadOnly(true);
+    clear();
+    setFilePath(filePath);
+    setSyntaxForFile(filePath);
+    
+    emit loadProgressChanged(m_loadProgress);
+    return true;
+}
+
+/**
+ * @brief Appends a chunk of a file being loaded.
+ * 
+ * Text is added at the end of the document without moving the user's cursor
+ * or scroll position.
+ * 
+ * @param text The lines of the chunk.
+ * @param first true for the first chunk of the file.
+ */
+void EditorWidget::appendLoadedChunk(const QString &text, bool first)
+{
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(first ? text : QLatin1Char('\n') + text);
+    
+    // Loaded text matches the file; it is not an edit
+    document()->setModified(false);
+}
+
+/**
+ * @brief Ends a background load.
+ * 
+ * @param ok true if the whole file was loaded.
+ */
+void EditorWidget::finishLoad(bool ok)
+{
+    FileLoader *loader = m_loader;
+    const QString errorString = loader->wasCancelled() ? QString() : loader->errorString();
+    m_loader = nullptr;
+    loader->deleteLater();
+    
+    m_loadProgress = 100;
+    setReadOnly(false);
+    document()->setUndoRedoEnabled(true);
+    document()->setModified(false);
+    m_diskText = m_buffer.snapshot();
+    m_journal->start(m_filePath, m_diskText);
+    highlightCurrentLine();
+    
+    emit loadFinished(ok, errorString);
+}
+
+/**
+ * @brief Cancels a background load; loadFinished() follows with false.
+ */
+void EditorWidget::cancelLoad()
+{
+    if (m_loader) {
+        m_loader->cancel();
+    }
+}
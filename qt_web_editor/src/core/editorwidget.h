@@ -9,6 +9,9 @@
 #ifndef EDITORWIDGET_H
 #define EDITORWIDGET_H
 
+#include "../utils/piecetable.h"
+#include "../utils/textdiff.h"
+
 #include <QPlainTextEdit>
 #include <QPointer>
 #include <QTimer>
@@ -16,6 +19,9 @@
 // Forward declarations
 class QSyntaxHighlighter;
 class SyntaxHighlighter;
+class FileLoader;
+class FileSaver;
+class EditJournal;
 
 /**
  * @class EditorWidget
@@ -43,25 +49,147 @@ public:
     // File operations
     /**
      * @brief Loads content from a file into the editor.
+     * 
+     * Large files are loaded in the background; the editor is read-only until
+     * loadFinished() is emitted.
+     * 
      * @param filePath Path to the file to load.
-     * @return true if the file was loaded successfully, false otherwise.
+     * @return true if the file was loaded or its loading has started, false otherwise.
      */
     bool load(const QString &filePath);
     
     /**
-     * @brief Saves the current content to the current file.
-     * @return true if the save was successful, false otherwise.
+     * @brief Shows the content of a file that was read and decoded elsewhere.
+     * 
+     * @param filePath Path to the file the content came from.
+     * @param text The decoded content of the file.
+     */
+    void setLoadedContent(const QString &filePath, const QString &text);
+    
+    /**
+     * @brief Cancels a background load; loadFinished() follows with false.
+     */
+    void cancelLoad();
+    
+    /**
+     * @brief Checks whether a file is still being loaded in the background.
+     * @return true while loading.
+     */
+    bool isLoading() const { return m_loader != nullptr; }
+    
+    /**
+     * @brief Gets how far a background load has come.
+     * @return The percentage loaded, 100 when no load is in progress.
+     */
+    int loadProgress() const { return m_loadProgress; }
+    
+    /**
+     * @brief Saves the current content to the current file in the background.
+     * @return true if the save has started, false otherwise.
      * @note If no file is associated, this will return false.
+     * @see saveFinished()
      */
     bool save();
     
     /**
-     * @brief Saves the content to a specified file path.
+     * @brief Saves the content to a specified file path in the background.
      * @param filePath The path where to save the file.
-     * @return true if the save was successful, false otherwise.
+     * @return true if the save has started, false otherwise.
+     * @see saveFinished()
      */
     bool saveAs(const QString &filePath);
     
+    /**
+     * @brief Checks whether a save is in progress.
+     * @return true while saving.
+     */
+    bool isSaving() const { return m_saver != nullptr; }
+    
+    /**
+     * @brief Blocks until saves in progress have completed.
+     * @return true if the last save succeeded.
+     */
+    bool waitForSaved();
+    
+    /**
+     * @brief Gets a snapshot of the text as UTF-8, in constant time.
+     * 
+     * The snapshot does not change with later edits and can be read on any thread.
+     * 
+     * @return The current text.
+     */
+    TextSnapshot snapshot() const { return m_buffer.snapshot(); }
+    
+    /**
+     * @brief Gets the revision of the text; it increases with every edit.
+     * @return The revision the next snapshot() will carry.
+     */
+    quint64 revision() const { return m_buffer.revision(); }
+    
+    /**
+     * @brief Gets the text of the file as last loaded or saved.
+     * 
+     * Compared with the file on disk, it tells own saves from external
+     * changes, and serves as the common ancestor when merging them.
+     * 
+     * @return The text of the file, empty for a new document.
+     */
+    TextSnapshot diskText() const { return m_diskText; }
+    
+    /**
+     * @brief Records the text of the file on disk.
+     * 
+     * The crash recovery journal starts over from it.
+     * 
+     * @param text The text the file now holds.
+     */
+    void setDiskText(const TextSnapshot &text);
+    
+    /**
+     * @brief Replaces lines of the text, as a single undoable edit.
+     * 
+     * Only the lines named are touched, so the cursor, the undo history and the
+     * highlighting of the other lines are kept.
+     * 
+     * @param edits The edits, in order, with line numbers of the current text.
+     */
+    void applyLineEdits(const QVector<TextDiff::LineEdit> &edits);
+    
+    /**
+     * @brief Checks whether the text has a line too long to be highlighted as a whole.
+     * @return true if some line is longer than ten thousand characters.
+     */
+    bool hasLongLines() const { return m_hasLongLines; }
+    
+    /**
+     * @brief Estimates the memory the editor holds for its text.
+     * 
+     * Counts the document's UTF-16 text, the UTF-8 buffer, the layout and
+     * formats of each block and the undo history; Qt does not report these,
+     * so the figure is an approximation.
+     * 
+     * @return The estimated size in bytes.
+     */
+    qint64 estimatedMemory() const;
+    
+    /**
+     * @brief Makes this editor a second view on the document of another editor.
+     * 
+     * The view shares the other editor's QTextDocument, and with it the text,
+     * the undo history and the highlighting, while keeping its own cursor,
+     * selection and scroll position. The other editor stays in charge of the
+     * file: loading, saving and the UTF-8 buffer are its alone.
+     * 
+     * @param source The editor whose document to show, or nullptr to show an empty document.
+     */
+    void showDocumentOf(EditorWidget *source);
+    
+    /**
+     * @brief Gets the editor whose document this view shows.
+     * @return The editor, or nullptr if the editor shows its own document.
+     */
+    EditorWidget *sourceEditor() const { return m_source; }
+    
     /**
      * @brief Gets the current file path.
      * @return The path of the currently open file, or an empty string if none.
@@ -99,6 +227,11 @@ signals:
      */
     void filePathChanged(const QString &filePath);
     
+    /**
+     * @brief Emitted when a line too long to be highlighted as a whole is loaded or pasted.
+     */
+    void longLinesFound();
+    
     /**
      * @brief Emitted when the file name changes.
      * @param fileName The new file name.
@@ -109,6 +242,27 @@ signals:
      * @brief Emitted when the content of the document changes.
      */
     void contentChanged();
+    
+    /**
+     * @brief Emitted while a large file is loaded in the background.
+     * @param percent The percentage loaded.
+     */
+    void loadProgressChanged(int percent);
+    
+    /**
+     * @brief Emitted when a background load has ended.
+     * @param ok true if the whole file was loaded, false on error or cancellation.
+     * @param errorString A description of the error, empty if cancelled or successful.
+     */
+    void loadFinished(bool ok, const QString &errorString);
+    
+    /**
+     * @brief Emitted when a save has ended.
+     * @param ok true if the file was written.
+     * @param filePath The file that was saved.
+     * @param errorString A description of the error, empty on success.
+     */
+    void saveFinished(bool ok, const QString &filePath, const QString &errorString);
 
 public slots:
     /**
@@ -158,6 +312,20 @@ private:
     QString m_filePath;  ///< Current file path
     QString m_fileName;  ///< Current file name
     QTimer *m_updateTimer;  ///< Timer for delayed updates
+    FileLoader *m_loader = nullptr;  ///< Background loader of a large file
+    int m_loadProgress = 100;  ///< Percentage of the file loaded
+    FileSaver *m_saver = nullptr;  ///< Save in progress
+    int m_saveRevision = 0;  ///< Document revision the save in progress was taken from
+    QString m_pendingSavePath;  ///< File to save again once the save in progress is done
+    bool m_lastSaveOk = true;  ///< Result of the last save
+    PieceTable m_buffer;  ///< UTF-8 copy of the text, kept in step with the document
+    int m_bufferRevision = 0;  ///< Document revision m_buffer was last brought up to
+    TextSnapshot m_diskText;  ///< Text of the file as last loaded or saved
+    TextSnapshot m_savingText;  ///< Text being written by the save in progress
+    EditJournal *m_journal;  ///< Unsaved edits, for recovery after a crash
+    bool m_settingContent = false;  ///< Whether the text is being replaced by a file's
+    bool m_hasLongLines = false;  ///< Whether some line is longer than kLongLineLength
+    QPointer<EditorWidget> m_source;  ///< Editor whose document this view shows
     
     /**
      * @brief Initializes editor settings and appearance.
@@ -185,6 +353,56 @@ private:
      * @param event The paint event.
      */
     void lineNumberAreaPaintEvent(QPaintEvent *event);
+    
+    /**
+     * @brief Repaints the line numbers as the highlighter's pending blocks change.
+     */
+    void watchPendingBlocks();
+    
+    /**
+     * @brief Tells the syntax highlighter which blocks are on screen.
+     */
+    void updateVisibleBlocks();
+    
+    /**
+     * @brief Starts loading a large file in the background.
+     * @param filePath Path to the file to load.
+     * @return true if loading has started.
+     */
+    bool loadInBackground(const QString &filePath);
+    
+    /**
+     * @brief Appends a chunk of a file being loaded.
+     * @param text The lines of the chunk.
+     * @param first true for the first chunk of the file.
+     */
+    void appendLoadedChunk(const QString &text, bool first);
+    
+    /**
+     * @brief Ends a background load.
+     * @param ok true if the whole file was loaded.
+     */
+    void finishLoad(bool ok);
+    
+    /**
+     * @brief Applies a change of the document to the UTF-8 buffer.
+     * @param position Where the change starts.
+     * @param charsRemoved Number of characters removed.
+     * @param charsAdded Number of characters added.
+     */
+    void updateBuffer(int position, int charsRemoved, int charsAdded);
+    
+    /**
+     * @brief Starts writing a snapshot of the document.
+     * @param filePath The file to write.
+     */
+    void startSave(const QString &filePath);
+    
+    /**
+     * @brief Ends a save.
+     * @param ok true if the file was written.
+     */
+    void finishSave(bool ok);
 };
 
 /**
@@ -0,0 +1,260 @@
+/**
+ * @file fileloader.cpp
+ * @brief Implementation of the FileLoader class.
+ *
+ * This file contains the worker that maps, decodes and splits a file, and the
+ * hand-over of its chunks to the GUI thread.
+ */
+
+#include "fileloader.h"
+#include "textdecoder.h"
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QStringDecoder>
+#include <QThread>
+
+namespace {
+/** Bytes decoded for the first chunk, kept small so the first screen shows quickly. */
+constexpr qint64 kFirstChunkBytes = 64 * 1024;
+
+/** Bytes mapped and decoded per chunk after the first. */
+constexpr qint64 kChunkBytes = 1024 * 1024;
+
+/** Decoded chunks that may wait for the GUI thread at any time. */
+constexpr int kMaxQueuedChunks = 4;
+
+/** How often a worker waiting for the GUI thread checks for cancellation, in ms. */
+constexpr int kCancelPollMs = 50;
+}
+
+/**
+ * @brief Constructs a FileLoader with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+FileLoader::FileLoader(QObject *parent)
+    : QObject(parent)
+    , m_freeSlots(kMaxQueuedChunks)
+{
+    connect(this, &FileLoader::chunkDecoded, this, &FileLoader::deliverChunk, Qt::QueuedConnection);
+    connect(this, &FileLoader::workerFinished, this, &FileLoader::handleWorkerFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destroys the loader, cancelling a load in progress.
+ *
+ * Chunks still queued for delivery are dropped together with the loader.
+ */
+FileLoader::~FileLoader()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+/**
+ * @brief Starts loading a file.
+ *
+ * A loader loads a single file; create a new one for the next file.
+ *
+ * @param filePath The file to load.
+ * @return True if the file could be opened and loading has started.
+ */
+bool FileLoader::start(const QString &filePath)
+{
+    Q_ASSERT(!m_thread);
+
+    // Report what can be known up front synchronously
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    file.close();
+
+    m_thread = QThread::create([this, filePath]() { run(filePath); });
+    m_thread->setObjectName(QStringLiteral("FileLoader"));
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+/**
+ * @brief Stops a load in progress; finished() follows with @c false.
+ */
+void FileLoader::cancel()
+{
+    m_cancelled = true;
+}
+
+/**
+ * @brief Reads, decodes and splits the file; runs on the worker thread.
+ *
+ * @param filePath The file to load.
+ */
+void FileLoader::run(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit workerFinished(false, file.errorString(), QPrivateSignal());
+        return;
+    }
+
+    const qint64 size = file.size();
+    QStringDecoder decoder(detectEncoding(file, size).constData());
+    QByteArray readBuffer;
+    QString pending;  // Text after the last line break seen so far
+    qint64 offset = 0;
+    qint64 chunkBytes = kFirstChunkBytes;
+
+    while (offset < size) {
+        if (m_cancelled) {
+            emit workerFinished(false, tr("Loading was cancelled"), QPrivateSignal());
+            return;
+        }
+
+        // Map one window at a time so only the part being decoded is resident
+        const qint64 length = qMin(chunkBytes, size - offset);
+        uchar *mapped = file.map(offset, length);
+        QByteArrayView bytes;
+        if (mapped) {
+            bytes = QByteArrayView(mapped, length);
+        } else {
+            // Not every file can be mapped (pipes, some network file systems)
+            if (!file.seek(offset) || (readBuffer = file.read(length)).size() != length) {
+                emit workerFinished(false, file.errorString(), QPrivateSignal());
+                return;
+            }
+            bytes = readBuffer;
+        }
+
+        QString text = decoder.decode(bytes);
+        if (mapped) {
+            file.unmap(mapped);
+        }
+        offset += length;
+
+        // Normalize line endings, including a CRLF split across windows
+        if (pending.endsWith(QLatin1Char('\r')) && text.startsWith(QLatin1Char('\n'))) {
+            pending.chop(1);
+        }
+        text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+        pending += text;
+
+        const qsizetype lastBreak = pending.lastIndexOf(QLatin1Char('\n'));
+        if (lastBreak >= 0) {
+            if (!emitChunk(pending.left(lastBreak))) {
+                emit workerFinished(false, tr("Loading was cancelled"), QPrivateSignal());
+                return;
+            }
+            pending.remove(0, lastBreak + 1);
+            chunkBytes = kChunkBytes;
+        }
+
+        emit progress(offset, size);
+    }
+
+    // The last line, which is empty if the file ends with a line break
+    if (!emitChunk(pending)) {
+        emit workerFinished(false, tr("Loading was cancelled"), QPrivateSignal());
+        return;
+    }
+    emit workerFinished(true, QString(), QPrivateSignal());
+}
+
+/**
+ * @brief Chooses the encoding of the file; runs on the worker thread.
+ *
+ * The file is checked for valid UTF-8 one mapped window at a time, stopping
+ * at the first invalid sequence. A window ending mid-character leaves the
+ * character to the next one.
+ *
+ * @param file The open file.
+ * @param size The size of the file.
+ * @return The name of the encoding. If reading fails or the load is cancelled,
+ *         UTF-8; the decoding pass then reports the failure.
+ */
+QByteArray FileLoader::detectEncoding(QFile &file, qint64 size)
+{
+    QByteArray head;
+    bool validUtf8 = true;
+    qint64 offset = 0;
+    while (offset < size && validUtf8 && !m_cancelled) {
+        const qint64 length = qMin(kChunkBytes, size - offset);
+        uchar *mapped = file.map(offset, length);
+        QByteArray readBuffer;
+        QByteArrayView bytes;
+        if (mapped) {
+            bytes = QByteArrayView(mapped, length);
+        } else {
+            if (!file.seek(offset) || (readBuffer = file.read(length)).size() != length) {
+                break;
+            }
+            bytes = readBuffer;
+        }
+
+        if (offset == 0) {
+            head = bytes.left(kFirstChunkBytes).toByteArray();
+        }
+        const qsizetype complete = offset + length < size
+            ? TextDecoder::completeUtf8Length(bytes) : bytes.size();
+        validUtf8 = TextDecoder::isValidUtf8(bytes.left(complete));
+        if (mapped) {
+            file.unmap(mapped);
+        }
+        // A window never holds less than a whole sequence, so this moves on
+        offset += qMax<qsizetype>(complete, 1);
+    }
+    return TextDecoder::encodingFor(head, validUtf8);
+}
+
+/**
+ * @brief Queues a chunk for the GUI thread once there is room; runs on the worker thread.
+ *
+ * @param text The lines of the chunk.
+ * @return False if the load was cancelled while waiting.
+ */
+bool FileLoader::emitChunk(const QString &text)
+{
+    while (!m_freeSlots.tryAcquire(1, kCancelPollMs)) {
+        if (m_cancelled) {
+            return false;
+        }
+    }
+    emit chunkDecoded(text, QPrivateSignal());
+    return true;
+}
+
+/**
+ * @brief Hands a decoded chunk to the consumers and makes room for the next one.
+ *
+ * @param text The lines of the chunk.
+ */
+void FileLoader::deliverChunk(const QString &text)
+{
+    if (!m_cancelled) {
+        const bool first = m_firstChunk;
+        m_firstChunk = false;
+        emit chunkLoaded(text, first);
+    }
+    m_freeSlots.release();
+}
+
+/**
+ * @brief Joins the worker thread and reports the end of the load.
+ *
+ * @param ok True if the whole file was read.
+ * @param errorString A description of the error, if any.
+ */
+void FileLoader::handleWorkerFinished(bool ok, const QString &errorString)
+{
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_errorString = errorString;
+    emit finished(ok && !m_cancelled);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file fileloader.h
+ * @brief Declaration of the FileLoader class.
+ *
+ * This file contains the FileLoader class which reads and decodes a text file
+ * on a worker thread and hands it to the GUI thread in chunks of whole lines.
+ */
+
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QSemaphore>
+#include <QString>
+
+#include <atomic>
+
+class QFile;
+class QThread;
+
+/**
+ * @brief The FileLoader class loads large text files without blocking the GUI.
+ *
+ * The file is memory-mapped window by window on a worker thread, decoded and
+ * split into chunks that end on a line break. Chunks are delivered on the
+ * thread the loader lives in through chunkLoaded(); the first one is small so
+ * that something can be shown right away. Only a few chunks are ever in flight:
+ * the worker waits until earlier chunks have been delivered, so a slow consumer
+ * does not make the whole file pile up in memory.
+ *
+ * The encoding is chosen as TextDecoder chooses it, whatever the size of the
+ * file: the whole file is checked for valid UTF-8 before decoding starts.
+ *
+ * Line endings are normalized to '\n', as QIODevice::Text would do. A chunk
+ * never contains the line break that separates it from the next one; consumers
+ * join consecutive chunks with a '\n'.
+ */
+class FileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a FileLoader with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit FileLoader(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the loader, cancelling a load in progress.
+     */
+    ~FileLoader() override;
+
+    /**
+     * @brief Starts loading a file.
+     *
+     * @param filePath The file to load.
+     * @return True if the file could be opened and loading has started.
+     */
+    bool start(const QString &filePath);
+
+    /**
+     * @brief Stops a load in progress; finished() follows with @c false.
+     */
+    void cancel();
+
+    /** @return True while a load is in progress. */
+    bool isRunning() const { return m_thread != nullptr; }
+
+    /** @return True if the last load was cancelled. */
+    bool wasCancelled() const { return m_cancelled.load(); }
+
+    /** @return A description of the last error, if any. */
+    QString errorString() const { return m_errorString; }
+
+signals:
+    /**
+     * @brief Delivers the next run of lines.
+     *
+     * @param text The lines, separated by '\n', without a trailing line break.
+     * @param first True for the first chunk of the file.
+     */
+    void chunkLoaded(const QString &text, bool first);
+
+    /**
+     * @brief Reports how much of the file has been read.
+     *
+     * @param bytesRead Number of bytes decoded so far.
+     * @param bytesTotal Size of the file in bytes.
+     */
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+
+    /**
+     * @brief Emitted once the load has ended, after the last chunk.
+     *
+     * @param ok True if the whole file was loaded.
+     */
+    void finished(bool ok);
+
+    /**
+     * @brief Carries a decoded chunk from the worker thread.
+     *
+     * @param text The lines of the chunk.
+     */
+    void chunkDecoded(const QString &text, QPrivateSignal);
+
+    /**
+     * @brief Carries the end of a load from the worker thread.
+     *
+     * @param ok True if the whole file was read.
+     * @param errorString A description of the error, if any.
+     */
+    void workerFinished(bool ok, const QString &errorString, QPrivateSignal);
+
+private:
+    void run(const QString &filePath);
+    QByteArray detectEncoding(QFile &file, qint64 size);
+    bool emitChunk(const QString &text);
+    void deliverChunk(const QString &text);
+    void handleWorkerFinished(bool ok, const QString &errorString);
+
+    QThread *m_thread = nullptr;        /**< Worker thread of the current load. */
+    QSemaphore m_freeSlots;             /**< Chunks that may still be queued. */
+    std::atomic<bool> m_cancelled{false}; /**< Set to stop the worker. */
+    bool m_firstChunk = true;           /**< True until the first chunk is delivered. */
+    QString m_errorString;              /**< Description of the last error. */
+};
+
+#endif // FILELOADER_H
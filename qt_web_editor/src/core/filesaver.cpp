@@ -0,0 +1,172 @@
+/**
+ * @file filesaver.cpp
+ * @brief Implementation of the FileSaver class.
+ *
+ * This file contains the worker that writes a file, and the
+ * hand-over of the result to the GUI thread.
+ */
+
+#include "filesaver.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+/**
+ * @brief Flushes a directory entry to disk, so that a rename in it survives a power loss.
+ *
+ * Only POSIX systems need and support this; elsewhere it does nothing.
+ *
+ * @param dirPath The directory.
+ * @return True if the directory was synced or syncing is not applicable.
+ */
+bool syncDirectory(const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    Q_UNUSED(dirPath);
+    return true;
+#endif
+}
+
+/**
+ * @brief Writes every piece of a text.
+ *
+ * @param device The file.
+ * @param text The text.
+ * @return True if everything was written.
+ */
+bool writePieces(QIODevice *device, const TextSnapshot &text)
+{
+    for (int i = 0; i < text.pieceCount(); ++i) {
+        const QByteArrayView piece = text.piece(i);
+        if (device->write(piece.data(), piece.size()) != piece.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+/**
+ * @brief Constructs a FileSaver with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+FileSaver::FileSaver(QObject *parent)
+    : QObject(parent)
+{
+    connect(this, &FileSaver::workerFinished, this, &FileSaver::handleWorkerFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destroys the saver, waiting for a write in progress to complete.
+ *
+ * A write is never abandoned half way; finished() is not emitted any more.
+ */
+FileSaver::~FileSaver()
+{
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+/**
+ * @brief Starts saving a file.
+ *
+ * @param filePath The file to write.
+ * @param text The contents to write.
+ * @param durability How the file is written.
+ */
+void FileSaver::start(const QString &filePath, const TextSnapshot &text, Durability durability)
+{
+    Q_ASSERT(!m_thread);
+
+    m_filePath = filePath;
+    m_thread = QThread::create([this, filePath, text, durability]() {
+        m_errorString = write(filePath, text, durability);
+        emit workerFinished(QPrivateSignal());
+    });
+    m_thread->setObjectName(QStringLiteral("FileSaver"));
+    m_thread->start();
+}
+
+/**
+ * @brief Blocks until the save has completed; finished() is emitted before returning.
+ *
+ * @return True if the file was written.
+ */
+bool FileSaver::waitForFinished()
+{
+    handleWorkerFinished();
+    return m_errorString.isEmpty();
+}
+
+/**
+ * @brief Writes the file; runs on the worker thread.
+ *
+ * @param filePath The file to write.
+ * @param text The contents to write.
+ * @param durability How the file is written.
+ * @return A description of the error, empty on success.
+ */
+QString FileSaver::write(const QString &filePath, const TextSnapshot &text, Durability durability)
+{
+    if (durability == Durability::Direct) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)
+            || !writePieces(&file, text) || !file.flush()) {
+            return file.errorString();
+        }
+        return QString();
+    }
+
+    // QSaveFile writes a temporary file, syncs it and renames it over the target
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return file.errorString();
+    }
+    if (!writePieces(&file, text)) {
+        const QString errorString = file.errorString();
+        file.cancelWriting();
+        return errorString;
+    }
+    if (!file.commit()) {
+        return file.errorString();
+    }
+
+    if (durability == Durability::Full && !syncDirectory(QFileInfo(filePath).absolutePath())) {
+        return tr("The file was written, but its directory could not be synced to disk");
+    }
+    return QString();
+}
+
+/**
+ * @brief Joins the worker thread and reports the end of the save.
+ */
+void FileSaver::handleWorkerFinished()
+{
+    // Already reported by waitForFinished()
+    if (!m_thread) {
+        return;
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    emit finished(m_errorString.isEmpty());
+}
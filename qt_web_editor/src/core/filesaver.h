@@ -0,0 +1,106 @@
+/**
+ * @file filesaver.h
+ * @brief Declaration of the FileSaver class.
+ *
+ * This file contains the FileSaver class which writes a text file on a worker
+ * thread, replacing the previous contents atomically.
+ */
+
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include "../utils/piecetable.h"
+
+#include <QObject>
+#include <QString>
+
+class QThread;
+
+/**
+ * @brief The FileSaver class saves text files without blocking the GUI.
+ *
+ * The text handed to start() is a TextSnapshot: taking it costs nothing and
+ * later edits do not affect the save. It is already UTF-8, so its pieces are
+ * written as they are on a worker thread, without being copied.
+ *
+ * How hard the write tries to survive a crash or power loss is chosen with a
+ * Durability policy. The atomic policies write to a temporary file next to the
+ * target, flush it to disk and rename it over the target (QSaveFile), so the
+ * file always holds either the old or the new contents.
+ *
+ * A saver saves a single file; create a new one for the next save.
+ */
+class FileSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief How a file is written.
+     */
+    enum class Durability {
+        Direct, /**< Overwrite the file in place; fastest, but a crash can truncate it. */
+        Atomic, /**< Write a synced temporary file and rename it over the target. */
+        Full    /**< As Atomic, and also sync the directory so the rename is on disk. */
+    };
+
+    /**
+     * @brief Constructs a FileSaver with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit FileSaver(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the saver, waiting for a write in progress to complete.
+     */
+    ~FileSaver() override;
+
+    /**
+     * @brief Starts saving a file.
+     *
+     * @param filePath The file to write.
+     * @param text The contents to write.
+     * @param durability How the file is written.
+     */
+    void start(const QString &filePath, const TextSnapshot &text, Durability durability);
+
+    /**
+     * @brief Blocks until the save has completed; finished() is emitted before returning.
+     *
+     * @return True if the file was written.
+     */
+    bool waitForFinished();
+
+    /** @return True while a save is in progress. */
+    bool isRunning() const { return m_thread != nullptr; }
+
+    /** @return The file being or last saved. */
+    QString filePath() const { return m_filePath; }
+
+    /** @return A description of the last error, if any. */
+    QString errorString() const { return m_errorString; }
+
+signals:
+    /**
+     * @brief Emitted once the save has ended.
+     *
+     * @param ok True if the file was written.
+     */
+    void finished(bool ok);
+
+    /**
+     * @brief Carries the end of a save from the worker thread.
+     */
+    void workerFinished(QPrivateSignal);
+
+private:
+    static QString write(const QString &filePath, const TextSnapshot &text, Durability durability);
+    void handleWorkerFinished();
+
+    QThread *m_thread = nullptr;  /**< Worker thread of the current save. */
+    QString m_filePath;           /**< File being saved. */
+    QString m_errorString;        /**< Set by the worker; read once it has been joined. */
+};
+
+#endif // FILESAVER_H
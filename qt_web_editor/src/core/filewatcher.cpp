@@ -0,0 +1,135 @@
+/**
+ * @file filewatcher.cpp
+ * @brief Implementation of the FileWatcher class.
+ *
+ * This file contains the coalescing of file system events and the renewal of
+ * watches that renames and removals end.
+ */
+
+#include "filewatcher.h"
+
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+namespace {
+/** Quiet time after the last event before the changes are reported. */
+constexpr int kSettleDelayMs = 300;
+}
+
+/**
+ * @brief Constructs a FileWatcher with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+FileWatcher::FileWatcher(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_settleTimer(new QTimer(this))
+{
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(kSettleDelayMs);
+    connect(m_settleTimer, &QTimer::timeout, this, &FileWatcher::flush);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &FileWatcher::handleFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &FileWatcher::handleDirectoryChanged);
+}
+
+/**
+ * @brief Sets the files to watch, replacing the previous set.
+ *
+ * Changes already collected for files no longer watched are dropped.
+ *
+ * @param filePaths The files.
+ */
+void FileWatcher::setFiles(const QStringList &filePaths)
+{
+    m_files = QSet<QString>(filePaths.cbegin(), filePaths.cend());
+    m_changed.intersect(m_files);
+    updateWatches();
+}
+
+/**
+ * @brief Records a changed file and restarts the settle delay.
+ *
+ * @param filePath The file.
+ */
+void FileWatcher::handleFileChanged(const QString &filePath)
+{
+    if (!m_files.contains(filePath)) {
+        return;
+    }
+    m_changed.insert(filePath);
+    m_settleTimer->start();
+}
+
+/**
+ * @brief Checks a directory of missing files for files that came back.
+ *
+ * @param dirPath The directory.
+ */
+void FileWatcher::handleDirectoryChanged(const QString &dirPath)
+{
+    const QStringList watched = m_watcher->files();
+    for (const QString &filePath : qAsConst(m_files)) {
+        const QFileInfo info(filePath);
+        if (info.absolutePath() == dirPath && !watched.contains(filePath) && info.exists()) {
+            handleFileChanged(filePath);
+        }
+    }
+}
+
+/**
+ * @brief Reports the files changed during the burst and renews the watches.
+ */
+void FileWatcher::flush()
+{
+    updateWatches();
+    if (m_changed.isEmpty()) {
+        return;
+    }
+    const QStringList changed(m_changed.cbegin(), m_changed.cend());
+    m_changed.clear();
+    emit filesChanged(changed);
+}
+
+/**
+ * @brief Watches every file that exists, and the directories of those that do not.
+ */
+void FileWatcher::updateWatches()
+{
+    QSet<QString> files;
+    QSet<QString> directories;
+    for (const QString &filePath : qAsConst(m_files)) {
+        const QFileInfo info(filePath);
+        if (info.exists()) {
+            files.insert(filePath);
+        } else if (QFileInfo::exists(info.absolutePath())) {
+            directories.insert(info.absolutePath());
+        }
+    }
+
+    // A file renamed over or removed is no longer watched, so it is added again
+    const QStringList watchedFiles = m_watcher->files();
+    const QStringList watchedDirectories = m_watcher->directories();
+    QStringList stale;
+    for (const QString &path : watchedFiles) {
+        if (!files.remove(path)) {
+            stale.append(path);
+        }
+    }
+    for (const QString &path : watchedDirectories) {
+        if (!directories.remove(path)) {
+            stale.append(path);
+        }
+    }
+    if (!stale.isEmpty()) {
+        m_watcher->removePaths(stale);
+    }
+
+    const QStringList added = QStringList(files.cbegin(), files.cend())
+        + QStringList(directories.cbegin(), directories.cend());
+    if (!added.isEmpty()) {
+        m_watcher->addPaths(added);
+    }
+}
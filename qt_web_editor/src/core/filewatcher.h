@@ -0,0 +1,93 @@
+/**
+ * @file filewatcher.h
+ * @brief Declaration of the FileWatcher class.
+ *
+ * This file contains the FileWatcher class which reports changes other
+ * programs make to the open files, one notification per burst of changes.
+ */
+
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief The FileWatcher class watches a set of files for external changes.
+ *
+ * Tools rarely change a file in a single step: a git checkout, a formatter or
+ * a build writes, truncates and renames in quick succession, and every step is
+ * a file system event. Events are collected while they keep coming, and
+ * filesChanged() is emitted once for every file touched when they stop.
+ *
+ * Many tools save by writing a new file and renaming it over the old one,
+ * which ends the watch on the old file; such files are watched again as soon
+ * as the new one is in place. While a file is missing its directory is
+ * watched instead, so that the file is picked up again when it comes back.
+ */
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a FileWatcher with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit FileWatcher(QObject *parent = nullptr);
+
+    /**
+     * @brief Sets the files to watch, replacing the previous set.
+     *
+     * @param filePaths The files.
+     */
+    void setFiles(const QStringList &filePaths);
+
+    /** @return The files being watched. */
+    QStringList files() const { return QStringList(m_files.cbegin(), m_files.cend()); }
+
+signals:
+    /**
+     * @brief Emitted once a burst of changes has settled.
+     *
+     * @param filePaths The files changed, renamed over or removed.
+     */
+    void filesChanged(const QStringList &filePaths);
+
+private:
+    /**
+     * @brief Records a changed file and restarts the settle delay.
+     *
+     * @param filePath The file.
+     */
+    void handleFileChanged(const QString &filePath);
+
+    /**
+     * @brief Checks a directory of missing files for files that came back.
+     *
+     * @param dirPath The directory.
+     */
+    void handleDirectoryChanged(const QString &dirPath);
+
+    /**
+     * @brief Reports the files changed during the burst and renews the watches.
+     */
+    void flush();
+
+    /**
+     * @brief Watches every file that exists, and the directories of those that do not.
+     */
+    void updateWatches();
+
+    QFileSystemWatcher *m_watcher;  /**< The platform watcher (inotify on Linux). */
+    QTimer *m_settleTimer;          /**< Waits for a burst of events to end. */
+    QSet<QString> m_files;          /**< The files to watch. */
+    QSet<QString> m_changed;        /**< The files changed during the current burst. */
+};
+
+#endif // FILEWATCHER_H
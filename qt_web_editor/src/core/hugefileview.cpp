@@ -0,0 +1,671 @@
+/**
+ * @file hugefileview.cpp
+ * @brief Implementation of the HugeFileView class.
+ *
+ * This file contains the mapping and indexing of the file, the search worker
+ * and the virtualized painting of the visible lines.
+ */
+
+#include "hugefileview.h"
+#include "application.h"
+#include "settings.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <iterator>
+
+namespace {
+/** Files at least this large are shown in a HugeFileView instead of an editor. */
+constexpr qint64 kHugeFileBytes = 128 * 1024 * 1024;
+
+/** Bytes indexed between two progress reports. */
+constexpr qint64 kIndexStepBytes = 32 * 1024 * 1024;
+
+/** Bytes searched between two checks for cancellation. */
+constexpr qint64 kSearchStepBytes = 16 * 1024 * 1024;
+
+/** Largest selection copy() puts on the clipboard. */
+constexpr qint64 kMaxCopyBytes = 64 * 1024 * 1024;
+
+/** Space between the line numbers and the text, in pixels. */
+constexpr int kTextMargin = 6;
+
+/** Folds ASCII letters to lower case. */
+inline char foldAscii(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+/** Hash of a byte that ignores ASCII case. */
+struct FoldedHash
+{
+    size_t operator()(char c) const { return std::hash<char>()(foldAscii(c)); }
+};
+
+/** Comparison of bytes that ignores ASCII case. */
+struct FoldedEqual
+{
+    bool operator()(char a, char b) const { return foldAscii(a) == foldAscii(b); }
+};
+
+/**
+ * @brief Finds the first occurrence of a needle with Boyer-Moore-Horspool.
+ *
+ * @return The start of the match, or @p last.
+ */
+template <typename Iterator, typename NeedleIterator>
+Iterator searchRange(Iterator first, Iterator last, NeedleIterator needleFirst, NeedleIterator needleLast,
+                     bool caseSensitive)
+{
+    if (caseSensitive) {
+        return std::search(first, last, std::boyer_moore_horspool_searcher(needleFirst, needleLast));
+    }
+    return std::search(first, last,
+                       std::boyer_moore_horspool_searcher(needleFirst, needleLast, FoldedHash(), FoldedEqual()));
+}
+
+/**
+ * @brief Searches a buffer step by step, so that the search can be stopped.
+ *
+ * Steps overlap by the length of the needle less one, so matches across step
+ * boundaries are found.
+ *
+ * @param data The buffer.
+ * @param limit Bytes of the buffer to search.
+ * @param needle The bytes to find.
+ * @param from Forward: first offset a match may start at. Backward: matches start before it.
+ * @param backward True to find the match closest before @p from.
+ * @param caseSensitive False to ignore ASCII case.
+ * @param stop Set to abandon the search.
+ * @return Offset of the match, or -1.
+ */
+qint64 searchBytes(const char *data, qint64 limit, const QByteArray &needle, qint64 from,
+                   bool backward, bool caseSensitive, const std::atomic<bool> &stop)
+{
+    const qint64 length = needle.size();
+    if (!backward) {
+        for (qint64 begin = from; begin + length <= limit; begin += kSearchStepBytes) {
+            if (stop) {
+                return -1;
+            }
+            const char *end = data + qMin(limit, begin + kSearchStepBytes + length - 1);
+            const char *match = searchRange(data + begin, end, needle.cbegin(), needle.cend(), caseSensitive);
+            if (match != end) {
+                return match - data;
+            }
+        }
+        return -1;
+    }
+
+    // Backward: search the buffer and the needle reversed
+    QByteArray reversed = needle;
+    std::reverse(reversed.begin(), reversed.end());
+    for (qint64 end = qMin(from, limit); end > 0; end -= kSearchStepBytes) {
+        if (stop) {
+            return -1;
+        }
+        const qint64 rangeEnd = qMin(limit, end + length - 1);
+        const auto first = std::make_reverse_iterator(data + rangeEnd);
+        const auto last = std::make_reverse_iterator(data + qMax<qint64>(0, end - kSearchStepBytes));
+        const auto match = searchRange(first, last, reversed.cbegin(), reversed.cend(), caseSensitive);
+        if (match != last) {
+            return rangeEnd - (match - first) - length;
+        }
+    }
+    return -1;
+}
+}
+
+/**
+ * @brief Constructs an empty HugeFileView with the given parent.
+ *
+ * @param parent The parent widget.
+ */
+HugeFileView::HugeFileView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFrameStyle(QFrame::NoFrame);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    viewport()->setCursor(Qt::IBeamCursor);
+    setFont(Application::instance()->settings()->editorFont());
+    updateMetrics();
+
+    connect(this, &HugeFileView::indexed, this, &HugeFileView::handleIndexed, Qt::QueuedConnection);
+    connect(this, &HugeFileView::searchDone, this, &HugeFileView::handleSearchDone, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destroys the view, stopping its worker threads before the file is unmapped.
+ */
+HugeFileView::~HugeFileView()
+{
+    stopSearch();
+    stopIndexing();
+}
+
+/**
+ * @brief Checks whether a file should be shown in a HugeFileView rather than an editor.
+ *
+ * @param filePath The file.
+ * @return True if the file is too large to edit.
+ */
+bool HugeFileView::isHugeFile(const QString &filePath)
+{
+    return QFileInfo(filePath).size() >= kHugeFileBytes;
+}
+
+/**
+ * @brief Maps a file and starts indexing it.
+ *
+ * @param filePath The file to show.
+ * @return True if the file could be mapped.
+ */
+bool HugeFileView::open(const QString &filePath)
+{
+    Q_ASSERT(!m_data);
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size > 0) {
+        m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+        if (!m_data) {
+            m_errorString = tr("The file could not be mapped into memory: %1").arg(m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    }
+    m_filePath = filePath;
+
+    if (m_size > 0) {
+        m_indexThread = QThread::create([this]() { runIndex(); });
+        m_indexThread->setObjectName(QStringLiteral("LineIndexer"));
+        m_indexThread->start(QThread::LowPriority);
+    }
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+/**
+ * @brief Returns the percentage of the file indexed.
+ *
+ * @return A percentage, 100 once indexing is complete.
+ */
+int HugeFileView::indexProgress() const
+{
+    return m_size > 0 ? int(m_index.indexedBytes() * 100 / m_size) : 100;
+}
+
+/**
+ * @brief Scrolls to a line and puts the cursor at its start.
+ *
+ * Lines that have not been indexed yet cannot be reached.
+ *
+ * @param line The line, counted from 0.
+ */
+void HugeFileView::goToLine(qint64 line)
+{
+    if (!m_data) {
+        return;
+    }
+    line = qBound<qint64>(0, line, m_index.lineCount() - 1);
+    m_anchor = m_cursor = m_index.lineStart(m_data, line);
+    verticalScrollBar()->setValue(int(qMin<qint64>(INT_MAX, qMax<qint64>(0, line - visibleRows() / 3))));
+    horizontalScrollBar()->setValue(0);
+    viewport()->update();
+}
+
+/**
+ * @brief Returns the line of the cursor.
+ *
+ * @return The line, counted from 0.
+ */
+qint64 HugeFileView::currentLine() const
+{
+    return m_data ? m_index.lineForOffset(m_data, qMin(m_cursor, m_index.indexedBytes())) : 0;
+}
+
+/**
+ * @brief Starts searching for text from the cursor; searchFinished() reports the result.
+ *
+ * @param text The text to find.
+ * @param options QTextDocument::FindBackward and QTextDocument::FindCaseSensitively.
+ * @return True if the search has started.
+ */
+bool HugeFileView::find(const QString &text, QTextDocument::FindFlags options)
+{
+    const QByteArray needle = text.toUtf8();
+    if (!m_data || needle.isEmpty()) {
+        return false;
+    }
+    stopSearch();
+
+    const bool backward = options.testFlag(QTextDocument::FindBackward);
+    const bool caseSensitive = options.testFlag(QTextDocument::FindCaseSensitively);
+    const qint64 from = backward ? qMin(m_anchor, m_cursor) : qMax(m_anchor, m_cursor);
+    const qint64 limit = m_index.indexedBytes();
+    const quint64 generation = ++m_searchGeneration;
+    m_searchLength = needle.size();
+
+    m_stopSearching = false;
+    m_searchThread = QThread::create([this, limit, needle, from, backward, caseSensitive, generation]() {
+        const qint64 offset = searchBytes(m_data, limit, needle, from, backward, caseSensitive, m_stopSearching);
+        emit searchDone(offset, generation, QPrivateSignal());
+    });
+    m_searchThread->setObjectName(QStringLiteral("HugeFileSearch"));
+    m_searchThread->start();
+    return true;
+}
+
+/**
+ * @brief Copies the selection to the clipboard.
+ *
+ * @return True if something was copied; selections over 64 MB are refused.
+ */
+bool HugeFileView::copy()
+{
+    const qint64 length = qAbs(m_cursor - m_anchor);
+    if (length == 0) {
+        return false;
+    }
+    if (length > kMaxCopyBytes) {
+        QApplication::beep();
+        return false;
+    }
+    QApplication::clipboard()->setText(selectedText());
+    return true;
+}
+
+/**
+ * @brief Returns the selected text, with line endings normalized to '\n'.
+ *
+ * @return The text.
+ */
+QString HugeFileView::selectedText() const
+{
+    if (!m_data) {
+        return QString();
+    }
+    const qint64 start = qMin(m_anchor, m_cursor);
+    QString text = QString::fromUtf8(m_data + start, qMax(m_anchor, m_cursor) - start);
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    return text;
+}
+
+/**
+ * @brief Paints the lines on screen and their numbers.
+ *
+ * Only the columns that fit in the viewport are decoded, so the cost of a
+ * paint does not depend on the length of the lines.
+ *
+ * @param event The paint event.
+ */
+void HugeFileView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QPalette &pal = palette();
+    painter.fillRect(event->rect(), pal.base());
+    painter.fillRect(QRect(0, 0, m_gutterWidth, viewport()->height()), pal.window());
+    if (!m_data) {
+        return;
+    }
+
+    const qint64 first = verticalScrollBar()->value();
+    const qint64 last = qMin(m_index.lineCount(), first + visibleRows() + 1);
+    const qint64 column = horizontalScrollBar()->value();
+    const qint64 columns = visibleColumns() + 1;
+    const qint64 selectionStart = qMin(m_anchor, m_cursor);
+    const qint64 selectionEnd = qMax(m_anchor, m_cursor);
+    const int left = textLeft();
+    const int ascent = fontMetrics().ascent();
+    const QRect textArea(left, 0, viewport()->width() - left, viewport()->height());
+
+    qint64 lineStart = first < last ? m_index.lineStart(m_data, first) : 0;
+    for (qint64 line = first; line < last; ++line) {
+        const int y = int(line - first) * m_lineHeight;
+        const qint64 lineEnd = LineIndex::lineEnd(m_data, m_size, lineStart);
+        const qint64 visibleEnd = displayEnd(lineStart);
+
+        painter.setClipRect(textArea);
+        if (selectionStart < selectionEnd) {
+            const qint64 from = qMax(selectionStart, lineStart);
+            const qint64 to = qMin(selectionEnd, lineEnd + 1);  // The line break counts as a column
+            if (from < to) {
+                const int x1 = left + int(qBound<qint64>(-1, from - lineStart - column, columns)) * m_charWidth;
+                const int x2 = left + int(qBound<qint64>(-1, to - lineStart - column, columns)) * m_charWidth;
+                painter.fillRect(QRect(x1, y, x2 - x1, m_lineHeight), pal.highlight());
+            }
+        }
+
+        // Start at the first visible column, on a character boundary
+        qint64 start = qMin(visibleEnd, lineStart + column);
+        while (start < visibleEnd && (uchar(m_data[start]) & 0xc0) == 0x80) {
+            ++start;
+        }
+        const qint64 end = qMin(visibleEnd, lineStart + column + columns);
+        if (start < end) {
+            QString text = QString::fromUtf8(m_data + start, end - start);
+            text.replace(QLatin1Char('\t'), QLatin1Char(' '));
+            painter.setPen(pal.color(QPalette::Text));
+            painter.drawText(left + int(start - lineStart - column) * m_charWidth, y + ascent, text);
+        }
+
+        painter.setClipping(false);
+        painter.setPen(pal.color(QPalette::PlaceholderText));
+        painter.drawText(QRect(0, y, m_gutterWidth - kTextMargin / 2, m_lineHeight),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(line + 1));
+
+        lineStart = lineEnd + 1;
+    }
+}
+
+/**
+ * @brief Adjusts the scroll bars to the new size.
+ *
+ * @param event The resize event.
+ */
+void HugeFileView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+/**
+ * @brief Recomputes the metrics when the font changes.
+ *
+ * @param event The change event.
+ */
+void HugeFileView::changeEvent(QEvent *event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        updateMetrics();
+        updateScrollBars();
+        viewport()->update();
+    }
+}
+
+/**
+ * @brief Handles copying and jumping to either end; scrolling keys go to the scroll area.
+ *
+ * @param event The key event.
+ */
+void HugeFileView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        copy();
+    } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMinimum);
+    } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMaximum);
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+/**
+ * @brief Places the cursor, extending the selection with Shift.
+ *
+ * @param event The mouse event.
+ */
+void HugeFileView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || !m_data) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    m_cursor = offsetAt(event->position().toPoint());
+    if (!event->modifiers().testFlag(Qt::ShiftModifier)) {
+        m_anchor = m_cursor;
+    }
+    viewport()->update();
+}
+
+/**
+ * @brief Extends the selection while dragging, scrolling at the edges.
+ *
+ * @param event The mouse event.
+ */
+void HugeFileView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!event->buttons().testFlag(Qt::LeftButton) || !m_data) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+    const QPoint pos = event->position().toPoint();
+    if (pos.y() < 0) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    } else if (pos.y() > viewport()->height()) {
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    }
+    m_cursor = offsetAt(pos);
+    viewport()->update();
+}
+
+/**
+ * @brief Repaints after scrolling; nothing is kept from the previous paint.
+ *
+ * @param dx Horizontal scroll distance (unused).
+ * @param dy Vertical scroll distance (unused).
+ */
+void HugeFileView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    viewport()->update();
+}
+
+/**
+ * @brief Builds the line index; runs on the worker thread.
+ */
+void HugeFileView::runIndex()
+{
+    LineIndex::ScanState state;
+    for (qint64 begin = 0; begin < m_size;) {
+        if (m_stopIndexing) {
+            return;
+        }
+        const qint64 end = qMin(m_size, begin + kIndexStepBytes);
+        QVector<qint64> checkpoints;
+        LineIndex::scan(m_data, begin, end, &state, &checkpoints);
+        if (end == m_size) {
+            LineIndex::finish(m_size, &state);
+        }
+        emit indexed(checkpoints, state.lineCount, state.lineStart, state.maxLineLength, end, QPrivateSignal());
+        begin = end;
+    }
+}
+
+/**
+ * @brief Adds a step of the index and makes its lines reachable.
+ */
+void HugeFileView::handleIndexed(const QVector<qint64> &checkpoints, qint64 lineCount, qint64 lineStart,
+                                 qint64 maxLineLength, qint64 indexedBytes)
+{
+    if (m_stopIndexing) {
+        return;
+    }
+
+    LineIndex::ScanState state;
+    state.lineCount = lineCount;
+    state.lineStart = lineStart;
+    state.maxLineLength = maxLineLength;
+    m_index.append(checkpoints, state, indexedBytes);
+
+    updateScrollBars();
+    viewport()->update();
+    emit indexProgressChanged(indexProgress());
+
+    if (indexedBytes == m_size) {
+        m_indexThread->wait();
+        delete m_indexThread;
+        m_indexThread = nullptr;
+        emit indexFinished();
+    }
+}
+
+/**
+ * @brief Selects the match of the current search and reports the result.
+ *
+ * @param offset Offset of the match, or -1.
+ * @param generation The search the result belongs to.
+ */
+void HugeFileView::handleSearchDone(qint64 offset, quint64 generation)
+{
+    if (generation != m_searchGeneration || !m_searchThread) {
+        return;
+    }
+    m_searchThread->wait();
+    delete m_searchThread;
+    m_searchThread = nullptr;
+
+    if (offset >= 0) {
+        m_anchor = offset;
+        m_cursor = offset + m_searchLength;
+        ensureVisible(offset);
+        viewport()->update();
+    }
+    emit searchFinished(offset >= 0);
+}
+
+/**
+ * @brief Stops the index worker and waits for it.
+ */
+void HugeFileView::stopIndexing()
+{
+    m_stopIndexing = true;
+    if (m_indexThread) {
+        m_indexThread->wait();
+        delete m_indexThread;
+        m_indexThread = nullptr;
+    }
+}
+
+/**
+ * @brief Stops the current search and waits for it; its result is dropped.
+ */
+void HugeFileView::stopSearch()
+{
+    m_stopSearching = true;
+    if (m_searchThread) {
+        m_searchThread->wait();
+        delete m_searchThread;
+        m_searchThread = nullptr;
+    }
+}
+
+/**
+ * @brief Measures the font and the line number area.
+ */
+void HugeFileView::updateMetrics()
+{
+    const QFontMetrics metrics = fontMetrics();
+    m_lineHeight = qMax(1, metrics.height());
+    m_charWidth = qMax(1, metrics.horizontalAdvance(QLatin1Char(' ')));
+
+    int digits = 1;
+    for (qint64 max = qMax<qint64>(1, m_index.lineCount()); max >= 10; max /= 10) {
+        ++digits;
+    }
+    m_gutterWidth = kTextMargin + metrics.horizontalAdvance(QLatin1Char('9')) * qMax(digits, 3);
+}
+
+/**
+ * @brief Sets the scroll ranges from the lines indexed and the viewport size.
+ */
+void HugeFileView::updateScrollBars()
+{
+    updateMetrics();
+
+    const int rows = visibleRows();
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setRange(0, int(qBound<qint64>(0, m_index.lineCount() - rows, INT_MAX)));
+
+    const int columns = visibleColumns();
+    horizontalScrollBar()->setPageStep(columns);
+    horizontalScrollBar()->setRange(0, int(qBound<qint64>(0, m_index.maxLineLength() - columns + 1, INT_MAX)));
+}
+
+/**
+ * @brief Scrolls so that a byte is on screen.
+ *
+ * @param offset Offset of the byte.
+ */
+void HugeFileView::ensureVisible(qint64 offset)
+{
+    const qint64 line = m_index.lineForOffset(m_data, qMin(offset, m_index.indexedBytes()));
+    const qint64 first = verticalScrollBar()->value();
+    if (line < first || line >= first + visibleRows()) {
+        verticalScrollBar()->setValue(int(qMin<qint64>(INT_MAX, qMax<qint64>(0, line - visibleRows() / 3))));
+    }
+
+    const qint64 column = offset - m_index.lineStart(m_data, line);
+    const qint64 firstColumn = horizontalScrollBar()->value();
+    if (column < firstColumn || column >= firstColumn + visibleColumns() - 1) {
+        horizontalScrollBar()->setValue(int(qMin<qint64>(INT_MAX, qMax<qint64>(0, column - visibleColumns() / 4))));
+    }
+}
+
+/** @return Number of whole lines that fit in the viewport. */
+int HugeFileView::visibleRows() const
+{
+    return qMax(1, viewport()->height() / m_lineHeight);
+}
+
+/** @return Number of whole columns that fit in the viewport. */
+int HugeFileView::visibleColumns() const
+{
+    return qMax(1, (viewport()->width() - textLeft()) / m_charWidth);
+}
+
+/** @return X coordinate where the text starts. */
+int HugeFileView::textLeft() const
+{
+    return m_gutterWidth + kTextMargin;
+}
+
+/**
+ * @brief Returns where the text of a line ends, before its line break.
+ *
+ * @param lineStart Offset of the line.
+ * @return Offset after the last character shown.
+ */
+qint64 HugeFileView::displayEnd(qint64 lineStart) const
+{
+    qint64 end = LineIndex::lineEnd(m_data, m_size, lineStart);
+    if (end > lineStart && m_data[end - 1] == '\r') {
+        --end;
+    }
+    return end;
+}
+
+/**
+ * @brief Returns the offset of the character boundary closest to a point.
+ *
+ * @param pos The point, in viewport coordinates.
+ * @return The offset.
+ */
+qint64 HugeFileView::offsetAt(const QPoint &pos) const
+{
+    const qint64 line = qBound<qint64>(0, verticalScrollBar()->value() + pos.y() / m_lineHeight,
+                                       m_index.lineCount() - 1);
+    const qint64 lineStart = m_index.lineStart(m_data, line);
+    const qint64 column = horizontalScrollBar()->value()
+        + qMax<qint64>(0, qRound(double(pos.x() - textLeft()) / m_charWidth));
+    return qMin(lineStart + column, displayEnd(lineStart));
+}
@@ -0,0 +1,197 @@
+/**
+ * @file hugefileview.h
+ * @brief Declaration of the HugeFileView class.
+ *
+ * This file contains the HugeFileView class, a read-only viewer for files too
+ * large to be loaded into an editor.
+ */
+
+#ifndef HUGEFILEVIEW_H
+#define HUGEFILEVIEW_H
+
+#include "../utils/lineindex.h"
+
+#include <QAbstractScrollArea>
+#include <QByteArrayView>
+#include <QFile>
+#include <QTextDocument>
+
+#include <atomic>
+
+class QThread;
+
+/**
+ * @brief The HugeFileView class shows a file of any size without loading it.
+ *
+ * The file is memory-mapped and never copied as a whole: a LineIndex of it is
+ * built on a worker thread, and each paint decodes only the lines and columns
+ * that are on screen. Lines become reachable as the index grows, so the start
+ * of the file can be read right away.
+ *
+ * The view supports scrolling, jumping to a line, selecting with the mouse,
+ * copying the selection and searching; searches run on a worker thread over
+ * the raw bytes. Columns are counted in bytes, which matches characters for
+ * ASCII text such as logs and minified bundles, and tabs show as one space.
+ */
+class HugeFileView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs an empty HugeFileView with the given parent.
+     *
+     * @param parent The parent widget.
+     */
+    explicit HugeFileView(QWidget *parent = nullptr);
+
+    /**
+     * @brief Destroys the view, stopping its worker threads.
+     */
+    ~HugeFileView() override;
+
+    /**
+     * @brief Checks whether a file should be shown in a HugeFileView rather than an editor.
+     *
+     * @param filePath The file.
+     * @return True if the file is too large to edit.
+     */
+    static bool isHugeFile(const QString &filePath);
+
+    /**
+     * @brief Maps a file and starts indexing it.
+     *
+     * @param filePath The file to show.
+     * @return True if the file could be mapped.
+     */
+    bool open(const QString &filePath);
+
+    /** @return The file shown. */
+    QString filePath() const { return m_filePath; }
+
+    /** @return A description of the last error, if any. */
+    QString errorString() const { return m_errorString; }
+
+    /** @return The mapped bytes of the file. */
+    QByteArrayView contents() const { return QByteArrayView(m_data, m_size); }
+
+    /** @return Number of lines indexed so far. */
+    qint64 lineCount() const { return m_index.lineCount(); }
+
+    /** @return True while the file is being indexed. */
+    bool isIndexing() const { return m_indexThread != nullptr; }
+
+    /** @return Percentage of the file indexed. */
+    int indexProgress() const;
+
+    /**
+     * @brief Scrolls to a line and puts the cursor at its start.
+     *
+     * @param line The line, counted from 0.
+     */
+    void goToLine(qint64 line);
+
+    /** @return The line of the cursor, counted from 0. */
+    qint64 currentLine() const;
+
+    /**
+     * @brief Starts searching for text from the cursor; searchFinished() reports the result.
+     *
+     * The search covers the part of the file indexed so far. A match is selected.
+     *
+     * @param text The text to find.
+     * @param options QTextDocument::FindBackward and QTextDocument::FindCaseSensitively
+     *        are supported; case folding is limited to ASCII.
+     * @return True if the search has started.
+     */
+    bool find(const QString &text, QTextDocument::FindFlags options = {});
+
+    /**
+     * @brief Copies the selection to the clipboard.
+     *
+     * @return True if something was copied; very large selections are refused.
+     */
+    bool copy();
+
+    /** @return The selected text. */
+    QString selectedText() const;
+
+signals:
+    /**
+     * @brief Emitted while the file is being indexed.
+     *
+     * @param percent The percentage indexed.
+     */
+    void indexProgressChanged(int percent);
+
+    /**
+     * @brief Emitted once the whole file has been indexed.
+     */
+    void indexFinished();
+
+    /**
+     * @brief Emitted when a search has ended.
+     *
+     * @param found True if a match was found and selected.
+     */
+    void searchFinished(bool found);
+
+    /**
+     * @brief Carries a step of the index from the worker thread.
+     */
+    void indexed(const QVector<qint64> &checkpoints, qint64 lineCount, qint64 lineStart,
+                 qint64 maxLineLength, qint64 indexedBytes, QPrivateSignal);
+
+    /**
+     * @brief Carries the result of a search from the worker thread.
+     */
+    void searchDone(qint64 offset, quint64 generation, QPrivateSignal);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    void runIndex();
+    void handleIndexed(const QVector<qint64> &checkpoints, qint64 lineCount, qint64 lineStart,
+                       qint64 maxLineLength, qint64 indexedBytes);
+    void handleSearchDone(qint64 offset, quint64 generation);
+    void stopIndexing();
+    void stopSearch();
+    void updateMetrics();
+    void updateScrollBars();
+    void ensureVisible(qint64 offset);
+    int visibleRows() const;
+    int visibleColumns() const;
+    int textLeft() const;
+    qint64 displayEnd(qint64 lineStart) const;
+    qint64 offsetAt(const QPoint &pos) const;
+
+    QFile m_file;                           /**< The file shown. */
+    const char *m_data = nullptr;           /**< Mapping of the whole file. */
+    qint64 m_size = 0;                      /**< Size of the file in bytes. */
+    QString m_filePath;                     /**< Path of the file shown. */
+    QString m_errorString;                  /**< Description of the last error. */
+
+    LineIndex m_index;                      /**< Lines indexed so far. */
+    QThread *m_indexThread = nullptr;       /**< Worker building the index. */
+    std::atomic<bool> m_stopIndexing{false}; /**< Set to stop the index worker. */
+
+    QThread *m_searchThread = nullptr;      /**< Worker of the current search. */
+    std::atomic<bool> m_stopSearching{false}; /**< Set to stop the search worker. */
+    quint64 m_searchGeneration = 0;         /**< Identifies the current search. */
+    qint64 m_searchLength = 0;              /**< Length in bytes of the text searched for. */
+
+    qint64 m_anchor = 0;                    /**< Offset where the selection started. */
+    qint64 m_cursor = 0;                    /**< Offset where the selection ends. */
+    int m_lineHeight = 1;                   /**< Height of a line in pixels. */
+    int m_charWidth = 1;                    /**< Width of a column in pixels. */
+    int m_gutterWidth = 0;                  /**< Width of the line number area in pixels. */
+};
+
+#endif // HUGEFILEVIEW_H
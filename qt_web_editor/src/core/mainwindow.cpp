@@ -8,10 +8,24 @@
  */
 #include "mainwindow.h"
 #include "editorwidget.h"
+#include "previewscheduler.h"
+#include "previewbridge.h"
+#include "previewschemehandler.h"
+#include "devserver.h"
+#include "previewpagecache.h"
+#include "previewdocument.h"
+#include "hugefileview.h"
+#include "filewatcher.h"
+#include "editjournal.h"
+#include "tabplaceholder.h"
+#include "tabhibernator.h"
+#include "documentmanager.h"
 #include "settings.h"
 #include "application.h"
+#include "../utils/prettyprinter.h"
 
 #include <QAction>
+#include <QApplication>
 #include <QKeySequence>
 #include <QMenu>
 #include <QToolBar>
@@ -33,7 +47,14 @@
 #include <QFileSystemModel>
 #include <QTreeView>
 #include <QWebEngineView>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineProfile>
+#include <QWebEngineSettings>
 #include <QDialog>
+#include <QProgressBar>
+#include <QThreadPool>
+#include <QToolButton>
 #include <QDialogButtonBox>
 #include <QGroupBox>
 #include <QVBoxLayout>
@@ -65,6 +86,34 @@
 #include <QStyleFactory>
 #include <QShortcut>
 #include <QActionGroup>
+#include <QTimer>
+#include <QShowEvent>
+#include <QSpinBox>
+#include <QFormLayout>
+#include <QComboBox>
+#include <QInputDialog>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QScrollBar>
+#include <QSignalBlocker>
+
+#include <climits>
+
+#include <algorithm>
+
+namespace {
+/** Delay after the window is first shown before the preview engine is started. */
+constexpr int kPreviewPrewarmDelayMs = 300;
+
+/** Files larger than this are streamed by their editor instead of decoded in one piece. */
+constexpr qint64 kParallelDecodeLimit = 1024 * 1024;
+
+/** Largest file shown in a HugeFileView that Pretty View reformats. */
+constexpr qint64 kMaxPrettyViewBytes = 64 * 1024 * 1024;
+
+/** Idle time after switching tabs before the restored tabs next to it are loaded. */
+constexpr int kTabPrewarmDelayMs = 1000;
+}
 
 /**
  * @brief Constructs a MainWindow with the given parent.
@@ -80,9 +129,23 @@ MainWindow::MainWindow(QWidget *parent)
     , m_fileBrowserDock(nullptr)
     , m_tabWidget(new QTabWidget(this))
     , m_mainSplitter(new QSplitter(Qt::Horizontal, this))
+    , m_editorSplitter(new QSplitter(Qt::Horizontal, this))
     , m_fileSystemModel(new QFileSystemModel(this))
     , m_fileBrowser(new QTreeView(this))
-    , m_webView(new QWebEngineView(this))
+    , m_webView(nullptr)
+    , m_previewPlaceholder(new QLabel(this))
+    , m_previewScheduler(new PreviewScheduler(this))
+    , m_schemeHandler(new PreviewSchemeHandler(this))
+    , m_devServer(new DevServer(this))
+    , m_previewLatencyLabel(new QLabel(this))
+    , m_loadProgressBar(new QProgressBar(this))
+    , m_cancelLoadButton(new QToolButton(this))
+    , m_decodePool(new QThreadPool(this))
+    , m_fileWatcher(new FileWatcher(this))
+    , m_prewarmTimer(new QTimer(this))
+    , m_documents(new DocumentManager(this))
+    , m_hibernator(new TabHibernator(m_tabWidget, m_decodePool, this))
+    , m_memoryLabel(new QLabel(this))
     , m_newFileAction(nullptr)
     , m_openFileAction(nullptr)
     , m_openFolderAction(nullptr)
@@ -103,12 +166,12 @@ MainWindow::MainWindow(QWidget *parent)
     , m_aboutAction(nullptr)
     , m_currentFolder()
     , m_isPreviewVisible(true)
+    , m_statusLabel(new QLabel(this))
     , m_isFullScreen(false)
     , m_wasMenuBarVisible(true)
-    , m_wasToolBarVisible(true)
-    , m_wasStatusBarVisible(true)
     , m_tempFiles()
-    , m_statusLabel(new QLabel(this))
+    , m_wasStatusBarVisible(true)
+    , m_wasToolBarVisible(true)
 {
     // Set application name and window title
     QCoreApplication::setApplicationName("Rapid");
@@ -128,8 +191,8 @@ MainWindow::MainWindow(QWidget *parent)
     // Load settings
     loadSettings();
     
-    // Show welcome tab
-    createNewEditorTab();
+    // Reopen the files of the last session, or show a welcome tab
+    restoreSession();
 }
 
 /**
@@ -141,6 +204,10 @@ MainWindow::~MainWindow()
 {
     saveSettings();
     
+    // Files still being decoded must not call back into a dead window
+    m_decodePool->clear();
+    m_decodePool->waitForDone();
+    
     // Clean up temporary files
     for (const QString &file : qAsConst(m_tempFiles)) {
         QFile::remove(file);
@@ -170,6 +237,31 @@ void MainWindow::closeEvent(QCloseEvent *event)
     event->accept();
 }
 
+/**
+ * @brief Handles the show event for the main window.
+ * 
+ * The first time the window is shown, the preview engine is scheduled to be
+ * created shortly afterwards, once the editor has painted and can take input.
+ * 
+ * @param event The show event.
+ */
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    
+    if (m_previewPrewarmScheduled) {
+        return;
+    }
+    m_previewPrewarmScheduled = true;
+    
+    QTimer::singleShot(kPreviewPrewarmDelayMs, this, [this]() {
+        if (m_isPreviewVisible && !m_webView) {
+            setupPreviewEngine();
+            m_previewScheduler->scheduleNow();
+        }
+    });
+}
+
 /**
  * @brief Sets up all actions for the main window.
  * 
@@ -192,6 +284,9 @@ void MainWindow::setupActions()
     m_saveAsAction = new QAction(tr("Save &As..."), this);
     m_saveAsAction->setShortcut(QKeySequence::SaveAs);
     
+    m_saveAllAction = new QAction(tr("Save A&ll"), this);
+    m_saveAllAction->setShortcut(QKeySequence(tr("Ctrl+Alt+S")));
+    
     m_closeTabAction = new QAction(tr("&Close Tab"), this);
     m_closeTabAction->setShortcut(QKeySequence::Close);
     
@@ -286,6 +381,7 @@ void MainWindow::setupActions()
     m_fileMenu->addSeparator();
     m_fileMenu->addAction(m_saveAction);
     m_fileMenu->addAction(m_saveAsAction);
+    m_fileMenu->addAction(m_saveAllAction);
     m_fileMenu->addSeparator();
     m_fileMenu->addAction(m_closeTabAction);
     m_fileMenu->addSeparator();
@@ -313,10 +409,37 @@ void MainWindow::setupActions()
     QAction *pasteAction = editMenu->addAction(QIcon(":/icons/edit-paste.svg"), tr("&Paste"));
     pasteAction->setShortcut(QKeySequence::Paste);
     
+    editMenu->addSeparator();
+    
+    QAction *findAction = editMenu->addAction(tr("&Find..."));
+    findAction->setShortcut(QKeySequence::Find);
+    
+    QAction *findNextAction = editMenu->addAction(tr("Find &Next"));
+    findNextAction->setShortcut(QKeySequence::FindNext);
+    
+    QAction *findPreviousAction = editMenu->addAction(tr("Find Pre&vious"));
+    findPreviousAction->setShortcut(QKeySequence::FindPrevious);
+    
+    QAction *goToLineAction = editMenu->addAction(tr("&Go to Line..."));
+    goToLineAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_G));
+    
     // View menu
     QMenu *viewMenu = menuBar()->addMenu(tr("&View"));
     viewMenu->addMenu(m_themeMenu);
     viewMenu->addMenu(m_fontMenu);
+    viewMenu->addSeparator();
+    QAction *prettyViewAction = viewMenu->addAction(tr("Pretty &View"));
+    prettyViewAction->setShortcut(QKeySequence(tr("Ctrl+Alt+F")));
+    prettyViewAction->setToolTip(tr("Show the current CSS or JavaScript file reformatted, without changing it"));
+    viewMenu->addSeparator();
+    QAction *splitRightAction = viewMenu->addAction(tr("Split &Right"));
+    splitRightAction->setShortcut(QKeySequence(tr("Ctrl+\\")));
+    splitRightAction->setToolTip(tr("Show the current file a second time, side by side; split views do not wrap lines"));
+    QAction *splitDownAction = viewMenu->addAction(tr("Split &Down"));
+    splitDownAction->setShortcut(QKeySequence(tr("Ctrl+Shift+\\")));
+    splitDownAction->setToolTip(tr("Show the current file a second time, one above the other; split views do not wrap lines"));
+    m_unsplitAction = viewMenu->addAction(tr("&Unsplit"));
+    m_unsplitAction->setEnabled(false);
     
     // Run menu
     QMenu *runMenu = menuBar()->addMenu(tr("&Run"));
@@ -330,33 +453,39 @@ void MainWindow::setupActions()
     connect(m_newFileAction, &QAction::triggered, this, &MainWindow::newFile);
     connect(m_openFileAction, &QAction::triggered, this, &MainWindow::openFile);
     connect(m_openFolderAction, &QAction::triggered, this, &MainWindow::openFolder);
-    connect(m_saveAction, &QAction::triggered, this, &MainWindow::saveFile);
-    connect(m_saveAsAction, &QAction::triggered, this, &MainWindow::saveFileAs);
     connect(m_closeTabAction, &QAction::triggered, [this]() { closeTab(m_tabWidget->currentIndex()); });
     connect(m_preferencesAction, &QAction::triggered, this, &MainWindow::showPreferences);
     connect(m_exitAction, &QAction::triggered, this, &QMainWindow::close);
     
     // Edit actions
     connect(undoAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->undo();
+        if (auto editor = focusedEditor()) editor->undo();
     });
     connect(redoAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->redo();
+        if (auto editor = focusedEditor()) editor->redo();
     });
     connect(cutAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->cut();
+        if (auto editor = focusedEditor()) editor->cut();
     });
     connect(copyAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->copy();
+        if (auto editor = focusedEditor()) editor->copy();
+        else if (auto view = currentHugeFileView()) view->copy();
     });
     connect(pasteAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->paste();
+        if (auto editor = focusedEditor()) editor->paste();
     });
+    connect(findAction, &QAction::triggered, this, &MainWindow::showFindDialog);
+    connect(findNextAction, &QAction::triggered, this, [this]() { findText(false); });
+    connect(findPreviousAction, &QAction::triggered, this, [this]() { findText(true); });
+    connect(goToLineAction, &QAction::triggered, this, &MainWindow::goToLine);
+    connect(prettyViewAction, &QAction::triggered, this, &MainWindow::showPrettyView);
+    connect(splitRightAction, &QAction::triggered, this, [this]() { splitEditor(Qt::Horizontal); });
+    connect(splitDownAction, &QAction::triggered, this, [this]() { splitEditor(Qt::Vertical); });
+    connect(m_unsplitAction, &QAction::triggered, this, &MainWindow::unsplitEditor);
     
     // View actions
     connect(m_togglePreviewAction, &QAction::toggled, [this](bool visible) {
-        m_isPreviewVisible = visible;
-        m_webView->setVisible(visible);
+        setPreviewVisible(visible);
     });
     connect(m_toggleFileBrowserAction, &QAction::toggled, [this](bool visible) {
         m_isFileBrowserVisible = visible;
@@ -460,23 +589,24 @@ void MainWindow::setupToolBar()
     
     // Connect edit actions
     connect(undoAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->undo();
+        if (auto editor = focusedEditor()) editor->undo();
     });
     
     connect(redoAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->redo();
+        if (auto editor = focusedEditor()) editor->redo();
     });
     
     connect(cutAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->cut();
+        if (auto editor = focusedEditor()) editor->cut();
     });
     
     connect(copyAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->copy();
+        if (auto editor = focusedEditor()) editor->copy();
+        else if (auto view = currentHugeFileView()) view->copy();
     });
     
     connect(pasteAction, &QAction::triggered, this, [this]() {
-        if (auto editor = currentEditor()) editor->paste();
+        if (auto editor = focusedEditor()) editor->paste();
     });
 }
 
@@ -507,14 +637,21 @@ void MainWindow::setupDockWidgets()
     // Set minimum width for file browser
     m_fileBrowser->setMinimumWidth(150);
     
+    // The web engine is created on first use; a cheap label holds its place
+    m_previewPlaceholder->setText(tr("Preview"));
+    m_previewPlaceholder->setAlignment(Qt::AlignCenter);
+    m_previewPlaceholder->setEnabled(false);
+    
     // Set minimum width for preview and file browser
-    m_webView->setMinimumWidth(200);
+    m_previewPlaceholder->setMinimumWidth(200);
     m_fileBrowser->setMinimumWidth(200);
     
     // Set up main splitter
     m_mainSplitter->addWidget(m_fileBrowser);
-    m_mainSplitter->addWidget(m_tabWidget);
-    m_mainSplitter->addWidget(m_webView);
+    m_editorSplitter->addWidget(m_tabWidget);
+    m_editorSplitter->setChildrenCollapsible(false);
+    m_mainSplitter->addWidget(m_editorSplitter);
+    m_mainSplitter->addWidget(m_previewPlaceholder);
     
     // Set stretch factors
     m_mainSplitter->setStretchFactor(0, 1);
@@ -539,23 +676,114 @@ void MainWindow::setupDockWidgets()
     m_tabWidget->setDocumentMode(true);
     m_tabWidget->setMovable(true);
     
+    // Serve the preview and its resources from open buffers or from disk
+    m_schemeHandler->setBufferProvider([this](const QString &filePath, TextSnapshot *contents) {
+        return unsavedContents(filePath, contents);
+    });
+    
+    // External browsers get the same view of the workspace
+    m_devServer->setBufferProvider([this](const QString &filePath, TextSnapshot *contents) {
+        return unsavedContents(filePath, contents);
+    });
+    
+    // Ensure the file browser and preview are visible by default
+    m_fileBrowser->show();
+    m_previewPlaceholder->show();
+    m_isFileBrowserVisible = true;
+    m_isPreviewVisible = true;
+}
+
+/**
+ * @brief Creates the preview web engine if it does not exist yet.
+ * 
+ * Starting Chromium is by far the most expensive part of bringing the window
+ * up, so it is deferred until the preview is needed or the application is
+ * idle after the first paint. The placeholder in the splitter is replaced by
+ * the web view in the same position and size.
+ */
+void MainWindow::setupPreviewEngine()
+{
+    if (m_webView) {
+        return;
+    }
+    
+    m_webView = new QWebEngineView(this);
+    m_webView->setMinimumWidth(200);
+    
     // Configure web view for better preview
     m_webView->setContextMenuPolicy(Qt::NoContextMenu);
-    m_webView->page()->setWebChannel(&m_webChannel);
     
-    // Enable JavaScript and other web features
-    QWebEngineSettings *settings = m_webView->settings();
+    QWebEngineProfile *profile = m_webView->page()->profile();
+    profile->installUrlSchemeHandler(PreviewSchemeHandler::schemeName(), m_schemeHandler);
+    
+    // Every editor gets its own page; switching tabs swaps pages instead of reloading
+    Settings *appSettings = Application::instance()->settings();
+    m_pageCache = new PreviewPageCache(profile, m_webView, this);
+    m_pageCache->setCapacity(appSettings->previewCacheSize());
+    m_pageCache->setMemoryBudget(qint64(appSettings->previewCacheBudget()) * 1024 * 1024);
+    connect(appSettings, &Settings::previewCacheSizeChanged, m_pageCache, &PreviewPageCache::setCapacity);
+    connect(appSettings, &Settings::previewCacheBudgetChanged, m_pageCache, [this](int megabytes) {
+        m_pageCache->setMemoryBudget(qint64(megabytes) * 1024 * 1024);
+    });
+    connect(m_pageCache, &PreviewPageCache::bridgeCreated, this, [this](PreviewBridge *bridge) {
+        // Only the page on screen drives the scheduler
+        connect(bridge, &PreviewBridge::patchFinished, this, [this, bridge](bool ok) {
+            if (bridge == m_previewBridge) {
+                m_previewScheduler->loadFinished(ok);
+            }
+        });
+        connect(bridge, &PreviewBridge::reloadRequested, this, [this, bridge]() {
+            if (bridge == m_previewBridge) {
+                m_previewScheduler->scheduleNow();
+            }
+        });
+    });
+    
+    // Enable JavaScript and other web features for all preview pages
+    QWebEngineSettings *settings = profile->settings();
     settings->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
     settings->setAttribute(QWebEngineSettings::LocalStorageEnabled, true);
     settings->setAttribute(QWebEngineSettings::LocalContentCanAccessRemoteUrls, true);
     settings->setAttribute(QWebEngineSettings::ErrorPageEnabled, true);
     settings->setAttribute(QWebEngineSettings::PluginsEnabled, true);
     
-    // Ensure the file browser and preview are visible by default
-    m_fileBrowser->show();
-    m_webView->show();
-    m_isFileBrowserVisible = true;
-    m_isPreviewVisible = true;
+    connect(m_webView, &QWebEngineView::loadFinished, m_previewScheduler, &PreviewScheduler::loadFinished);
+    
+    // Take over the placeholder's slot in the splitter
+    const QList<int> sizes = m_mainSplitter->sizes();
+    m_mainSplitter->replaceWidget(m_mainSplitter->indexOf(m_previewPlaceholder), m_webView);
+    m_mainSplitter->setSizes(sizes);
+    m_webView->setVisible(m_isPreviewVisible);
+    m_previewPlaceholder->deleteLater();
+    m_previewPlaceholder = nullptr;
+}
+
+/**
+ * @brief Returns the widget occupying the preview slot of the splitter.
+ * 
+ * @return The web view once created, the placeholder before that.
+ */
+QWidget *MainWindow::previewWidget() const
+{
+    if (m_webView) {
+        return m_webView;
+    }
+    return m_previewPlaceholder;
+}
+
+/**
+ * @brief Shows or hides the preview, creating its engine when first shown.
+ * 
+ * @param visible Whether the preview should be visible.
+ */
+void MainWindow::setPreviewVisible(bool visible)
+{
+    m_isPreviewVisible = visible;
+    if (visible && !m_webView) {
+        setupPreviewEngine();
+        m_previewScheduler->scheduleNow();
+    }
+    previewWidget()->setVisible(visible);
 }
 
 /**
@@ -565,6 +793,22 @@ void MainWindow::setupDockWidgets()
  */
 void MainWindow::setupStatusBar()
 {
+    // Background loads of large files show their progress and can be cancelled
+    m_loadProgressBar->setRange(0, 100);
+    m_loadProgressBar->setMaximumWidth(160);
+    m_loadProgressBar->setFormat(tr("Loading %p%"));
+    m_loadProgressBar->hide();
+    m_cancelLoadButton->setText(tr("Cancel"));
+    m_cancelLoadButton->setToolTip(tr("Stop loading this file"));
+    m_cancelLoadButton->hide();
+    connect(m_cancelLoadButton, &QToolButton::clicked, this, [this]() {
+        if (auto editor = currentEditor()) editor->cancelLoad();
+    });
+    statusBar()->addPermanentWidget(m_loadProgressBar);
+    statusBar()->addPermanentWidget(m_cancelLoadButton);
+    
+    statusBar()->addPermanentWidget(m_memoryLabel);
+    statusBar()->addPermanentWidget(m_previewLatencyLabel);
     statusBar()->addPermanentWidget(m_statusLabel);
     m_statusLabel->setText(tr("Ready"));
 }
@@ -577,6 +821,7 @@ void MainWindow::setupConnections()
     connect(m_openFolderAction, &QAction::triggered, this, &MainWindow::openFolder);
     connect(m_saveAction, &QAction::triggered, this, &MainWindow::saveFile);
     connect(m_saveAsAction, &QAction::triggered, this, &MainWindow::saveFileAs);
+    connect(m_saveAllAction, &QAction::triggered, this, &MainWindow::saveAllFiles);
     connect(m_closeTabAction, &QAction::triggered, this, [this]() {
         closeTab(m_tabWidget->currentIndex());
     });
@@ -584,8 +829,7 @@ void MainWindow::setupConnections()
     
     // View actions
     connect(m_togglePreviewAction, &QAction::toggled, this, [this](bool visible) {
-        m_isPreviewVisible = visible;
-        m_webView->setVisible(visible);
+        setPreviewVisible(visible);
     });
     
     connect(m_toggleFileBrowserAction, &QAction::toggled, this, [this](bool visible) {
@@ -648,10 +892,45 @@ void MainWindow::setupConnections()
     // File browser
     connect(m_fileBrowser, &QTreeView::doubleClicked, this, &MainWindow::fileDoubleClicked);
     
+    // Open files changed by other programs
+    connect(m_fileWatcher, &FileWatcher::filesChanged, this, &MainWindow::checkChangedFiles);
+    
+    // Restored tabs are loaded when shown, or ahead of it once idle
+    m_prewarmTimer->setSingleShot(true);
+    m_prewarmTimer->setInterval(kTabPrewarmDelayMs);
+    connect(m_prewarmTimer, &QTimer::timeout, this, &MainWindow::prewarmTabs);
+    
+    // Idle tabs hibernate to keep the open files within the memory budget
+    connect(m_hibernator, &TabHibernator::tabHibernated, this, [this](TabPlaceholder *placeholder) {
+        m_documents->attach(placeholder, placeholder->filePath());
+        updateWatchedFiles();
+    });
+    connect(m_hibernator, &TabHibernator::memoryUsageChanged, this, [this](qint64 usedBytes, qint64 budgetBytes) {
+        constexpr qint64 megabyte = 1024 * 1024;
+        m_memoryLabel->setText(tr("Tabs: %1 / %2 MB")
+                               .arg((usedBytes + megabyte - 1) / megabyte)
+                               .arg(budgetBytes / megabyte));
+        m_memoryLabel->setToolTip(tr("Estimated memory used by the open files. Beyond the budget, "
+                                     "the least recently used unmodified tabs are hibernated."));
+    });
+    
+    // Preview rendering
+    connect(m_previewScheduler, &PreviewScheduler::renderRequested, this, &MainWindow::updatePreview);
+    connect(m_previewScheduler, &PreviewScheduler::renderCompleted, this, [this](quint64, qint64 latencyMs) {
+        m_previewLatencyLabel->setText(tr("Preview: %1 ms").arg(latencyMs));
+        m_previewLatencyLabel->setToolTip(tr("Average render latency: %1 ms, debounce: %2 ms")
+                                          .arg(m_previewScheduler->averageLatency())
+                                          .arg(m_previewScheduler->debounceInterval()));
+    });
+    
     // Connect to application settings changes
     Settings *settings = Application::instance()->settings();
     connect(settings, &Settings::themeChanged, this, &MainWindow::updateUiForTheme);
     connect(settings, &Settings::editorFontChanged, this, &MainWindow::updateUiForFont);
+    m_hibernator->setMemoryBudget(qint64(settings->tabMemoryBudget()) * 1024 * 1024);
+    connect(settings, &Settings::tabMemoryBudgetChanged, m_hibernator, [this](int megabytes) {
+        m_hibernator->setMemoryBudget(qint64(megabytes) * 1024 * 1024);
+    });
 }
 
 void MainWindow::loadSettings()
@@ -696,7 +975,7 @@ void MainWindow::loadSettings()
     
     // Apply view states
     m_togglePreviewAction->setChecked(m_isPreviewVisible);
-    m_webView->setVisible(m_isPreviewVisible);
+    previewWidget()->setVisible(m_isPreviewVisible);
     
     m_toggleFileBrowserAction->setChecked(m_isFileBrowserVisible);
     m_fileBrowser->setVisible(m_isFileBrowserVisible);
@@ -771,6 +1050,39 @@ void MainWindow::saveSettings()
     }
     settings.setValue("recentFiles", recentFiles);
     
+    // Save the open files and where they were viewed so the next start can restore them
+    QStringList openFiles;
+    QVariantList tabStates;
+    QString currentFile;
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        QString filePath;
+        QVariantMap state;
+        if (auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i))) {
+            filePath = editor->filePath();
+            state["cursor"] = editor->textCursor().position();
+            state["firstLine"] = editor->verticalScrollBar()->value();
+        } else if (auto view = qobject_cast<HugeFileView*>(m_tabWidget->widget(i))) {
+            filePath = view->filePath();
+        } else if (auto placeholder = qobject_cast<TabPlaceholder*>(m_tabWidget->widget(i))) {
+            filePath = placeholder->filePath();
+            if (placeholder->isFileUnchanged()) {
+                state["cursor"] = placeholder->cursorPosition();
+                state["firstLine"] = placeholder->firstVisibleLine();
+            }
+        }
+        if (!filePath.isEmpty()) {
+            state["lastModified"] = QFileInfo(filePath).lastModified();
+            openFiles.append(filePath);
+            tabStates.append(state);
+            if (i == m_tabWidget->currentIndex()) {
+                currentFile = filePath;
+            }
+        }
+    }
+    settings.setValue("openFiles", openFiles);
+    settings.setValue("tabStates", tabStates);
+    settings.setValue("currentFile", currentFile);
+    
     settings.endGroup();
     
     // Save application settings (theme, font, etc.)
@@ -784,18 +1096,24 @@ void MainWindow::newFile()
 
 void MainWindow::openFile()
 {
-    QString filePath = QFileDialog::getOpenFileName(this, 
+    const QStringList filePaths = QFileDialog::getOpenFileNames(this, 
         tr("Open File"), 
         m_currentFolder,
         tr("Web Files (*.html *.htm *.css *.js *.json);;All Files (*)"));
     
-    if (!filePath.isEmpty()) {
-        // Update the current folder to the parent directory of the selected file
-        QFileInfo fileInfo(filePath);
-        m_currentFolder = fileInfo.absolutePath();
-        
-        // Open the file in the editor
-        openFileInEditor(filePath);
+    if (filePaths.isEmpty()) {
+        return;
+    }
+    
+    // Update the current folder to the parent directory of the selected files
+    QFileInfo fileInfo(filePaths.first());
+    m_currentFolder = fileInfo.absolutePath();
+    
+    // Open the files in the editor
+    if (filePaths.size() == 1) {
+        openFileInEditor(filePaths.first());
+    } else {
+        openFiles(filePaths);
     }
 }
 
@@ -822,25 +1140,9 @@ void MainWindow::saveFile()
     if (editor->filePath().isEmpty()) {
         saveFileAs();
         return;
-    } else {
-        if (editor->save()) {
-            // Add to recent files
-            QString filePath = editor->filePath();
-            QStringList recentFiles = Application::instance()->settings()->recentFiles();
-            recentFiles.removeAll(filePath);
-            recentFiles.prepend(filePath);
-            while (recentFiles.size() > 10) {
-                recentFiles.removeLast();
-            }
-            Application::instance()->settings()->setRecentFiles(recentFiles);
-            
-            // Update the recent files menu
-            updateRecentFilesMenu(recentFiles);
-            
-            statusBar()->showMessage(tr("File saved successfully"), 3000);
-        } else {
-            QMessageBox::critical(this, tr("Error"), tr("Failed to save file."));
-        }
+    } else if (!editor->save()) {
+        // The outcome of a started save is reported by handleSaveFinished()
+        QMessageBox::critical(this, tr("Error"), tr("Failed to save file."));
     }
 }
 
@@ -861,153 +1163,589 @@ void MainWindow::saveFileAs()
         QFileInfo fileInfo(filePath);
         m_currentFolder = fileInfo.absolutePath();
         
-        if (editor->saveAs(filePath)) {
-            // Add to recent files
-            QStringList recentFiles = Application::instance()->settings()->recentFiles();
-            recentFiles.removeAll(filePath);
-            recentFiles.prepend(filePath);
-            while (recentFiles.size() > 10) {
-                recentFiles.removeLast();
-            }
-            Application::instance()->settings()->setRecentFiles(recentFiles);
-            
-            // Update the recent files menu
-            updateRecentFilesMenu(recentFiles);
-            
-            updateWindowTitle();
-            statusBar()->showMessage(tr("File saved successfully"), 3000);
-        } else {
+        if (!editor->saveAs(filePath)) {
             QMessageBox::critical(this, tr("Error"), tr("Failed to save file."));
         }
     }
 }
 
-void MainWindow::updateUiForFont(const QFont &font)
+/**
+ * @brief Saves every modified document that has a file, all at the same time.
+ * 
+ * Each editor writes on its own worker thread. Failures are marked on the
+ * tabs and reported together once all saves are done. Untitled documents are
+ * left alone, since each would need a file name.
+ */
+void MainWindow::saveAllFiles()
 {
-    // Apply font to all editors
     for (int i = 0; i < m_tabWidget->count(); ++i) {
-        if (auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i))) {
-            editor->setFont(font);
+        auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i));
+        if (editor && editor->isModified() && !editor->filePath().isEmpty()
+            && !m_saveAllPending.contains(editor) && editor->save()) {
+            m_saveAllPending.insert(editor);
         }
     }
     
-    // Update font in file browser
-    QFont fileBrowserFont = font;
-    fileBrowserFont.setPointSize(font.pointSize() - 1);
-    m_fileBrowser->setFont(fileBrowserFont);
-    
-    // Update status bar font
-    statusBar()->setFont(font);
+    if (m_saveAllPending.isEmpty()) {
+        statusBar()->showMessage(tr("No modified files to save"), 3000);
+    } else {
+        statusBar()->showMessage(tr("Saving %n file(s)...", nullptr, int(m_saveAllPending.size())));
+    }
 }
 
-void MainWindow::showPreferences()
+/**
+ * @brief Reports the outcome of a save on the editor's tab and to the user.
+ * 
+ * @param editor The editor that was saved.
+ * @param ok True if the file was written.
+ * @param filePath The file that was saved.
+ * @param errorString A description of the error, empty on success.
+ */
+void MainWindow::handleSaveFinished(EditorWidget *editor, bool ok, const QString &filePath,
+                                    const QString &errorString)
 {
-    // Create a simple preferences dialog
-    QDialog dialog(this);
-    dialog.setWindowTitle(tr("Preferences"));
-    dialog.setMinimumWidth(500);
-    
-    QVBoxLayout *layout = new QVBoxLayout(&dialog);
-    
-    // Theme selection
-    QGroupBox *themeGroup = new QGroupBox(tr("Theme"), &dialog);
-    QVBoxLayout *themeLayout = new QVBoxLayout(themeGroup);
-    
-    QButtonGroup *themeButtonGroup = new QButtonGroup(themeGroup);
-    QRadioButton *lightThemeBtn = new QRadioButton(tr("Light"), themeGroup);
-    QRadioButton *darkThemeBtn = new QRadioButton(tr("Dark"), themeGroup);
-    QRadioButton *systemThemeBtn = new QRadioButton(tr("System"), themeGroup);
-    
-    themeButtonGroup->addButton(lightThemeBtn, 0);
-    themeButtonGroup->addButton(darkThemeBtn, 1);
-    themeButtonGroup->addButton(systemThemeBtn, 2);
-    
-    // Set the current theme radio button
-    Settings::Theme currentTheme = Application::instance()->settings()->theme();
-    switch (currentTheme) {
-        case Settings::Theme::Light:
-            lightThemeBtn->setChecked(true);
-            break;
-        case Settings::Theme::Dark:
-            darkThemeBtn->setChecked(true);
-            break;
-        case Settings::Theme::System:
-        default:
-            systemThemeBtn->setChecked(true);
-            break;
+    const int index = m_tabWidget->indexOf(editor);
+    if (index >= 0) {
+        // A failed save stays flagged on its tab until a save succeeds
+        m_tabWidget->tabBar()->setTabTextColor(index, ok ? QColor() : QColor(Qt::red));
+        m_tabWidget->setTabToolTip(index, ok ? QDir::toNativeSeparators(filePath)
+            : tr("Could not save %1: %2").arg(QDir::toNativeSeparators(filePath), errorString));
     }
     
-    themeLayout->addWidget(lightThemeBtn);
-    themeLayout->addWidget(darkThemeBtn);
-    themeLayout->addWidget(systemThemeBtn);
-    
-    // Font selection
-    QGroupBox *fontGroup = new QGroupBox(tr("Editor Font"), &dialog);
-    QHBoxLayout *fontLayout = new QHBoxLayout(fontGroup);
-    
-    QFont currentFont = Application::instance()->settings()->font();
-    QLabel *fontLabel = new QLabel(currentFont.family() + " " + QString::number(currentFont.pointSize()) + "pt", fontGroup);
-    QPushButton *fontButton = new QPushButton(tr("Change..."), fontGroup);
-    
-    fontLayout->addWidget(fontLabel, 1);
-    fontLayout->addWidget(fontButton);
-    
-    // Dialog buttons
-    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &dialog);
-    
-    layout->addWidget(themeGroup);
-    layout->addWidget(fontGroup);
-    layout->addStretch();
-    layout->addWidget(buttonBox);
-    
-    // Connect signals
-    connect(fontButton, &QPushButton::clicked, [&]() {
-        bool ok;
-        QFont newFont = QFontDialog::getFont(&ok, currentFont, this, tr("Select Editor Font"));
-        if (ok) {
-            currentFont = newFont;
-            fontLabel->setText(currentFont.family() + " " + QString::number(currentFont.pointSize()) + "pt");
+    if (ok) {
+        // An atomic save gives the file a new identity
+        if (Document *document = m_documents->documentOf(editor)) {
+            m_documents->refresh(document);
         }
-    });
-    
-    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
-    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+        addRecentFiles({filePath});
+        if (editor == currentEditor()) {
+            updateWindowTitle();
+        }
+    }
     
-    // Show the dialog
-    if (dialog.exec() == QDialog::Accepted) {
-        // Apply theme
-        if (lightThemeBtn->isChecked()) {
-            Application::instance()->settings()->setTheme(Settings::Theme::Light);
-        } else if (darkThemeBtn->isChecked()) {
-            Application::instance()->settings()->setTheme(Settings::Theme::Dark);
+    if (!m_saveAllPending.remove(editor)) {
+        if (ok) {
+            statusBar()->showMessage(tr("File saved successfully"), 3000);
         } else {
-            Application::instance()->settings()->setTheme(Settings::Theme::System);
-        }
-        
-        // Apply font if changed
-        if (currentFont != Application::instance()->settings()->font()) {
-            Application::instance()->settings()->setEditorFont(currentFont);
+            QMessageBox::critical(this, tr("Error"),
+                tr("Could not save file %1: %2").arg(QDir::toNativeSeparators(filePath), errorString));
         }
-        
-        // Apply changes
-        updateUiForTheme();
-        updateUiForFont(Application::instance()->settings()->font());
+        return;
     }
+    
+    if (!ok) {
+        m_saveAllErrors.append(tr("%1: %2").arg(QDir::toNativeSeparators(filePath), errorString));
+    }
+    reportSaveAll();
 }
 
-void MainWindow::toggleFullScreen()
+/**
+ * @brief Reports the outcome of Save All once no save of it is left in progress.
+ */
+void MainWindow::reportSaveAll()
 {
-    static bool wasMaximized = false;
-    static QRect normalGeometry;
-    
-    if (isFullScreen()) {
-        // Exiting fullscreen
-        if (wasMaximized) {
-            showMaximized();
-        } else {
-            showNormal();
-            if (normalGeometry.isValid()) {
-                setGeometry(normalGeometry);
+    if (!m_saveAllPending.isEmpty()) {
+        return;
+    }
+    if (m_saveAllErrors.isEmpty()) {
+        statusBar()->showMessage(tr("All files saved"), 3000);
+    } else {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, tr("Error"),
+            tr("Could not save the following files:\n%1").arg(m_saveAllErrors.join('\n')));
+        m_saveAllErrors.clear();
+    }
+}
+
+/**
+ * @brief Watches the files of the editor tabs.
+ * 
+ * Files shown in a HugeFileView are not watched; they are read-only and
+ * mapped, not copied.
+ */
+void MainWindow::updateWatchedFiles()
+{
+    QStringList filePaths;
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i));
+        if (editor && !editor->filePath().isEmpty()) {
+            filePaths.append(editor->filePath());
+        }
+    }
+    m_fileWatcher->setFiles(filePaths);
+}
+
+/**
+ * @brief Compares open files that changed on disk with their editors.
+ * 
+ * Each file is read, decoded and compared with its editor on the decode pool,
+ * against snapshots of the editor text and of the text last loaded or saved;
+ * the outcome is applied by applyDiskChange(). A file that still holds the
+ * text last loaded or saved, as after a save from this editor, is left alone.
+ * Editors loading or saving are skipped; the save itself sets what the file
+ * holds.
+ * 
+ * @param filePaths The files that changed.
+ */
+void MainWindow::checkChangedFiles(const QStringList &filePaths)
+{
+    const QString mineLabel = tr("Editor");
+    const QString theirsLabel = tr("Disk");
+    for (const QString &filePath : filePaths) {
+        EditorWidget *editor = editorForPath(filePath);
+        if (!editor || editor->isLoading() || editor->isSaving() || m_diskChangePrompts.contains(filePath)) {
+            continue;
+        }
+        
+        const TextSnapshot current = editor->snapshot();
+        const TextSnapshot base = editor->diskText();
+        const bool modified = editor->isModified();
+        const QPointer<EditorWidget> target(editor);
+        m_decodePool->start([this, target, filePath, current, base, modified, mineLabel, theirsLabel]() {
+            auto change = QSharedPointer<DiskChange>::create();
+            change->filePath = filePath;
+            change->revision = current.revision();
+            
+            QFile file(filePath);
+            if (!file.exists()) {
+                change->removed = true;
+            } else if (!file.open(QIODevice::ReadOnly)) {
+                change->errorString = file.errorString();
+            } else {
+                const QString diskText = TextDecoder::decode(file.readAll()).text;
+                const QString baseText = base.toString();
+                if (diskText != baseText) {
+                    const QString currentText = current.toString();
+                    change->changed = true;
+                    change->edits = TextDiff::lineEdits(currentText, diskText);
+                    if (modified && !change->edits.isEmpty()) {
+                        const TextDiff::MergeResult merged =
+                            TextDiff::merge(baseText, currentText, diskText, mineLabel, theirsLabel);
+                        change->mergeEdits = TextDiff::lineEdits(currentText, merged.text);
+                        change->conflicts = merged.conflicts;
+                    }
+                    PieceTable table;
+                    table.setText(diskText);
+                    change->diskText = table.snapshot();
+                }
+            }
+            
+            QMetaObject::invokeMethod(this, [this, target, change]() {
+                applyDiskChange(target, *change);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+/**
+ * @brief Brings an editor up to date with its file after the file changed on disk.
+ * 
+ * A clean editor takes the new text silently. Only the lines that differ are
+ * replaced, in one undoable edit, so the cursor, the undo history and the
+ * highlighting of the other lines stay as they are. An editor with unsaved
+ * changes asks whether to merge the file into them, to reload it, or to keep
+ * the editor text. A change compared with text since edited is compared again.
+ * 
+ * @param editor The editor of the file; may have been closed.
+ * @param change The change, as compared on the decode pool.
+ */
+void MainWindow::applyDiskChange(EditorWidget *editor, const DiskChange &change)
+{
+    if (!editor || editor->filePath() != change.filePath || editor->isLoading() || editor->isSaving()) {
+        return;
+    }
+    const QString fileName = QFileInfo(change.filePath).fileName();
+    
+    if (change.removed) {
+        // Keep the text, but make sure closing the tab offers to save it
+        editor->document()->setModified(true);
+        editor->setDiskText(TextSnapshot());
+        statusBar()->showMessage(tr("%1 was deleted or moved by another program").arg(fileName), 10000);
+        return;
+    }
+    if (!change.errorString.isEmpty()) {
+        statusBar()->showMessage(tr("%1 changed on disk but could not be read: %2")
+                                 .arg(fileName, change.errorString), 10000);
+        return;
+    }
+    if (!change.changed) {
+        return;
+    }
+    if (editor->revision() != change.revision) {
+        checkChangedFiles({change.filePath});
+        return;
+    }
+    
+    // The editor already holds what the file now holds
+    if (change.edits.isEmpty()) {
+        editor->document()->setModified(false);
+        editor->setDiskText(change.diskText);
+        return;
+    }
+    
+    if (!editor->isModified()) {
+        editor->applyLineEdits(change.edits);
+        editor->document()->setModified(false);
+        editor->setDiskText(change.diskText);
+        statusBar()->showMessage(tr("%1 was reloaded after it changed on disk").arg(fileName), 5000);
+        return;
+    }
+    
+    QMessageBox box(QMessageBox::Question, tr("File Changed on Disk"),
+                    tr("%1 has been changed by another program, and has unsaved changes here.").arg(fileName),
+                    QMessageBox::NoButton, this);
+    box.setInformativeText(change.conflicts == 0
+        ? tr("Merging takes both sets of changes.")
+        : tr("Merging takes both sets of changes, and marks the %n line range(s) changed on both sides.",
+             nullptr, change.conflicts));
+    QPushButton *mergeButton = box.addButton(tr("&Merge"), QMessageBox::AcceptRole);
+    QPushButton *reloadButton = box.addButton(tr("&Reload"), QMessageBox::DestructiveRole);
+    box.addButton(tr("&Keep Mine"), QMessageBox::RejectRole);
+    box.setDefaultButton(mergeButton);
+    
+    // The editor can be closed while the user is asked
+    const QPointer<EditorWidget> target(editor);
+    m_diskChangePrompts.insert(change.filePath);
+    box.exec();
+    m_diskChangePrompts.remove(change.filePath);
+    
+    if (!target || target->filePath() != change.filePath) {
+        return;
+    }
+    if (target->revision() != change.revision || target->isSaving()) {
+        checkChangedFiles({change.filePath});
+        return;
+    }
+    
+    if (box.clickedButton() == mergeButton) {
+        // The merge holds unsaved changes, and conflicts to resolve
+        target->applyLineEdits(change.mergeEdits);
+        statusBar()->showMessage(change.conflicts == 0
+            ? tr("Changes on disk merged into %1").arg(fileName)
+            : tr("Changes on disk merged into %1 with %n conflict(s)", nullptr, change.conflicts).arg(fileName),
+            10000);
+    } else if (box.clickedButton() == reloadButton) {
+        target->applyLineEdits(change.edits);
+        target->document()->setModified(false);
+    }
+    target->setDiskText(change.diskText);
+    
+    // The file may have changed again while the user was asked
+    checkChangedFiles({change.filePath});
+}
+
+/**
+ * @brief Asks for a text and finds its next occurrence in the current tab.
+ */
+void MainWindow::showFindDialog()
+{
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, tr("Find"), tr("Find:"),
+                                               QLineEdit::Normal, m_lastSearchText, &ok);
+    if (ok && !text.isEmpty()) {
+        m_lastSearchText = text;
+        findText(false);
+    }
+}
+
+/**
+ * @brief Finds the next or previous occurrence of the last searched text.
+ * 
+ * Huge file views search in the background and report a miss when done.
+ * 
+ * @param backward True to search towards the start of the file.
+ */
+void MainWindow::findText(bool backward)
+{
+    if (m_lastSearchText.isEmpty()) {
+        showFindDialog();
+        return;
+    }
+    
+    const QTextDocument::FindFlags flags = backward ? QTextDocument::FindBackward : QTextDocument::FindFlags();
+    if (EditorWidget *editor = currentEditor()) {
+        if (!editor->find(m_lastSearchText, flags)) {
+            statusBar()->showMessage(tr("\"%1\" not found").arg(m_lastSearchText), 3000);
+        }
+    } else if (HugeFileView *view = currentHugeFileView()) {
+        view->find(m_lastSearchText, flags);
+    }
+}
+
+/**
+ * @brief Shows the current stylesheet or script reformatted in a read-only tab.
+ * 
+ * Meant for minified files: the reformatted text is never saved, so the file
+ * itself stays as it is. Files shown in a HugeFileView can be reformatted too
+ * as long as they are not too large to fit in an editor.
+ */
+void MainWindow::showPrettyView()
+{
+    QString filePath;
+    QString source;
+    if (EditorWidget *editor = currentEditor()) {
+        filePath = editor->filePath();
+        source = editor->snapshot().toString();
+    } else if (HugeFileView *view = currentHugeFileView()) {
+        if (view->contents().size() > kMaxPrettyViewBytes) {
+            QMessageBox::information(this, tr("Pretty View"), tr("This file is too large to be reformatted."));
+            return;
+        }
+        filePath = view->filePath();
+        source = TextDecoder::decode(view->contents()).text;
+    } else {
+        return;
+    }
+    
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    const Lexer::Language language = suffix == "json" ? Lexer::Language::JavaScript
+                                                      : Lexer::languageFromName(suffix);
+    if (!PrettyPrinter::supports(language)) {
+        QMessageBox::information(this, tr("Pretty View"),
+            tr("Pretty View is available for CSS, JavaScript and JSON files."));
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const QString text = PrettyPrinter::format(language, source, Application::instance()->settings()->tabSize());
+    source.clear();
+    
+    EditorWidget *pretty = createNewEditorTab(QString(), m_tabWidget->currentIndex() + 1);
+    pretty->setSyntaxForFile(filePath);
+    pretty->setPlainText(text);
+    pretty->document()->setModified(false);
+    pretty->setReadOnly(true);
+    
+    const int index = m_tabWidget->indexOf(pretty);
+    m_tabWidget->setTabText(index, tr("%1 (pretty)").arg(QFileInfo(filePath).fileName()));
+    m_tabWidget->setTabToolTip(index, tr("Reformatted view of %1; read-only").arg(QDir::toNativeSeparators(filePath)));
+    QApplication::restoreOverrideCursor();
+}
+
+/**
+ * @brief Asks for a line number and moves the cursor of the current tab to it.
+ */
+void MainWindow::goToLine()
+{
+    EditorWidget *editor = currentEditor();
+    HugeFileView *view = currentHugeFileView();
+    if (!editor && !view) {
+        return;
+    }
+    
+    // The dialog takes an int; lines past that cannot be entered
+    const qint64 lineCount = editor ? editor->blockCount() : view->lineCount();
+    const qint64 currentLine = editor ? editor->textCursor().blockNumber() : view->currentLine();
+    bool ok = false;
+    const int line = QInputDialog::getInt(this, tr("Go to Line"),
+        tr("Line (1 - %1):").arg(lineCount), int(qMin<qint64>(currentLine + 1, INT_MAX)),
+        1, int(qMin<qint64>(lineCount, INT_MAX)), 1, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    if (editor) {
+        editor->setTextCursor(QTextCursor(editor->document()->findBlockByNumber(line - 1)));
+        editor->centerCursor();
+        editor->setFocus();
+    } else {
+        view->goToLine(line - 1);
+        view->setFocus();
+    }
+}
+
+void MainWindow::updateUiForFont(const QFont &font)
+{
+    // Apply font to all editors
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        if (auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i))) {
+            editor->setFont(font);
+        } else if (auto view = qobject_cast<HugeFileView*>(m_tabWidget->widget(i))) {
+            view->setFont(font);
+        }
+    }
+    if (m_splitView) {
+        m_splitView->setFont(font);
+    }
+    
+    // Update font in file browser
+    QFont fileBrowserFont = font;
+    fileBrowserFont.setPointSize(font.pointSize() - 1);
+    m_fileBrowser->setFont(fileBrowserFont);
+    
+    // Update status bar font
+    statusBar()->setFont(font);
+}
+
+void MainWindow::showPreferences()
+{
+    // Create a simple preferences dialog
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Preferences"));
+    dialog.setMinimumWidth(500);
+    
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    
+    // Theme selection
+    QGroupBox *themeGroup = new QGroupBox(tr("Theme"), &dialog);
+    QVBoxLayout *themeLayout = new QVBoxLayout(themeGroup);
+    
+    QButtonGroup *themeButtonGroup = new QButtonGroup(themeGroup);
+    QRadioButton *lightThemeBtn = new QRadioButton(tr("Light"), themeGroup);
+    QRadioButton *darkThemeBtn = new QRadioButton(tr("Dark"), themeGroup);
+    QRadioButton *systemThemeBtn = new QRadioButton(tr("System"), themeGroup);
+    
+    themeButtonGroup->addButton(lightThemeBtn, 0);
+    themeButtonGroup->addButton(darkThemeBtn, 1);
+    themeButtonGroup->addButton(systemThemeBtn, 2);
+    
+    // Set the current theme radio button
+    Settings::Theme currentTheme = Application::instance()->settings()->theme();
+    switch (currentTheme) {
+        case Settings::Theme::Light:
+            lightThemeBtn->setChecked(true);
+            break;
+        case Settings::Theme::Dark:
+            darkThemeBtn->setChecked(true);
+            break;
+        case Settings::Theme::System:
+        default:
+            systemThemeBtn->setChecked(true);
+            break;
+    }
+    
+    themeLayout->addWidget(lightThemeBtn);
+    themeLayout->addWidget(darkThemeBtn);
+    themeLayout->addWidget(systemThemeBtn);
+    
+    // Font selection
+    QGroupBox *fontGroup = new QGroupBox(tr("Editor Font"), &dialog);
+    QHBoxLayout *fontLayout = new QHBoxLayout(fontGroup);
+    
+    QFont currentFont = Application::instance()->settings()->font();
+    QLabel *fontLabel = new QLabel(currentFont.family() + " " + QString::number(currentFont.pointSize()) + "pt", fontGroup);
+    QPushButton *fontButton = new QPushButton(tr("Change..."), fontGroup);
+    
+    fontLayout->addWidget(fontLabel, 1);
+    fontLayout->addWidget(fontButton);
+    
+    // Preview page cache
+    QGroupBox *previewGroup = new QGroupBox(tr("Preview"), &dialog);
+    QFormLayout *previewLayout = new QFormLayout(previewGroup);
+    
+    QSpinBox *cacheSizeSpin = new QSpinBox(previewGroup);
+    cacheSizeSpin->setRange(1, 64);
+    cacheSizeSpin->setValue(Application::instance()->settings()->previewCacheSize());
+    cacheSizeSpin->setSuffix(tr(" pages"));
+    
+    QSpinBox *cacheBudgetSpin = new QSpinBox(previewGroup);
+    cacheBudgetSpin->setRange(64, 8192);
+    cacheBudgetSpin->setSingleStep(64);
+    cacheBudgetSpin->setValue(Application::instance()->settings()->previewCacheBudget());
+    cacheBudgetSpin->setSuffix(tr(" MB"));
+    
+    previewLayout->addRow(tr("Pages kept for tab switching:"), cacheSizeSpin);
+    previewLayout->addRow(tr("Memory budget:"), cacheBudgetSpin);
+    
+    // Memory of the open tabs
+    QGroupBox *tabsGroup = new QGroupBox(tr("Open Files"), &dialog);
+    QFormLayout *tabsLayout = new QFormLayout(tabsGroup);
+    
+    QSpinBox *tabBudgetSpin = new QSpinBox(tabsGroup);
+    tabBudgetSpin->setRange(64, 65536);
+    tabBudgetSpin->setSingleStep(64);
+    tabBudgetSpin->setValue(Application::instance()->settings()->tabMemoryBudget());
+    tabBudgetSpin->setSuffix(tr(" MB"));
+    tabBudgetSpin->setToolTip(tr("Beyond this, the least recently used unmodified tabs are hibernated: "
+                                 "their text is compressed and their undo history dropped."));
+    
+    tabsLayout->addRow(tr("Memory budget:"), tabBudgetSpin);
+    
+    // Save durability
+    QGroupBox *saveGroup = new QGroupBox(tr("Saving"), &dialog);
+    QFormLayout *saveLayout = new QFormLayout(saveGroup);
+    
+    QComboBox *durabilityCombo = new QComboBox(saveGroup);
+    durabilityCombo->addItem(tr("Overwrite in place (fastest)"), int(FileSaver::Durability::Direct));
+    durabilityCombo->addItem(tr("Atomic replace"), int(FileSaver::Durability::Atomic));
+    durabilityCombo->addItem(tr("Atomic replace, sync folder"), int(FileSaver::Durability::Full));
+    durabilityCombo->setCurrentIndex(durabilityCombo->findData(
+        int(Application::instance()->settings()->saveDurability())));
+    durabilityCombo->setToolTip(tr("Atomic saves write a temporary file and rename it over the original, "
+                                   "so a crash never leaves a truncated file."));
+    
+    saveLayout->addRow(tr("Write files:"), durabilityCombo);
+    
+    // Dialog buttons
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &dialog);
+    
+    layout->addWidget(themeGroup);
+    layout->addWidget(fontGroup);
+    layout->addWidget(previewGroup);
+    layout->addWidget(tabsGroup);
+    layout->addWidget(saveGroup);
+    layout->addStretch();
+    layout->addWidget(buttonBox);
+    
+    // Connect signals
+    connect(fontButton, &QPushButton::clicked, [&]() {
+        bool ok;
+        QFont newFont = QFontDialog::getFont(&ok, currentFont, this, tr("Select Editor Font"));
+        if (ok) {
+            currentFont = newFont;
+            fontLabel->setText(currentFont.family() + " " + QString::number(currentFont.pointSize()) + "pt");
+        }
+    });
+    
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    
+    // Show the dialog
+    if (dialog.exec() == QDialog::Accepted) {
+        // Apply theme
+        if (lightThemeBtn->isChecked()) {
+            Application::instance()->settings()->setTheme(Settings::Theme::Light);
+        } else if (darkThemeBtn->isChecked()) {
+            Application::instance()->settings()->setTheme(Settings::Theme::Dark);
+        } else {
+            Application::instance()->settings()->setTheme(Settings::Theme::System);
+        }
+        
+        // Apply font if changed
+        if (currentFont != Application::instance()->settings()->font()) {
+            Application::instance()->settings()->setEditorFont(currentFont);
+        }
+        
+        // Apply preview cache limits
+        Application::instance()->settings()->setPreviewCacheSize(cacheSizeSpin->value());
+        Application::instance()->settings()->setPreviewCacheBudget(cacheBudgetSpin->value());
+        
+        // Apply the memory budget of the open tabs
+        Application::instance()->settings()->setTabMemoryBudget(tabBudgetSpin->value());
+        
+        // Apply save durability
+        Application::instance()->settings()->setSaveDurability(
+            static_cast<FileSaver::Durability>(durabilityCombo->currentData().toInt()));
+        
+        // Apply changes
+        updateUiForTheme();
+        updateUiForFont(Application::instance()->settings()->font());
+    }
+}
+
+void MainWindow::toggleFullScreen()
+{
+    static bool wasMaximized = false;
+    static QRect normalGeometry;
+    
+    if (isFullScreen()) {
+        // Exiting fullscreen
+        if (wasMaximized) {
+            showMaximized();
+        } else {
+            showNormal();
+            if (normalGeometry.isValid()) {
+                setGeometry(normalGeometry);
             }
         }
         
@@ -1115,217 +1853,896 @@ void MainWindow::updateUiForTheme()
         styleSheet = "";
     }
     
-    // Apply styles to the main window and its children
-    setStyleSheet(styleSheet);
+    // Apply styles to the main window and its children
+    setStyleSheet(styleSheet);
+    
+    // Update UI components that need special theming
+    update();
+}
+
+void MainWindow::updateWindowTitle()
+{
+    QString title = "Qt Web Editor";
+    EditorWidget *editor = currentEditor();
+    
+    if (editor && !editor->filePath().isEmpty()) {
+        QFileInfo fileInfo(editor->filePath());
+        title = fileInfo.fileName() + " - " + title;
+        
+        if (editor->document()->isModified()) {
+            title.prepend("*");
+        }
+    } else if (HugeFileView *view = currentHugeFileView()) {
+        title = tr("%1 (read-only) - %2").arg(QFileInfo(view->filePath()).fileName(), title);
+    }
+    
+    setWindowTitle(title);
+}
+
+void MainWindow::currentTabChanged(int index)
+{
+    // A restored tab is loaded when first shown; the tab replacing it becomes current
+    if (auto placeholder = qobject_cast<TabPlaceholder*>(m_tabWidget->widget(index))) {
+        materializeTab(placeholder, nullptr);
+        return;
+    }
+    m_prewarmTimer->start();
+    m_hibernator->noteActivated(m_tabWidget->widget(index));
+    updateSplitView();
+    
+    updateWindowTitle();
+    updateLoadIndicator();
+    
+    // A batch being opened renders once, for its final tab
+    if (m_openBatches == 0) {
+        m_previewScheduler->scheduleNow();
+    }
+}
+
+/**
+ * @brief Shows the current file a second time, beside or below its tab.
+ * 
+ * The split view is another editor on the same document: typing in either
+ * edits both, and the text is held and highlighted once. The view follows
+ * the current tab until it is unsplit.
+ * 
+ * @param orientation Qt::Horizontal to split side by side, Qt::Vertical to split one above the other.
+ */
+void MainWindow::splitEditor(Qt::Orientation orientation)
+{
+    EditorWidget *editor = currentEditor();
+    if (!editor || editor->isLoading()) {
+        statusBar()->showMessage(tr("Only a file open in an editor can be split"), 3000);
+        return;
+    }
+    
+    if (!m_splitView) {
+        m_splitView = new EditorWidget(m_editorSplitter);
+        m_editorSplitter->addWidget(m_splitView);
+    }
+    m_editorSplitter->setOrientation(orientation);
+    m_splitView->show();
+    updateSplitView();
+    
+    const int extent = orientation == Qt::Horizontal ? m_editorSplitter->width() : m_editorSplitter->height();
+    m_editorSplitter->setSizes({extent / 2, extent - extent / 2});
+    
+    // Both views start at the same place
+    m_splitView->setTextCursor(editor->textCursor());
+    m_splitView->verticalScrollBar()->setValue(editor->verticalScrollBar()->value());
+    m_splitView->setFocus();
+    m_unsplitAction->setEnabled(true);
+}
+
+/**
+ * @brief Closes the split view.
+ */
+void MainWindow::unsplitEditor()
+{
+    if (!m_splitView || m_splitView->isHidden()) {
+        return;
+    }
+    m_splitView->hide();
+    m_splitView->showDocumentOf(nullptr);
+    m_documents->detach(m_splitView);
+    m_unsplitAction->setEnabled(false);
+    
+    if (EditorWidget *editor = currentEditor()) {
+        editor->setFocus();
+    }
+}
+
+/**
+ * @brief Points the split view at the document of the current tab.
+ * 
+ * Tabs without an editor, or whose file is still loading, leave the split
+ * view empty and disabled.
+ */
+void MainWindow::updateSplitView()
+{
+    if (!m_splitView || m_splitView->isHidden()) {
+        return;
+    }
+    
+    EditorWidget *editor = currentEditor();
+    if (editor && editor->isLoading()) {
+        editor = nullptr;
+    }
+    m_splitView->showDocumentOf(editor);
+    m_splitView->setReadOnly(editor && editor->isReadOnly());
+    m_splitView->setEnabled(editor != nullptr);
+    m_documents->attach(m_splitView, editor ? editor->filePath() : QString());
+}
+
+void MainWindow::fileDoubleClicked(const QModelIndex &index)
+{
+    if (m_fileSystemModel->isDir(index)) {
+        return; // Don't open directories here
+    }
+    
+    QString filePath = m_fileSystemModel->filePath(index);
+    openFileInEditor(filePath);
+}
+
+void MainWindow::closeTab(int index)
+{
+    if (index < 0 || index >= m_tabWidget->count()) {
+        return;
+    }
+    
+    EditorWidget *editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(index));
+    if (!editor) {
+        // Read-only views have nothing to save
+        QWidget *widget = m_tabWidget->widget(index);
+        m_tabWidget->removeTab(index);
+        widget->deleteLater();
+        return;
+    }
+    
+    if (maybeSave(editor)) {
+        m_tabWidget->removeTab(index);
+        editor->deleteLater();
+        updateWatchedFiles();
+        
+        // The editor finishes its write as it goes, but never reports it
+        if (m_saveAllPending.remove(editor)) {
+            reportSaveAll();
+        }
+    }
+}
+
+void MainWindow::showAbout()
+{
+    QMessageBox::about(this, tr("About Rapid"),
+        tr("<h2>Rapid</h2>"
+           "<p>Version 1.0.0</p>"
+           "<p>A beginner-friendly web development editor built with C++ and Qt.</p>"
+           "<p> 2025 Eldiiar Bekbolotov</p>"));
+}
+
+void MainWindow::updatePreview()
+{
+    EditorWidget *editor = currentEditor();
+    if (!editor) return;
+    
+    // Until the window is up the pre-warm creates the engine and renders;
+    // a hidden preview is created and rendered when it is shown
+    if (!m_webView) {
+        if (!m_isPreviewVisible || !m_previewPrewarmScheduled) return;
+        setupPreviewEngine();
+    }
+    
+    const QString filePath = editor->filePath();
+    const TextSnapshot snapshot = editor->snapshot();
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    const bool isHtml = (suffix == "html" || suffix == "htm");
+    
+    // Documents with a path are served through rapid:// so relative links resolve
+    QUrl previewUrl;
+    if (!filePath.isEmpty()) {
+        previewUrl = PreviewSchemeHandler::urlForFile(filePath);
+        if (!isHtml) {
+            // Wrapper pages must not shadow the file itself
+            previewUrl.setQuery(QStringLiteral("preview"));
+        }
+    }
+    
+    // Show the editor's own page; it may still hold its last render
+    m_previewBridge = m_pageCache->activate(editor);
+    if (m_previewBridge->isShowing(previewUrl, snapshot.revision())) {
+        return;
+    }
+    
+    // Take a single copy of the text for this render
+    const QString content = snapshot.toString();
+    
+    // Stylesheets linked by the last HTML page are swapped into that page
+    if (suffix == "css" && previewStylesheet(filePath, content)) {
+        return;
+    }
+    if (isHtml) {
+        m_lastHtmlEditor = editor;
+    }
+    
+    const QString html = PreviewDocument::htmlFor(filePath, content);
+    
+    // Every page runs the live preview runtime, so wrapper pages are patched too
+    switch (m_previewBridge->patch(previewUrl, html)) {
+    case PreviewBridge::PatchResult::Unchanged:
+        m_previewBridge->setSourceRevision(snapshot.revision());
+        return;
+    case PreviewBridge::PatchResult::Patched:
+        m_previewBridge->setSourceRevision(snapshot.revision());
+        m_previewScheduler->loadStarted();
+        return;
+    case PreviewBridge::PatchResult::ReloadRequired:
+        break;
+    }
+    
+    // Unsaved edits to linked files are served by the scheme handler
+    m_previewBridge->beginLoad(previewUrl, html);
+    m_previewBridge->setSourceRevision(snapshot.revision());
+    loadPreviewDocument(previewUrl, html);
+}
+
+/**
+ * @brief Shows a stylesheet edit in the HTML page that links it.
+ * 
+ * If the HTML page last shown in the preview links the stylesheet at
+ * @p filePath, its contents are swapped into that page in place. When the page
+ * is no longer loaded it is reloaded with the edited stylesheet applied.
+ * 
+ * @param filePath Path of the stylesheet being edited.
+ * @param css Current contents of the stylesheet.
+ * @return true if the stylesheet was handled, false if no page links it.
+ */
+bool MainWindow::previewStylesheet(const QString &filePath, const QString &css)
+{
+    EditorWidget *host = m_lastHtmlEditor;
+    if (filePath.isEmpty() || !host || host->filePath().isEmpty()) {
+        return false;
+    }
+    
+    const QUrl hostUrl = PreviewSchemeHandler::urlForFile(host->filePath());
+    const QUrl stylesheetUrl = PreviewSchemeHandler::urlForFile(filePath);
+    const QString hostHtml = host->snapshot().toString();
+    if (!PreviewBridge::linkedStylesheets(hostUrl, hostHtml).contains(stylesheetUrl)) {
+        return false;
+    }
+    
+    switch (m_previewBridge->updateStylesheet(hostUrl, stylesheetUrl, css)) {
+    case PreviewBridge::PatchResult::Unchanged:
+        return true;
+    case PreviewBridge::PatchResult::Patched:
+        m_previewScheduler->loadStarted();
+        return true;
+    case PreviewBridge::PatchResult::ReloadRequired:
+        break;
+    }
+    
+    // The page is not loaded (anymore); bring it back with the edit applied
+    m_previewBridge->beginLoad(hostUrl, hostHtml);
+    m_previewBridge->setStylesheetOverride(stylesheetUrl, css);
+    loadPreviewDocument(hostUrl, hostHtml);
+    return true;
+}
+
+/**
+ * @brief Looks up the unsaved contents of an open file.
+ * 
+ * @param filePath The file path.
+ * @param contents Receives the editor contents if the file has unsaved changes.
+ * @return true if an editor holds unsaved changes for the file.
+ */
+bool MainWindow::unsavedContents(const QString &filePath, TextSnapshot *contents) const
+{
+    EditorWidget *editor = editorForPath(filePath);
+    if (!editor || !editor->isModified()) {
+        return false;
+    }
+    *contents = editor->snapshot();
+    return true;
+}
+
+/**
+ * @brief Loads a complete document into the preview.
+ * 
+ * Documents with a rapid:// URL are pinned in the scheme handler and loaded
+ * by URL, which streams them without the size limit of setHtml(). Untitled
+ * documents have no location and are still handed over with setHtml().
+ * 
+ * @param url The rapid:// URL of the document, or an empty URL.
+ * @param html The document source.
+ */
+void MainWindow::loadPreviewDocument(const QUrl &url, const QString &html)
+{
+    // Only one load may be in flight; the scheduler holds back further renders
+    m_previewScheduler->loadStarted();
+    
+    if (url.isEmpty()) {
+        m_webView->setHtml(html);
+        return;
+    }
+    
+    m_schemeHandler->setPinnedDocument(url, html);
+    if (m_webView->url() == url) {
+        // Loading the same URL again would not bypass the cache reliably
+        m_webView->page()->triggerAction(QWebEnginePage::ReloadAndBypassCache);
+    } else {
+        m_webView->load(url);
+    }
+}
+
+EditorWidget *MainWindow::currentEditor() const
+{
+    if (!m_tabWidget) {
+        return nullptr;
+    }
+    return qobject_cast<EditorWidget*>(m_tabWidget->currentWidget());
+}
+
+/**
+ * @brief Returns the editor that edit commands apply to.
+ * 
+ * @return The split view if it has the focus, otherwise the editor of the current tab.
+ */
+EditorWidget *MainWindow::focusedEditor() const
+{
+    if (m_splitView && focusWidget() == m_splitView && m_splitView->sourceEditor()) {
+        return m_splitView;
+    }
+    return currentEditor();
+}
+
+/**
+ * @brief Returns the editor of a file.
+ * 
+ * @param filePath The file, by any path naming it.
+ * @return The editor, or nullptr if the file is not open in an editor.
+ */
+EditorWidget *MainWindow::editorForPath(const QString &filePath) const
+{
+    Document *document = m_documents->find(filePath);
+    if (!document) {
+        return nullptr;
+    }
+    const QList<QWidget*> views = document->views();
+    for (QWidget *view : views) {
+        auto editor = qobject_cast<EditorWidget*>(view);
+        if (editor && m_tabWidget->indexOf(editor) >= 0) {
+            return editor;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the tab showing a file, in an editor, a huge file view or a restored placeholder.
+ * 
+ * @param filePath The file, by any path naming it.
+ * @return The tab's widget, or nullptr if the file is not open.
+ */
+QWidget *MainWindow::tabForPath(const QString &filePath) const
+{
+    Document *document = m_documents->find(filePath);
+    if (!document) {
+        return nullptr;
+    }
+    // A view on its way out, such as a placeholder being replaced, has left the tabs
+    const QList<QWidget*> views = document->views();
+    for (QWidget *view : views) {
+        if (m_tabWidget->indexOf(view) >= 0) {
+            return view;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the huge file view of the current tab.
+ * 
+ * @return The view, or nullptr if the current tab is an editor.
+ */
+HugeFileView *MainWindow::currentHugeFileView() const
+{
+    return m_tabWidget ? qobject_cast<HugeFileView*>(m_tabWidget->currentWidget()) : nullptr;
+}
+
+/**
+ * @brief Creates a tab showing a file too large to edit.
+ * 
+ * @param filePath The file.
+ * @param index Where to insert the tab, or -1 to append it.
+ * @param makeCurrent Whether to make the tab current.
+ * @param errorString Receives a description of the error if the file cannot be shown.
+ * @return The view, or nullptr on error.
+ */
+HugeFileView *MainWindow::createHugeFileTab(const QString &filePath, int index, bool makeCurrent,
+                                            QString *errorString)
+{
+    auto view = new HugeFileView(this);
+    if (!view->open(filePath)) {
+        *errorString = view->errorString();
+        delete view;
+        return nullptr;
+    }
+    
+    connect(view, &HugeFileView::indexProgressChanged, this, [this, view]() {
+        if (view == currentHugeFileView()) {
+            updateLoadIndicator();
+        }
+    });
+    connect(view, &HugeFileView::indexFinished, this, &MainWindow::updateLoadIndicator);
+    connect(view, &HugeFileView::searchFinished, this, [this](bool found) {
+        if (!found) {
+            statusBar()->showMessage(tr("\"%1\" not found").arg(m_lastSearchText), 3000);
+        }
+    });
     
-    // Update UI components that need special theming
-    update();
+    m_documents->attach(view, filePath);
+    index = m_tabWidget->insertTab(index, view, QFileInfo(filePath).fileName());
+    m_tabWidget->setTabToolTip(index, tr("%1 (read-only)").arg(QDir::toNativeSeparators(filePath)));
+    if (makeCurrent) {
+        m_tabWidget->setCurrentIndex(index);
+    }
+    return view;
 }
 
-void MainWindow::updateWindowTitle()
+void MainWindow::openFileInEditor(const QString &filePath)
 {
-    QString title = "Qt Web Editor";
-    EditorWidget *editor = currentEditor();
+    if (filePath.isEmpty()) {
+        return;
+    }
     
-    if (editor && !editor->filePath().isEmpty()) {
-        QFileInfo fileInfo(editor->filePath());
-        title = fileInfo.fileName() + " - " + title;
+    // Check if file is already open
+    auto existingTab = tabForPath(filePath);
+    if (existingTab) {
+        m_tabWidget->setCurrentWidget(existingTab);
+        return;
+    }
+    
+    if (HugeFileView::isHugeFile(filePath)) {
+        // Too large to edit: show it read-only
+        QString errorString;
+        if (!createHugeFileTab(filePath, -1, true, &errorString)) {
+            QMessageBox::critical(this, tr("Error"),
+                tr("Could not open file %1: %2").arg(filePath, errorString));
+            return;
+        }
+    } else {
+        // Create new editor tab
+        EditorWidget *editor = createNewEditorTab(filePath);
         
-        if (editor->document()->isModified()) {
-            title.prepend("*");
+        // Load file content
+        if (!editor->load(filePath)) {
+            QMessageBox::critical(this, tr("Error"), 
+                tr("Could not open file: %1").arg(filePath));
+            closeTab(m_tabWidget->indexOf(editor));
+            return;
         }
     }
     
-    setWindowTitle(title);
-}
-
-void MainWindow::currentTabChanged(int index)
-{
-    Q_UNUSED(index);
-    updateWindowTitle();
-    updatePreview();
-}
-
-void MainWindow::fileDoubleClicked(const QModelIndex &index)
-{
-    if (m_fileSystemModel->isDir(index)) {
-        return; // Don't open directories here
+    // Update current folder
+    QFileInfo fileInfo(filePath);
+    m_currentFolder = fileInfo.absolutePath();
+    Application::instance()->settings()->setLastOpenedPath(m_currentFolder);
+    
+    // Update file browser
+    if (m_fileBrowser) {
+        m_fileBrowser->setRootIndex(m_fileSystemModel->index(m_currentFolder));
     }
     
-    QString filePath = m_fileSystemModel->filePath(index);
-    openFileInEditor(filePath);
+    // Update window title
+    updateWindowTitle();
+    
+    // Update preview
+    m_previewScheduler->scheduleNow();
+    
+    // Add to recent files
+    addRecentFiles({filePath});
 }
 
-void MainWindow::closeTab(int index)
+/**
+ * @brief Opens several files at once.
+ * 
+ * The files are read and decoded in parallel on a thread pool. Each tab is
+ * created as soon as its file is ready, in the position the file has in
+ * @p filePaths, without being made current. Once all files are in, the tab of
+ * @p currentFilePath (or of the last file) is made current and the preview is
+ * rendered once for it. Files too large to decode in one piece are loaded in
+ * the background by their editors instead.
+ * 
+ * @param filePaths The files to open.
+ * @param currentFilePath The file whose tab becomes current, if any.
+ */
+void MainWindow::openFiles(const QStringList &filePaths, const QString &currentFilePath)
 {
-    if (index < 0 || index >= m_tabWidget->count()) {
-        return;
+    auto batch = QSharedPointer<OpenBatch>::create();
+    batch->firstIndex = m_tabWidget->count();
+    batch->currentFilePath = currentFilePath;
+    
+    // Paths naming the same file open it once
+    QSet<QString> canonicalPaths;
+    for (const QString &filePath : filePaths) {
+        if (filePath.isEmpty()) {
+            continue;
+        }
+        const QString canonicalPath = DocumentManager::canonicalPath(filePath);
+        if (canonicalPaths.contains(canonicalPath)) {
+            continue;
+        }
+        canonicalPaths.insert(canonicalPath);
+        if (tabForPath(filePath)) {
+            batch->existing.append(filePath);
+            continue;
+        }
+        batch->filePaths.append(filePath);
     }
+    batch->created.fill(false, batch->filePaths.size());
+    batch->remaining = batch->filePaths.size();
     
-    EditorWidget *editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(index));
-    if (!editor) {
+    if (batch->remaining == 0) {
+        finishOpenBatch(batch);
         return;
     }
     
-    if (maybeSave(editor)) {
-        m_tabWidget->removeTab(index);
-        editor->deleteLater();
+    ++m_openBatches;
+    for (int i = 0; i < batch->filePaths.size(); ++i) {
+        const QString filePath = batch->filePaths.at(i);
+        
+        // Large files stream into their editor on their own
+        if (QFileInfo(filePath).size() > kParallelDecodeLimit) {
+            QMetaObject::invokeMethod(this, [this, batch, i]() {
+                addBatchFile(batch, i, nullptr, QString());
+            }, Qt::QueuedConnection);
+            continue;
+        }
+        
+        m_decodePool->start([this, batch, i, filePath]() {
+            QFile file(filePath);
+            QString errorString;
+            auto result = QSharedPointer<TextDecoder::Result>::create();
+            if (file.open(QIODevice::ReadOnly)) {
+                *result = TextDecoder::decode(file.readAll());
+            } else {
+                errorString = file.errorString();
+            }
+            QMetaObject::invokeMethod(this, [this, batch, i, result, errorString]() {
+                addBatchFile(batch, i, errorString.isEmpty() ? result.data() : nullptr, errorString);
+            }, Qt::QueuedConnection);
+        });
     }
 }
 
-void MainWindow::showAbout()
+/**
+ * @brief Creates the tab of a file of a batch once its content is ready.
+ * 
+ * @param batch The batch the file belongs to.
+ * @param index Position of the file in the batch.
+ * @param content The decoded file, or nullptr to let the editor load it.
+ * @param errorString A description of the error if the file could not be read.
+ */
+void MainWindow::addBatchFile(const QSharedPointer<OpenBatch> &batch, int index,
+                              const TextDecoder::Result *content, const QString &errorString)
 {
-    QMessageBox::about(this, tr("About Rapid"),
-        tr("<h2>Rapid</h2>"
-           "<p>Version 1.0.0</p>"
-           "<p>A beginner-friendly web development editor built with C++ and Qt.</p>"
-           "<p> 2025 Eldiiar Bekbolotov</p>"));
+    const QString filePath = batch->filePaths.at(index);
+    
+    if (!errorString.isEmpty()) {
+        batch->errors.append(tr("%1: %2").arg(QDir::toNativeSeparators(filePath), errorString));
+    } else if (!tabForPath(filePath)) {
+        // Keep the order of the batch among the tabs created so far
+        int tabIndex = qMin(batch->firstIndex, m_tabWidget->count());
+        for (int i = 0; i < index; ++i) {
+            if (batch->created.at(i)) {
+                ++tabIndex;
+            }
+        }
+        
+        if (!content && HugeFileView::isHugeFile(filePath)) {
+            // Too large to edit: show it read-only
+            QString hugeFileError;
+            if (createHugeFileTab(filePath, tabIndex, false, &hugeFileError)) {
+                batch->created[index] = true;
+            } else {
+                batch->errors.append(tr("%1: %2").arg(QDir::toNativeSeparators(filePath), hugeFileError));
+            }
+        } else {
+            EditorWidget *editor = createNewEditorTab(filePath, tabIndex, false);
+            if (content) {
+                editor->setLoadedContent(filePath, content->text);
+                batch->created[index] = true;
+            } else if (editor->load(filePath)) {
+                batch->created[index] = true;
+            } else {
+                batch->errors.append(QDir::toNativeSeparators(filePath));
+                closeTab(m_tabWidget->indexOf(editor));
+            }
+        }
+    }
+    
+    if (--batch->remaining == 0) {
+        --m_openBatches;
+        finishOpenBatch(batch);
+    }
 }
 
-void MainWindow::updatePreview()
+/**
+ * @brief Makes the chosen tab of a completed batch current and renders its preview.
+ * 
+ * @param batch The completed batch.
+ */
+void MainWindow::finishOpenBatch(const QSharedPointer<OpenBatch> &batch)
 {
-    if (!m_webView) return;
+    QStringList opened;
+    for (int i = 0; i < batch->filePaths.size(); ++i) {
+        if (batch->created.at(i)) {
+            opened.append(batch->filePaths.at(i));
+        }
+    }
     
-    EditorWidget *editor = currentEditor();
-    if (!editor) return;
+    QWidget *current = tabForPath(batch->currentFilePath);
+    if (!current && !opened.isEmpty()) {
+        current = tabForPath(opened.last());
+    } else if (!current && !batch->existing.isEmpty()) {
+        current = tabForPath(batch->existing.last());
+    }
     
-    QString filePath = editor->filePath();
-    QString content = editor->toPlainText();
+    if (!opened.isEmpty()) {
+        addRecentFiles(opened);
+    }
     
-    // Always use a temporary file to ensure proper resource loading
-    QTemporaryFile tempFile(QDir::tempPath() + "/rapid_preview_XXXXXX.html");
-    if (!tempFile.open()) {
-        qWarning() << "Failed to create temporary file for preview";
-        return;
+    // Never leave the window without a tab, e.g. when a restored file is gone
+    if (m_tabWidget->count() == 0) {
+        createNewEditorTab();
     }
     
-    QFileInfo fileInfo(filePath);
-    QString suffix = fileInfo.suffix().toLower();
-    
-    // Create appropriate content based on file type
-    QString html;
-    if (suffix == "html" || suffix == "htm") {
-        // For HTML files, use the content directly
-        html = content;
-    } else if (suffix == "css") {
-        // For CSS files, create a simple HTML wrapper
-        html = QString(
-            "<!DOCTYPE html>\n"
-            "<html>\n"
-            "<head>\n"
-            "    <meta charset=\"UTF-8\">\n"
-            "    <title>CSS Preview</title>\n"
-            "    <style>\n%1\n    </style>\n"
-            "</head>\n"
-            "<body>\n"
-            "    <h1>CSS Preview</h1>\n"
-            "    <p>This is a preview of your CSS. The actual effect will be visible when used with HTML.</p>\n"
-            "    <div class=\"example\">Example Element</div>\n"
-            "    <div id=\"test\">Test Div</div>\n"
-            "</body>\n"
-            "</html>"
-        ).arg(content);
-    } else if (suffix == "js") {
-        // For JavaScript files, create a simple HTML wrapper
-        html = QString(
-            "<!DOCTYPE html>\n"
-            "<html>\n"
-            "<head>\n"
-            "    <meta charset=\"UTF-8\">\n"
-            "    <title>JavaScript Preview</title>\n"
-            "    <script src=\"https://code.jquery.com/jquery-3.6.0.min.js\"></script>\n"
-            "</head>\n"
-            "<body>\n"
-            "<h1>%1</h1>\n"
-            "<div id=\"output\">Running JavaScript preview...</div>\n"
-            "</body>\n"
-            "</html>"
-        ).arg(QFileInfo(filePath).fileName(), editor->toPlainText());
-        
-        m_webView->setHtml(html, QUrl::fromLocalFile(filePath));
+    if (current && current != m_tabWidget->currentWidget()) {
+        m_tabWidget->setCurrentWidget(current);
     } else {
-        // For other file types, just show the text content
-        m_webView->setHtml(QString(
-            "<html><body><pre>%1</pre></body></html>"
-        ).arg(editor->toPlainText().toHtmlEscaped()));
+        currentTabChanged(m_tabWidget->currentIndex());
+    }
+    
+    if (!batch->errors.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"),
+            tr("Could not open the following files:\n%1").arg(batch->errors.join('\n')));
     }
 }
 
-EditorWidget *MainWindow::currentEditor() const
+/**
+ * @brief Reopens the files that were open when the application last quit.
+ * 
+ * Each file gets a TabPlaceholder, which reads nothing; only the current tab
+ * is loaded, so restoring many files costs about as much as restoring one.
+ * The others are loaded when first shown, and the neighbours of the current
+ * tab ahead of that once the application is idle. Shows an empty tab if there
+ * is nothing to restore.
+ */
+void MainWindow::restoreSession()
 {
-    if (!m_tabWidget) {
-        return nullptr;
+    // Recovered files get their tabs first, so they are not opened twice
+    recoverJournals();
+    
+    QSettings settings("QtWebEditor", "QtWebEditor");
+    settings.beginGroup("MainWindow");
+    const QStringList filePaths = settings.value("openFiles").toStringList();
+    const QVariantList tabStates = settings.value("tabStates").toList();
+    const QString currentFilePath = settings.value("currentFile").toString();
+    settings.endGroup();
+    
+    {
+        // Adding tabs must not load them
+        const QSignalBlocker blocker(m_tabWidget);
+        for (int i = 0; i < filePaths.size(); ++i) {
+            const QString &filePath = filePaths.at(i);
+            if (!QFileInfo(filePath).isFile() || tabForPath(filePath)) {
+                continue;
+            }
+            const QVariantMap state = tabStates.value(i).toMap();
+            auto placeholder = new TabPlaceholder(filePath, state.value("cursor").toInt(),
+                                                  state.value("firstLine").toInt(),
+                                                  state.value("lastModified").toDateTime(), this);
+            m_documents->attach(placeholder, filePath);
+            const int index = m_tabWidget->addTab(placeholder, QFileInfo(filePath).fileName());
+            m_tabWidget->setTabToolTip(index, QDir::toNativeSeparators(filePath));
+            if (filePath == currentFilePath) {
+                m_tabWidget->setCurrentIndex(index);
+            }
+        }
+        
+        if (m_tabWidget->count() == 0) {
+            createNewEditorTab();
+        }
     }
-    return qobject_cast<EditorWidget*>(m_tabWidget->currentWidget());
+    currentTabChanged(m_tabWidget->currentIndex());
 }
 
-EditorWidget *MainWindow::editorForPath(const QString &filePath) const
+/**
+ * @brief Replaces a restored placeholder by the editor or viewer of its file.
+ * 
+ * The cursor and the view are put back where they were, unless the file was
+ * modified since. A hibernated tab gets its text back from the placeholder,
+ * unless the file was modified since. A file that cannot be opened is
+ * reported and its tab closed.
+ * 
+ * @param placeholder The placeholder.
+ * @param content The decoded file, or nullptr to read it here.
+ * @return The new tab's widget, or nullptr if the file could not be opened.
+ */
+QWidget *MainWindow::materializeTab(TabPlaceholder *placeholder, const TextDecoder::Result *content)
 {
-    if (!m_tabWidget) {
+    const int index = m_tabWidget->indexOf(placeholder);
+    if (index < 0) {
         return nullptr;
     }
+    const QString filePath = placeholder->filePath();
+    const bool makeCurrent = index == m_tabWidget->currentIndex();
+    const bool restoreView = placeholder->isFileUnchanged();
+    const int cursorPosition = placeholder->cursorPosition();
+    const int firstVisibleLine = placeholder->firstVisibleLine();
+    
+    TextDecoder::Result rehydrated;
+    if (!content && placeholder->isHibernated() && restoreView) {
+        rehydrated.text = QString::fromUtf8(qUncompress(placeholder->hibernatedText()));
+        content = &rehydrated;
+    }
     
-    for (int i = 0; i < m_tabWidget->count(); ++i) {
-        if (auto editor = qobject_cast<EditorWidget*>(m_tabWidget->widget(i))) {
-            if (editor->filePath() == filePath) {
-                return editor;
+    // The new tab goes in front of the placeholder, which is removed after it;
+    // the tab that ends up current is reported once both are done
+    QWidget *tab = nullptr;
+    QString errorString;
+    QSignalBlocker blocker(m_tabWidget);
+    if (!content && HugeFileView::isHugeFile(filePath)) {
+        tab = createHugeFileTab(filePath, index, makeCurrent, &errorString);
+    } else {
+        EditorWidget *editor = createNewEditorTab(filePath, index, makeCurrent);
+        if (content) {
+            editor->setLoadedContent(filePath, content->text);
+        } else if (!editor->load(filePath)) {
+            errorString = tr("The file could not be read");
+            m_tabWidget->removeTab(m_tabWidget->indexOf(editor));
+            editor->deleteLater();
+            editor = nullptr;
+        }
+        
+        if (editor && restoreView) {
+            const auto restore = [editor, cursorPosition, firstVisibleLine]() {
+                QTextCursor cursor = editor->textCursor();
+                cursor.setPosition(qBound(0, cursorPosition, editor->document()->characterCount() - 1));
+                editor->setTextCursor(cursor);
+                editor->verticalScrollBar()->setValue(firstVisibleLine);
+            };
+            if (editor->isLoading()) {
+                connect(editor, &EditorWidget::loadFinished, editor, restore, Qt::SingleShotConnection);
+            } else {
+                restore();
             }
         }
+        tab = editor;
     }
-    return nullptr;
+    
+    m_tabWidget->removeTab(m_tabWidget->indexOf(placeholder));
+    placeholder->deleteLater();
+    blocker.unblock();
+    
+    if (!tab) {
+        QMessageBox::critical(this, tr("Error"),
+            tr("Could not open file %1: %2").arg(QDir::toNativeSeparators(filePath), errorString));
+        if (m_tabWidget->count() == 0) {
+            createNewEditorTab();
+        }
+    }
+    if (makeCurrent) {
+        currentTabChanged(m_tabWidget->currentIndex());
+    }
+    return tab;
 }
 
-void MainWindow::openFileInEditor(const QString &filePath)
+/**
+ * @brief Loads the restored tabs next to the current one ahead of their activation.
+ * 
+ * They are the likely next ones. Their files are read and decoded on the
+ * decode pool; large files are left to be streamed in when activated, and
+ * hibernated tabs are quick to bring back anyway.
+ */
+void MainWindow::prewarmTabs()
 {
-    if (filePath.isEmpty()) {
+    // Tabs loaded now would only be hibernated again
+    if (m_hibernator->memoryUsage() > m_hibernator->memoryBudget()) {
         return;
     }
     
-    // Check if file is already open
-    auto existingEditor = editorForPath(filePath);
-    if (existingEditor) {
-        m_tabWidget->setCurrentWidget(existingEditor);
-        return;
+    const int current = m_tabWidget->currentIndex();
+    for (int index : {current + 1, current - 1}) {
+        auto placeholder = qobject_cast<TabPlaceholder*>(m_tabWidget->widget(index));
+        if (!placeholder || placeholder->isPrewarming() || placeholder->isHibernated()
+            || QFileInfo(placeholder->filePath()).size() > kParallelDecodeLimit) {
+            continue;
+        }
+        placeholder->setPrewarming();
+        
+        const QPointer<TabPlaceholder> target(placeholder);
+        const QString filePath = placeholder->filePath();
+        m_decodePool->start([this, target, filePath]() {
+            // A file that cannot be read is reported when its tab is activated
+            QFile file(filePath);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return;
+            }
+            auto result = QSharedPointer<TextDecoder::Result>::create(TextDecoder::decode(file.readAll()));
+            QMetaObject::invokeMethod(this, [this, target, result]() {
+                if (target) {
+                    materializeTab(target, result.data());
+                }
+            }, Qt::QueuedConnection);
+        });
     }
-    
-    // Create new editor tab
-    EditorWidget *editor = nullptr;
-    createNewEditorTab(filePath);
-    
-    // Get the newly created editor
-    editor = qobject_cast<EditorWidget*>(m_tabWidget->currentWidget());
-    if (!editor) {
-        return;
+}
+
+/**
+ * @brief Offers to recover the unsaved edits of an instance that did not shut down.
+ * 
+ * The journals left behind are replayed onto their files. Recovered documents
+ * open as tabs with the edits applied and unsaved, and can be undone back to
+ * the file. The journals are removed either way.
+ */
+void MainWindow::recoverJournals()
+{
+    QVector<EditJournal::Recovery> recoveries;
+    QStringList names;
+    QStringList errors;
+    for (const QString &journalPath : EditJournal::orphanedJournals()) {
+        const EditJournal::Recovery recovery = EditJournal::recover(journalPath);
+        const QString name = recovery.filePath.isEmpty()
+            ? tr("Untitled") : QDir::toNativeSeparators(recovery.filePath);
+        if (!recovery.errorString.isEmpty()) {
+            errors.append(tr("%1: %2").arg(name, recovery.errorString));
+            EditJournal::discard(journalPath);
+        } else if (recovery.text == recovery.diskText) {
+            EditJournal::discard(journalPath);
+        } else {
+            recoveries.append(recovery);
+            names.append(name);
+        }
     }
     
-    // Load file content
-    if (!editor->load(filePath)) {
-        QMessageBox::critical(this, tr("Error"), 
-            tr("Could not open file: %1").arg(filePath));
-        closeTab(m_tabWidget->indexOf(editor));
-        return;
+    if (!recoveries.isEmpty()) {
+        const QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Recover Unsaved Changes"),
+            tr("Rapid did not shut down properly. Unsaved changes to the following files can be recovered:\n%1\n\n"
+               "Recover them?").arg(names.join('\n')),
+            QMessageBox::Yes | QMessageBox::Discard, QMessageBox::Yes);
+        
+        for (const EditJournal::Recovery &recovery : qAsConst(recoveries)) {
+            if (answer == QMessageBox::Yes) {
+                EditorWidget *editor = createNewEditorTab(recovery.filePath, -1, false);
+                if (!recovery.filePath.isEmpty() && QFileInfo::exists(recovery.filePath)) {
+                    editor->setLoadedContent(recovery.filePath, recovery.diskText);
+                } else {
+                    editor->setDiskText(TextSnapshot());
+                }
+                editor->applyLineEdits(TextDiff::lineEdits(recovery.diskText, recovery.text));
+            }
+            EditJournal::discard(recovery.journalPath);
+        }
     }
     
-    // Update current folder
-    QFileInfo fileInfo(filePath);
-    m_currentFolder = fileInfo.absolutePath();
-    Application::instance()->settings()->setLastOpenedPath(m_currentFolder);
-    
-    // Update file browser
-    if (m_fileBrowser) {
-        m_fileBrowser->setRootIndex(m_fileSystemModel->index(m_currentFolder));
+    if (!errors.isEmpty()) {
+        QMessageBox::warning(this, tr("Recover Unsaved Changes"),
+            tr("Unsaved changes to the following files could not be recovered:\n%1").arg(errors.join('\n')));
     }
-    
-    // Update window title
-    updateWindowTitle();
-    
-    // Update preview
-    updatePreview();
-    
-    // Add to recent files
+}
+
+/**
+ * @brief Puts files at the top of the recent files list.
+ * 
+ * @param filePaths The files, most recent last.
+ */
+void MainWindow::addRecentFiles(const QStringList &filePaths)
+{
     QStringList recentFiles = Application::instance()->settings()->recentFiles();
-    recentFiles.removeAll(filePath);
-    recentFiles.prepend(filePath);
+    for (const QString &filePath : filePaths) {
+        recentFiles.removeAll(filePath);
+        recentFiles.prepend(filePath);
+    }
     while (recentFiles.size() > 10) {
         recentFiles.removeLast();
     }
@@ -1335,6 +2752,11 @@ void MainWindow::openFileInEditor(const QString &filePath)
 
 bool MainWindow::maybeSave(EditorWidget *editor)
 {
+    // A save in progress may be about to leave the document unmodified
+    if (editor && editor->isSaving()) {
+        editor->waitForSaved();
+    }
+    
     if (!editor || !editor->isModified()) {
         return true;
     }
@@ -1348,7 +2770,7 @@ bool MainWindow::maybeSave(EditorWidget *editor)
             saveFileAs();
             return true;
         } else {
-            return editor->save();
+            return editor->save() && editor->waitForSaved();
         }
     } else if (ret == QMessageBox::Cancel) {
         return false;
@@ -1357,7 +2779,7 @@ bool MainWindow::maybeSave(EditorWidget *editor)
     return true;
 }
 
-void MainWindow::createNewEditorTab(const QString &filePath)
+EditorWidget *MainWindow::createNewEditorTab(const QString &filePath, int index, bool makeCurrent)
 {
     auto editor = new EditorWidget(this);
     
@@ -1379,18 +2801,75 @@ void MainWindow::createNewEditorTab(const QString &filePath)
         }
     });
     
-    connect(editor, &EditorWidget::textChanged, this, &MainWindow::updatePreview);
-    connect(editor, &EditorWidget::contentChanged, this, &MainWindow::updatePreview);
+    // Edits are coalesced by the scheduler; it decides when to re-render
+    connect(editor, &EditorWidget::textChanged, m_previewScheduler, &PreviewScheduler::schedule);
+    connect(editor, &EditorWidget::textChanged, this, [this]() {
+        if (m_pageCache) {
+            m_pageCache->noteWorkspaceChanged();
+        }
+    });
+    
+    // Large files load in the background; a failed or cancelled load closes the tab
+    connect(editor, &EditorWidget::loadProgressChanged, this, [this, editor]() {
+        if (editor == currentEditor()) {
+            updateLoadIndicator();
+        }
+    });
+    connect(editor, &EditorWidget::saveFinished, this, [this, editor](bool ok, const QString &filePath,
+                                                                      const QString &errorString) {
+        handleSaveFinished(editor, ok, filePath, errorString);
+    });
+    connect(editor, &EditorWidget::loadFinished, this, [this, editor](bool ok, const QString &errorString) {
+        updateLoadIndicator();
+        if (ok) {
+            if (editor == currentEditor()) {
+                updateSplitView();
+            }
+            return;
+        }
+        if (!errorString.isEmpty()) {
+            QMessageBox::critical(this, tr("Error"),
+                tr("Could not open file %1: %2").arg(editor->filePath(), errorString));
+        }
+        closeTab(m_tabWidget->indexOf(editor));
+    });
+    
+    // Minified files stay editable, but are hard to read and only highlighted
+    // in part; the editor never wraps, yet still lays each line out whole
+    connect(editor, &EditorWidget::longLinesFound, this, [this, editor]() {
+        if (editor == currentEditor()) {
+            statusBar()->showMessage(tr("This file has very long lines; View > Pretty View shows it reformatted"), 10000);
+        }
+    });
+    
+    // Browsers served by the development server follow the settled edits
+    connect(editor, &EditorWidget::contentChanged, this, [this, editor]() {
+        if (m_devServer->isRunning() && !editor->filePath().isEmpty()) {
+            m_devServer->notifyFileChanged(editor->filePath());
+        }
+    });
+    
+    // Register the file, and watch it for changes made by other programs
+    connect(editor, &EditorWidget::filePathChanged, this, [this, editor](const QString &filePath) {
+        m_documents->attach(editor, filePath);
+        if (m_splitView && m_splitView->sourceEditor() == editor) {
+            m_documents->attach(m_splitView, filePath);
+        }
+    });
+    connect(editor, &EditorWidget::filePathChanged, this, &MainWindow::updateWatchedFiles);
     
     // Add tab
     QString tabText = filePath.isEmpty() ? "Untitled" : QFileInfo(filePath).fileName();
-    int index = m_tabWidget->addTab(editor, tabText);
-    m_tabWidget->setCurrentIndex(index);
+    index = m_tabWidget->insertTab(index, editor, tabText);
+    if (makeCurrent) {
+        m_tabWidget->setCurrentIndex(index);
+    }
     
     // Set file path if provided
     if (!filePath.isEmpty()) {
         editor->setFilePath(filePath);
     }
+    return editor;
 }
 
 void MainWindow::runInBrowser()
@@ -1416,24 +2895,7 @@ void MainWindow::runInBrowser()
         return;
     }
     
-    // Ask user if they want to save changes
-    if (editor->document()->isModified()) {
-        QMessageBox::StandardButton reply;
-        reply = QMessageBox::question(this, tr("Save Changes"), 
-                                    tr("The document has been modified. Do you want to save your changes?"),
-                                    QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel);
-        
-        if (reply == QMessageBox::Save) {
-            saveFile();
-            // If save was cancelled
-            if (editor->document()->isModified()) {
-                return;
-            }
-        } else if (reply == QMessageBox::Cancel) {
-            return;
-        }
-    }
-    
+    // Unsaved changes are served from the editor, so there is no need to save first
     // Show browser selection dialog
     showBrowserSelectionDialog();
 }
@@ -1443,7 +2905,7 @@ void MainWindow::runInDefaultBrowser()
     EditorWidget *editor = currentEditor();
     if (!editor) return;
     
-    QUrl fileUrl = QUrl::fromLocalFile(editor->filePath());
+    QUrl fileUrl = browserUrlForEditor(editor);
     bool success = QDesktopServices::openUrl(fileUrl);
     
     if (!success) {
@@ -1459,7 +2921,7 @@ void MainWindow::runInSpecificBrowser(const QString &browserPath)
     if (!editor) return;
     
     QProcess *process = new QProcess(this);
-    QString fileUrl = QUrl::fromLocalFile(editor->filePath()).toString();
+    QString fileUrl = browserUrlForEditor(editor).toString();
     
     // Connect to handle process finish
     connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
@@ -1476,6 +2938,40 @@ void MainWindow::runInSpecificBrowser(const QString &browserPath)
     }
 }
 
+/**
+ * @brief Returns the URL under which an external browser should open a file.
+ * 
+ * Starts the development server for the opened folder (or the file's own
+ * folder if it lies outside) so the browser sees unsaved changes and reloads
+ * live. Falls back to the file:// URL if the server cannot be started.
+ * 
+ * @param editor The editor holding the file.
+ * @return The URL to open.
+ */
+QUrl MainWindow::browserUrlForEditor(EditorWidget *editor)
+{
+    const QString filePath = editor->filePath();
+    
+    if (!m_devServer->isRunning() || !m_devServer->contains(filePath)) {
+        QString rootPath = QFileInfo(filePath).absolutePath();
+        if (!m_currentFolder.isEmpty()) {
+            const QString folder = QFileInfo(m_currentFolder).canonicalFilePath();
+            if (!folder.isEmpty() && QFileInfo(filePath).canonicalFilePath().startsWith(folder + QLatin1Char('/'))) {
+                rootPath = folder;
+            }
+        }
+        
+        if (m_devServer->start(rootPath)) {
+            statusBar()->showMessage(tr("Serving %1 on http://127.0.0.1:%2")
+                                     .arg(QDir::toNativeSeparators(m_devServer->rootPath()))
+                                     .arg(m_devServer->port()), 3000);
+        }
+    }
+    
+    const QUrl url = m_devServer->urlForFile(filePath);
+    return url.isEmpty() ? QUrl::fromLocalFile(filePath) : url;
+}
+
 void MainWindow::showBrowserSelectionDialog()
 {
     QDialog dialog(this);
@@ -1543,3 +3039,21 @@ void MainWindow::showBrowserSelectionDialog()
         }
     }
 }
+
+/**
+ * @brief Shows the background load progress of the current editor, if any.
+ */
+void MainWindow::updateLoadIndicator()
+{
+    EditorWidget *editor = currentEditor();
+    const bool loading = editor && editor->isLoading();
+    HugeFileView *view = currentHugeFileView();
+    const bool indexing = view && view->isIndexing();
+    m_loadProgressBar->setVisible(loading || indexing);
+    m_cancelLoadButton->setVisible(loading);
+    if (loading) {
+        m_loadProgressBar->setValue(editor->loadProgress());
+    } else if (indexing) {
+        m_loadProgressBar->setValue(view->indexProgress());
+    }
+}
@@ -30,17 +30,33 @@
 #include <QStringList>
 #include <QStandardPaths>
 #include <QKeySequence>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QSet>
 #include <QDebug>
 
-// Forward declarations
-class EditorWidget;
-class QLabel;
-class QWebEngineView;
+#include "../utils/piecetable.h"
+#include "../utils/textdecoder.h"
+#include "../utils/textdiff.h"
 
 // Forward declarations
 class EditorWidget;
+class QThreadPool;
+class HugeFileView;
+class FileWatcher;
+class TabPlaceholder;
+class TabHibernator;
+class DocumentManager;
+class QTimer;
 class QLabel;
 class QWebEngineView;
+class PreviewScheduler;
+class PreviewBridge;
+class PreviewSchemeHandler;
+class DevServer;
+class PreviewPageCache;
+class QProgressBar;
+class QToolButton;
 
 /**
  * @brief The MainWindow class represents the main application window.
@@ -80,6 +96,15 @@ protected:
      */
     void closeEvent(QCloseEvent *event) override;
 
+    /**
+     * @brief Handles the window show event.
+     * 
+     * Schedules the preview engine to be pre-warmed once the window is up.
+     * 
+     * @param event The show event.
+     */
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     /** @name File Operations
      *  Methods handling file operations.
@@ -90,8 +115,14 @@ private slots:
     void openFolder();
     void saveFile();
     void saveFileAs();
+    void saveAllFiles();
+    void showFindDialog();
+    void findText(bool backward);
+    void goToLine();
+    void showPrettyView();
     void closeTab(int index);
     void openFileInEditor(const QString &filePath);
+    void openFiles(const QStringList &filePaths, const QString &currentFilePath = QString());
     void updateRecentFilesMenu(const QStringList &recentFiles);
     ///@}
     
@@ -101,6 +132,8 @@ private slots:
     ///@{
     void currentTabChanged(int index);
     void fileDoubleClicked(const QModelIndex &index);
+    void splitEditor(Qt::Orientation orientation);
+    void unsplitEditor();
     ///@}
     
     /** @name UI Updates
@@ -143,6 +176,7 @@ private:
     void setupToolBar();
     void setupDockWidgets();
     void setupStatusBar();
+    void setupPreviewEngine();
     void applyThemeAndFontSettings();
     ///@}
     
@@ -152,14 +186,37 @@ private:
     QDockWidget *m_fileBrowserDock = nullptr; /**< Dock widget for the file browser. */
     QTabWidget *m_tabWidget = nullptr;        /**< Widget for managing editor tabs. */
     QSplitter *m_mainSplitter = nullptr;      /**< Main splitter for resizable panels. */
+    QSplitter *m_editorSplitter = nullptr;    /**< Holds the tabs and the split view beside or below them. */
+    EditorWidget *m_splitView = nullptr;      /**< Second view on the current document, while split. */
     
     // File System
     QFileSystemModel *m_fileSystemModel = nullptr;  /**< Model for the file system. */
     QTreeView *m_fileBrowser = nullptr;             /**< Tree view for file system navigation. */
     
     // Web Preview
-    QWebEngineView *m_webView = nullptr;      /**< Web view for previewing content. */
-    QWebChannel m_webChannel;                 /**< Channel for communication with web content. */
+    QWebEngineView *m_webView = nullptr;      /**< Web view for previewing content, created on first use. */
+    QLabel *m_previewPlaceholder = nullptr;   /**< Stands in for the web view until it is created. */
+    bool m_previewPrewarmScheduled = false;   /**< Whether the idle pre-warm has been scheduled. */
+    PreviewScheduler *m_previewScheduler = nullptr; /**< Coalesces edits into preview renders. */
+    PreviewPageCache *m_pageCache = nullptr;  /**< Preview pages of the open editors. */
+    QPointer<PreviewBridge> m_previewBridge;  /**< Bridge of the page on screen. */
+    PreviewSchemeHandler *m_schemeHandler = nullptr; /**< Serves workspace files and buffers to the preview. */
+    DevServer *m_devServer = nullptr;         /**< Serves the folder to external browsers. */
+    QPointer<EditorWidget> m_lastHtmlEditor;  /**< Editor of the HTML page last shown in the preview. */
+    QLabel *m_previewLatencyLabel = nullptr;  /**< Shows the latency of the last preview render. */
+    QProgressBar *m_loadProgressBar = nullptr; /**< Progress of a file loading in the background. */
+    QToolButton *m_cancelLoadButton = nullptr; /**< Cancels the background load of the current file. */
+    QThreadPool *m_decodePool = nullptr;      /**< Reads and decodes files opened together. */
+    FileWatcher *m_fileWatcher = nullptr;     /**< Reports changes other programs make to open files. */
+    QSet<QString> m_diskChangePrompts;        /**< Files whose disk change the user is being asked about. */
+    QTimer *m_prewarmTimer = nullptr;         /**< Loads the tabs next to the current one once idle. */
+    DocumentManager *m_documents = nullptr;   /**< Open files by canonical path and identity. */
+    TabHibernator *m_hibernator = nullptr;    /**< Hibernates idle tabs beyond the memory budget. */
+    QLabel *m_memoryLabel = nullptr;          /**< Shows the memory the open tabs use against the budget. */
+    int m_openBatches = 0;                    /**< Number of openFiles() batches still decoding. */
+    QSet<EditorWidget*> m_saveAllPending;     /**< Editors whose Save All write is in progress. */
+    QStringList m_saveAllErrors;              /**< Failures of the Save All in progress. */
+    QString m_lastSearchText;                 /**< Text of the last Find. */
     
     // File Actions
     QAction *m_newFileAction = nullptr;       /**< Action for creating a new file. */
@@ -167,6 +224,7 @@ private:
     QAction *m_openFolderAction = nullptr;    /**< Action for opening a folder. */
     QAction *m_saveAction = nullptr;          /**< Action for saving the current file. */
     QAction *m_saveAsAction = nullptr;        /**< Action for saving the current file with a new name. */
+    QAction *m_saveAllAction = nullptr;       /**< Action for saving all modified files. */
     QAction *m_closeTabAction = nullptr;      /**< Action for closing the current tab. */
     QAction *m_exitAction = nullptr;          /**< Action for exiting the application. */
     QAction *m_togglePreviewAction = nullptr;
@@ -181,6 +239,7 @@ private:
     QAction *m_resetFontSizeAction = nullptr;
     QAction *m_aboutAction = nullptr;
     QAction *m_runAction = nullptr;
+    QAction *m_unsplitAction = nullptr;       /**< Action for closing the split view. */
     QList<QAction*> m_recentFileActions;
     
     // State
@@ -203,9 +262,65 @@ private:
     void loadSettings();
     void saveSettings();
     EditorWidget *currentEditor() const;
+    EditorWidget *focusedEditor() const;
+    void updateSplitView();
     EditorWidget *editorForPath(const QString &filePath) const;
+    QWidget *tabForPath(const QString &filePath) const;
+    HugeFileView *currentHugeFileView() const;
+    HugeFileView *createHugeFileTab(const QString &filePath, int index, bool makeCurrent, QString *errorString);
     bool maybeSave(EditorWidget *editor);
-    void createNewEditorTab(const QString &filePath = QString());
+    bool previewStylesheet(const QString &filePath, const QString &css);
+    void loadPreviewDocument(const QUrl &url, const QString &html);
+    void setPreviewVisible(bool visible);
+    QWidget *previewWidget() const;
+    bool unsavedContents(const QString &filePath, TextSnapshot *contents) const;
+    QUrl browserUrlForEditor(EditorWidget *editor);
+    void updateLoadIndicator();
+    EditorWidget *createNewEditorTab(const QString &filePath = QString(), int index = -1, bool makeCurrent = true);
+    
+    /**
+     * @brief Files of one openFiles() call, while they are being decoded.
+     */
+    struct OpenBatch
+    {
+        QStringList filePaths;       /**< Files to open, in tab order. */
+        QStringList existing;        /**< Requested files that were already open. */
+        QVector<bool> created;       /**< Whether the tab of each file has been created. */
+        QStringList errors;          /**< Files that could not be opened. */
+        QString currentFilePath;     /**< File whose tab becomes current. */
+        int firstIndex = 0;          /**< Tab index of the first file. */
+        int remaining = 0;           /**< Files still being decoded. */
+    };
+    void addBatchFile(const QSharedPointer<OpenBatch> &batch, int index,
+                      const TextDecoder::Result *content, const QString &errorString);
+    void finishOpenBatch(const QSharedPointer<OpenBatch> &batch);
+    void restoreSession();
+    QWidget *materializeTab(TabPlaceholder *placeholder, const TextDecoder::Result *content);
+    void prewarmTabs();
+    void recoverJournals();
+    void addRecentFiles(const QStringList &filePaths);
+    void handleSaveFinished(EditorWidget *editor, bool ok, const QString &filePath,
+                            const QString &errorString);
+    void reportSaveAll();
+    
+    /**
+     * @brief A change of an open file on disk, compared with its editor.
+     */
+    struct DiskChange
+    {
+        QString filePath;            /**< The file. */
+        quint64 revision = 0;        /**< Revision of the editor text the change was compared with. */
+        bool changed = false;        /**< Whether the file differs from the text last loaded or saved. */
+        bool removed = false;        /**< Whether the file no longer exists. */
+        QString errorString;         /**< Why the file could not be read, if it could not. */
+        TextSnapshot diskText;       /**< The new text of the file. */
+        QVector<TextDiff::LineEdit> edits;       /**< Turn the editor text into the file. */
+        QVector<TextDiff::LineEdit> mergeEdits;  /**< Turn the editor text into the merge with the file. */
+        int conflicts = 0;           /**< Conflicts left by the merge. */
+    };
+    void updateWatchedFiles();
+    void checkChangedFiles(const QStringList &filePaths);
+    void applyDiskChange(EditorWidget *editor, const DiskChange &change);
 };
 
 #endif // MAINWINDOW_H
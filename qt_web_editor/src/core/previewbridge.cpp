@@ -0,0 +1,401 @@
+/**
+ * @file previewbridge.cpp
+ * @brief Implementation of the PreviewBridge class.
+ *
+ * This file contains the implementation of the bridge between the editor and
+ * the hot-update runtime running inside the preview page.
+ */
+
+#include "previewbridge.h"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+#include <QDebug>
+
+namespace {
+/**
+ * @brief Reads a script from the resource system.
+ *
+ * @param path Resource path of the script.
+ * @return The script source, or an empty string on failure.
+ */
+QString readScript(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Could not read preview runtime script:" << path;
+        return QString();
+    }
+    return QString::fromUtf8(file.readAll());
+}
+}
+
+/**
+ * @brief Constructs a PreviewBridge with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+PreviewBridge::PreviewBridge(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Attaches the bridge to the page it updates.
+ *
+ * The runtime is injected into the application world, next to the web channel
+ * transport, so it cannot clash with the scripts of the previewed page.
+ *
+ * @param page The preview page.
+ */
+void PreviewBridge::attachPage(QWebEnginePage *page)
+{
+    if (m_page) {
+        disconnect(m_page, nullptr, this, nullptr);
+    }
+    m_page = page;
+    invalidate();
+
+    if (!page) {
+        return;
+    }
+
+    QWebEngineScript script;
+    script.setName(QStringLiteral("rapid-live-preview"));
+    script.setSourceCode(readScript(QStringLiteral(":/qtwebchannel/qwebchannel.js"))
+                         + QLatin1Char('\n')
+                         + readScript(QStringLiteral(":/preview/livepreview.js")));
+    script.setInjectionPoint(QWebEngineScript::DocumentReady);
+    script.setWorldId(QWebEngineScript::ApplicationWorld);
+    script.setRunsOnSubFrames(false);
+    page->scripts().insert(script);
+
+    // Any navigation we did not start leaves a document we know nothing about
+    connect(page, &QWebEnginePage::loadStarted, this, [this]() {
+        if (m_state != State::Loading) {
+            invalidate();
+        }
+    });
+    connect(page, &QWebEnginePage::loadFinished, this, [this](bool ok) {
+        if (!ok && m_state == State::Loading) {
+            invalidate();
+        }
+    });
+}
+
+/**
+ * @brief Records that a full load of @p html is about to start.
+ *
+ * @param documentUrl Identifies the document (its base URL).
+ * @param html The complete source being loaded.
+ */
+void PreviewBridge::beginLoad(const QUrl &documentUrl, const QString &html)
+{
+    // Replaced stylesheets only carry over to reloads of the same document
+    if (documentUrl != m_documentUrl) {
+        m_stylesheets.clear();
+    }
+
+    invalidate();
+    m_state = State::Loading;
+    m_documentUrl = documentUrl;
+    m_html = html;
+}
+
+/**
+ * @brief Tries to bring the loaded page up to date with @p html in place.
+ *
+ * Only the body content may differ from the loaded source. The changed region
+ * is the span between the longest common prefix and suffix of the old and new
+ * body sources; it is sent to the runtime as a splice.
+ *
+ * @param documentUrl Identifies the document (its base URL).
+ * @param html The complete, current source of the document.
+ * @return What the caller has to do next.
+ */
+PreviewBridge::PatchResult PreviewBridge::patch(const QUrl &documentUrl, const QString &html)
+{
+    if (m_state != State::Ready || m_pendingSerial >= 0 || documentUrl != m_documentUrl) {
+        return PatchResult::ReloadRequired;
+    }
+
+    int oldStart = 0, oldEnd = 0, newStart = 0, newEnd = 0;
+    if (!findBody(m_html, &oldStart, &oldEnd) || !findBody(html, &newStart, &newEnd)) {
+        return PatchResult::ReloadRequired;
+    }
+
+    // Everything outside the body content must be untouched
+    const QStringView oldView(m_html);
+    const QStringView newView(html);
+    if (oldView.left(oldStart) != newView.left(newStart)
+        || oldView.mid(oldEnd) != newView.mid(newEnd)) {
+        return PatchResult::ReloadRequired;
+    }
+
+    const QStringView oldBody = oldView.mid(oldStart, oldEnd - oldStart);
+    const QStringView newBody = newView.mid(newStart, newEnd - newStart);
+    if (oldBody == newBody) {
+        m_html = html;
+        return PatchResult::Unchanged;
+    }
+
+    // Narrow the change down to the region between the common prefix and suffix
+    const int shorter = qMin(oldBody.size(), newBody.size());
+    int prefix = 0;
+    while (prefix < shorter && oldBody[prefix] == newBody[prefix]) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < shorter - prefix
+           && oldBody[oldBody.size() - 1 - suffix] == newBody[newBody.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    const int removed = int(oldBody.size()) - prefix - suffix;
+    const int insertedLength = int(newBody.size()) - prefix - suffix;
+    const QString body = newBody.toString();
+    if (touchesScript(body, prefix, insertedLength, oldBody.mid(prefix, removed).toString())) {
+        return PatchResult::ReloadRequired;
+    }
+
+    m_html = html;
+    const int baseSerial = m_serial++;
+    m_pendingSerial = m_serial;
+    emit bodyPatched(m_serial, baseSerial, prefix, removed, body.mid(prefix, insertedLength));
+    return PatchResult::Patched;
+}
+
+/**
+ * @brief Tries to replace a stylesheet of the loaded page in place.
+ *
+ * @param documentUrl Identifies the document the stylesheet belongs to.
+ * @param stylesheetUrl Absolute URL of the linked stylesheet.
+ * @param css The new contents of the stylesheet.
+ * @return What the caller has to do next.
+ */
+PreviewBridge::PatchResult PreviewBridge::updateStylesheet(const QUrl &documentUrl,
+                                                           const QUrl &stylesheetUrl,
+                                                           const QString &css)
+{
+    if (m_state != State::Ready || m_pendingSerial >= 0 || documentUrl != m_documentUrl) {
+        return PatchResult::ReloadRequired;
+    }
+
+    const QString url = stylesheetUrl.toString(QUrl::FullyEncoded);
+    const auto it = m_stylesheets.constFind(url);
+    if (it != m_stylesheets.constEnd() && *it == css) {
+        return PatchResult::Unchanged;
+    }
+
+    m_stylesheets.insert(url, css);
+    m_pendingSerial = ++m_serial;
+    emit stylesheetUpdated(m_serial, url, css);
+    return PatchResult::Patched;
+}
+
+/**
+ * @brief Queues a stylesheet replacement applied once the next load is ready.
+ *
+ * @param stylesheetUrl Absolute URL of the linked stylesheet.
+ * @param css The contents to use instead of the linked file.
+ */
+void PreviewBridge::setStylesheetOverride(const QUrl &stylesheetUrl, const QString &css)
+{
+    m_stylesheets.insert(stylesheetUrl.toString(QUrl::FullyEncoded), css);
+}
+
+/**
+ * @brief Checks whether the loaded page already shows a revision of a document.
+ *
+ * A patch still waiting for the runtime counts as shown: if it fails, the page
+ * is invalidated and a reload is requested.
+ *
+ * @param documentUrl Identifies the document (its base URL).
+ * @param revision The revision of the editor text.
+ * @return True if rendering that revision again would change nothing.
+ */
+bool PreviewBridge::isShowing(const QUrl &documentUrl, quint64 revision) const
+{
+    return m_state == State::Ready && m_sourceRevision != 0 && m_sourceRevision == revision
+        && documentUrl == m_documentUrl;
+}
+
+/**
+ * @brief Forgets the loaded document so the next update reloads the page.
+ */
+void PreviewBridge::invalidate()
+{
+    m_state = State::Detached;
+    m_html.clear();
+    m_sourceRevision = 0;
+
+    if (m_pendingSerial >= 0) {
+        m_pendingSerial = -1;
+        emit patchFinished(false);
+    }
+}
+
+/**
+ * @brief Called by the runtime once it is connected in a freshly loaded page.
+ *
+ * Hands the runtime the body source that subsequent splices refer to.
+ */
+void PreviewBridge::runtimeReady()
+{
+    if (m_state != State::Loading) {
+        return;
+    }
+
+    m_state = State::Ready;
+
+    int start = 0, end = 0;
+    if (findBody(m_html, &start, &end)) {
+        emit sourceReset(++m_serial, m_html.mid(start, end - start));
+    }
+
+    // Bring back the stylesheets that were replaced before the reload
+    for (auto it = m_stylesheets.constBegin(); it != m_stylesheets.constEnd(); ++it) {
+        emit stylesheetUpdated(++m_serial, it.key(), it.value());
+    }
+}
+
+/**
+ * @brief Called by the runtime after it has applied (or failed to apply) a patch.
+ *
+ * @param serial The serial number of the patch.
+ * @param ok Whether the live DOM now reflects the new source.
+ */
+void PreviewBridge::patchApplied(int serial, bool ok)
+{
+    if (serial != m_pendingSerial) {
+        return;
+    }
+    m_pendingSerial = -1;
+
+    if (ok) {
+        emit patchFinished(true);
+        return;
+    }
+
+    invalidate();
+    emit patchFinished(false);
+    emit reloadRequested();
+}
+
+/**
+ * @brief Called by the runtime after it has replaced a stylesheet.
+ *
+ * @param serial The serial number of the update.
+ * @param ok Whether a matching stylesheet was found and replaced.
+ */
+void PreviewBridge::stylesheetApplied(int serial, bool ok)
+{
+    if (serial != m_pendingSerial) {
+        return;
+    }
+    m_pendingSerial = -1;
+    emit patchFinished(ok);
+}
+
+/**
+ * @brief Lists the stylesheets an HTML document links to.
+ *
+ * @param documentUrl The URL relative links are resolved against.
+ * @param html The document source.
+ * @return The absolute URLs of all linked stylesheets.
+ */
+QList<QUrl> PreviewBridge::linkedStylesheets(const QUrl &documentUrl, const QString &html)
+{
+    static const QRegularExpression linkTag(QStringLiteral("<link\\b[^>]*>"),
+                                            QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression relAttribute(QStringLiteral("\\brel\\s*=\\s*[\"']?[^\"'>]*\\bstylesheet\\b"),
+                                                 QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression hrefAttribute(QStringLiteral("\\bhref\\s*=\\s*(?:\"([^\"]*)\"|'([^']*)'|([^\\s>]+))"),
+                                                  QRegularExpression::CaseInsensitiveOption);
+
+    QList<QUrl> stylesheets;
+    QRegularExpressionMatchIterator it = linkTag.globalMatch(html);
+    while (it.hasNext()) {
+        const QString tag = it.next().captured();
+        if (!relAttribute.match(tag).hasMatch()) {
+            continue;
+        }
+
+        const QRegularExpressionMatch href = hrefAttribute.match(tag);
+        if (!href.hasMatch()) {
+            continue;
+        }
+
+        QString target = href.captured(1);
+        if (target.isEmpty()) target = href.captured(2);
+        if (target.isEmpty()) target = href.captured(3);
+
+        stylesheets.append(documentUrl.resolved(QUrl(target.trimmed())).adjusted(QUrl::NormalizePathSegments));
+    }
+    return stylesheets;
+}
+
+/**
+ * @brief Locates the body content of an HTML document.
+ *
+ * @param html The document source.
+ * @param start Receives the index just after the body start tag.
+ * @param end Receives the index of the body end tag.
+ * @return True if both body tags were found.
+ */
+bool PreviewBridge::findBody(const QString &html, int *start, int *end)
+{
+    static const QRegularExpression bodyStart(QStringLiteral("<body\\b[^>]*>"),
+                                              QRegularExpression::CaseInsensitiveOption);
+
+    const QRegularExpressionMatch match = bodyStart.match(html);
+    if (!match.hasMatch()) {
+        return false;
+    }
+
+    const int contentStart = int(match.capturedEnd());
+    const int contentEnd = int(html.lastIndexOf(QLatin1String("</body"), -1, Qt::CaseInsensitive));
+    if (contentEnd < contentStart) {
+        return false;
+    }
+
+    *start = contentStart;
+    *end = contentEnd;
+    return true;
+}
+
+/**
+ * @brief Checks whether a splice touches or lies inside a script element.
+ *
+ * Scripts must run exactly as the browser would run them on load, so any edit
+ * that involves one is left to a full reload.
+ *
+ * @param body The new body source.
+ * @param position Start of the changed region.
+ * @param length Length of the changed region in @p body.
+ * @param removedText The text the splice removes.
+ * @return True if the change involves a script.
+ */
+bool PreviewBridge::touchesScript(const QString &body, int position, int length, const QString &removedText)
+{
+    const QLatin1String open("<script");
+    const QLatin1String close("</script");
+
+    if (removedText.contains(open, Qt::CaseInsensitive) || removedText.contains(close, Qt::CaseInsensitive)) {
+        return true;
+    }
+
+    const QStringView inserted = QStringView(body).mid(position, length);
+    if (inserted.contains(open, Qt::CaseInsensitive) || inserted.contains(close, Qt::CaseInsensitive)) {
+        return true;
+    }
+
+    // Look back far enough to catch a tag the edit completes, e.g. "<scrip" + "t"
+    const int from = qMin(int(body.size()) - 1, position + length);
+    const int lastOpen = from < 0 ? -1 : int(body.lastIndexOf(open, from, Qt::CaseInsensitive));
+    const int lastClose = from < 0 ? -1 : int(body.lastIndexOf(close, from, Qt::CaseInsensitive));
+    return lastOpen > lastClose;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file previewbridge.h
+ * @brief Declaration of the PreviewBridge class.
+ *
+ * This file contains the PreviewBridge class which is published on the preview's
+ * QWebChannel and lets the editor update the rendered page in place instead of
+ * reloading it for every change.
+ */
+
+#ifndef PREVIEWBRIDGE_H
+#define PREVIEWBRIDGE_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+#include <QHash>
+#include <QList>
+
+class QWebEnginePage;
+
+/**
+ * @brief The PreviewBridge class drives the live preview's hot-update runtime.
+ *
+ * A small runtime (resources/preview/livepreview.js) is injected into every
+ * preview page. Once the page has loaded, the bridge hands the runtime the source
+ * of the document body. Later edits that only touch the body are sent as a text
+ * splice of the changed region; the runtime applies the splice to its copy of the
+ * source, re-parses it and morphs the live DOM so that only the nodes that really
+ * changed are touched. Scroll position, form state and script state survive.
+ *
+ * Changes to the head, to the body element itself or to any script fall back to a
+ * full reload, as does any failure reported by the runtime.
+ *
+ * Stylesheets linked by the loaded document can be replaced in place as well:
+ * the runtime swaps the matching link (or a previously swapped style element)
+ * for a style element carrying the new rules, without reloading or re-running
+ * any script. Replaced stylesheets are remembered per document and re-applied
+ * after each reload of that document.
+ */
+class PreviewBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The outcome of an attempt to hot-update the preview.
+     */
+    enum class PatchResult {
+        Unchanged,      /**< The body is identical; nothing needs to happen. */
+        Patched,        /**< A patch was sent; patchFinished() will follow. */
+        ReloadRequired  /**< The change cannot be patched; load the page instead. */
+    };
+    Q_ENUM(PatchResult)
+
+    /**
+     * @brief Constructs a PreviewBridge with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit PreviewBridge(QObject *parent = nullptr);
+
+    /**
+     * @brief Attaches the bridge to the page it updates.
+     *
+     * Installs the runtime script on the page and tracks its navigations so
+     * that patches are never applied to a document the bridge did not load.
+     *
+     * @param page The preview page.
+     */
+    void attachPage(QWebEnginePage *page);
+
+    /**
+     * @brief Records that a full load of @p html is about to start.
+     *
+     * @param documentUrl Identifies the document (its base URL).
+     * @param html The complete source being loaded.
+     */
+    void beginLoad(const QUrl &documentUrl, const QString &html);
+
+    /**
+     * @brief Tries to bring the loaded page up to date with @p html in place.
+     *
+     * @param documentUrl Identifies the document (its base URL).
+     * @param html The complete, current source of the document.
+     * @return What the caller has to do next.
+     */
+    PatchResult patch(const QUrl &documentUrl, const QString &html);
+
+    /**
+     * @brief Tries to replace a stylesheet of the loaded page in place.
+     *
+     * @param documentUrl Identifies the document the stylesheet belongs to.
+     * @param stylesheetUrl Absolute URL of the linked stylesheet.
+     * @param css The new contents of the stylesheet.
+     * @return What the caller has to do next.
+     */
+    PatchResult updateStylesheet(const QUrl &documentUrl, const QUrl &stylesheetUrl, const QString &css);
+
+    /**
+     * @brief Queues a stylesheet replacement applied once the next load is ready.
+     *
+     * Must be called after beginLoad() for the document it applies to.
+     *
+     * @param stylesheetUrl Absolute URL of the linked stylesheet.
+     * @param css The contents to use instead of the linked file.
+     */
+    void setStylesheetOverride(const QUrl &stylesheetUrl, const QString &css);
+
+    /**
+     * @brief Forgets the loaded document so the next update reloads the page.
+     */
+    void invalidate();
+
+    /** @return The document the preview shows or was last asked to load. */
+    QUrl documentUrl() const { return m_documentUrl; }
+
+    /**
+     * @brief Records which revision of the editor text the source given last was made from.
+     *
+     * @param revision The revision, as reported by TextSnapshot::revision().
+     */
+    void setSourceRevision(quint64 revision) { m_sourceRevision = revision; }
+
+    /**
+     * @brief Checks whether the loaded page already shows a revision of a document.
+     *
+     * @param documentUrl Identifies the document (its base URL).
+     * @param revision The revision of the editor text.
+     * @return True if rendering that revision again would change nothing.
+     */
+    bool isShowing(const QUrl &documentUrl, quint64 revision) const;
+
+    /**
+     * @brief Lists the stylesheets an HTML document links to.
+     *
+     * @param documentUrl The URL relative links are resolved against.
+     * @param html The document source.
+     * @return The absolute URLs of all linked stylesheets.
+     */
+    static QList<QUrl> linkedStylesheets(const QUrl &documentUrl, const QString &html);
+
+    /** @return True if the runtime in the current page can accept patches. */
+    bool isReady() const { return m_state == State::Ready; }
+
+public slots:
+    /**
+     * @brief Called by the runtime once it is connected in a freshly loaded page.
+     */
+    void runtimeReady();
+
+    /**
+     * @brief Called by the runtime after it has applied (or failed to apply) a patch.
+     *
+     * @param serial The serial number of the patch.
+     * @param ok Whether the live DOM now reflects the new source.
+     */
+    void patchApplied(int serial, bool ok);
+
+    /**
+     * @brief Called by the runtime after it has replaced a stylesheet.
+     *
+     * Unlike a failed body patch, a stylesheet that cannot be found in the page
+     * does not invalidate the document.
+     *
+     * @param serial The serial number of the update.
+     * @param ok Whether a matching stylesheet was found and replaced.
+     */
+    void stylesheetApplied(int serial, bool ok);
+
+signals:
+    /**
+     * @brief Delivers the body source the following splices are relative to.
+     *
+     * @param serial Serial number of this base revision.
+     * @param bodySource The source between the body start and end tags.
+     */
+    void sourceReset(int serial, const QString &bodySource);
+
+    /**
+     * @brief Delivers a text splice of the body source to the runtime.
+     *
+     * @param serial Serial number of the resulting revision.
+     * @param baseSerial Serial number the splice applies to.
+     * @param position Start of the changed region in the body source.
+     * @param removed Number of characters replaced at @p position.
+     * @param inserted Replacement text.
+     */
+    void bodyPatched(int serial, int baseSerial, int position, int removed, const QString &inserted);
+
+    /**
+     * @brief Delivers new contents for a linked stylesheet to the runtime.
+     *
+     * @param serial Serial number of the update.
+     * @param url Absolute URL of the stylesheet as written in the page.
+     * @param css The new contents of the stylesheet.
+     */
+    void stylesheetUpdated(int serial, const QString &url, const QString &css);
+
+    /**
+     * @brief Emitted when an update sent by patch() or updateStylesheet() has been processed.
+     *
+     * @param ok Whether the patch succeeded.
+     */
+    void patchFinished(bool ok);
+
+    /**
+     * @brief Emitted when the runtime could not patch and a reload is needed.
+     */
+    void reloadRequested();
+
+private:
+    /**
+     * @brief The lifecycle of the document shown in the preview.
+     */
+    enum class State {
+        Detached,   /**< The page shows nothing the bridge can patch. */
+        Loading,    /**< A load started by beginLoad() is in progress. */
+        Ready       /**< The runtime holds the current body source. */
+    };
+
+    /**
+     * @brief Locates the body content of an HTML document.
+     *
+     * @param html The document source.
+     * @param start Receives the index just after the body start tag.
+     * @param end Receives the index of the body end tag.
+     * @return True if both body tags were found.
+     */
+    static bool findBody(const QString &html, int *start, int *end);
+
+    /**
+     * @brief Checks whether a splice touches or lies inside a script element.
+     *
+     * @param body The new body source.
+     * @param position Start of the changed region.
+     * @param length Length of the changed region in @p body.
+     * @param removedText The text the splice removes.
+     * @return True if the change involves a script.
+     */
+    static bool touchesScript(const QString &body, int position, int length, const QString &removedText);
+
+    QPointer<QWebEnginePage> m_page;  /**< The page the runtime lives in. */
+    State m_state = State::Detached;  /**< State of the current document. */
+    QUrl m_documentUrl;               /**< Identifies the loaded document. */
+    QString m_html;                   /**< Source the live DOM currently reflects. */
+    quint64 m_sourceRevision = 0;     /**< Revision of the editor text m_html was made from, or 0. */
+    int m_serial = 0;                 /**< Serial number of the newest revision. */
+    int m_pendingSerial = -1;         /**< Patch awaiting acknowledgement, or -1. */
+    QHash<QString, QString> m_stylesheets; /**< Replaced stylesheets of the document, by URL. */
+};
+
+#endif // PREVIEWBRIDGE_H
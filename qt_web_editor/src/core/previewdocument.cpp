@@ -0,0 +1,69 @@
+/**
+ * @file previewdocument.cpp
+ * @brief Implementation of the PreviewDocument class.
+ *
+ * This file contains the page templates used to preview each kind of file.
+ */
+
+#include "previewdocument.h"
+
+#include <QFileInfo>
+
+/**
+ * @brief Builds the HTML shown in the preview for a file.
+ *
+ * @param filePath Path of the file; its suffix selects the kind of page.
+ * @param content Current contents of the file.
+ * @return The complete HTML document.
+ */
+QString PreviewDocument::htmlFor(const QString &filePath, const QString &content)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+
+    if (suffix == "html" || suffix == "htm") {
+        // For HTML files, use the content directly
+        return content;
+    }
+
+    if (suffix == "css") {
+        // For CSS files, create a simple HTML wrapper
+        return QString(
+            "<!DOCTYPE html>\n"
+            "<html>\n"
+            "<head>\n"
+            "    <meta charset=\"UTF-8\">\n"
+            "    <title>CSS Preview</title>\n"
+            "    <style>\n%1\n    </style>\n"
+            "</head>\n"
+            "<body>\n"
+            "    <h1>CSS Preview</h1>\n"
+            "    <p>This is a preview of your CSS. The actual effect will be visible when used with HTML.</p>\n"
+            "    <div class=\"example\">Example Element</div>\n"
+            "    <div id=\"test\">Test Div</div>\n"
+            "</body>\n"
+            "</html>"
+        ).arg(content);
+    }
+
+    if (suffix == "js") {
+        // For JavaScript files, create a simple HTML wrapper
+        return QString(
+            "<!DOCTYPE html>\n"
+            "<html>\n"
+            "<head>\n"
+            "    <meta charset=\"UTF-8\">\n"
+            "    <title>JavaScript Preview</title>\n"
+            "    <script src=\"https://code.jquery.com/jquery-3.6.0.min.js\"></script>\n"
+            "</head>\n"
+            "<body>\n"
+            "<h1>%1</h1>\n"
+            "<div id=\"output\">Running JavaScript preview...</div>\n"
+            "<script>\n%2\n</script>\n"
+            "</body>\n"
+            "</html>"
+        ).arg(QFileInfo(filePath).fileName(), content);
+    }
+
+    // For other file types, just show the text content
+    return QString("<html><body><pre>%1</pre></body></html>").arg(content.toHtmlEscaped());
+}
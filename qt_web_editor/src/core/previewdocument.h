@@ -0,0 +1,35 @@
+/**
+ * @file previewdocument.h
+ * @brief Declaration of the PreviewDocument class.
+ *
+ * This file contains the PreviewDocument class which turns the contents of an
+ * editor into the HTML document shown in the preview.
+ */
+
+#ifndef PREVIEWDOCUMENT_H
+#define PREVIEWDOCUMENT_H
+
+#include <QString>
+
+/**
+ * @brief The PreviewDocument class builds preview pages for editor contents.
+ *
+ * HTML files are previewed as they are. Stylesheets and scripts are wrapped in
+ * a small page that applies or runs them, and any other file is shown as
+ * escaped plain text. The result depends only on the file name and contents,
+ * so it can be produced and measured without a window or a web engine.
+ */
+class PreviewDocument
+{
+public:
+    /**
+     * @brief Builds the HTML shown in the preview for a file.
+     *
+     * @param filePath Path of the file; its suffix selects the kind of page.
+     * @param content Current contents of the file.
+     * @return The complete HTML document.
+     */
+    static QString htmlFor(const QString &filePath, const QString &content);
+};
+
+#endif // PREVIEWDOCUMENT_H
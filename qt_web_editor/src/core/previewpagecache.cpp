@@ -0,0 +1,269 @@
+/**
+ * @file previewpagecache.cpp
+ * @brief Implementation of the PreviewPageCache class.
+ *
+ * This file contains the implementation of the per-editor pool of preview pages.
+ */
+
+#include "previewpagecache.h"
+#include "previewbridge.h"
+
+#include <QPointer>
+#include <QWebChannel>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <QWebEngineScript>
+#include <QWebEngineView>
+#include <QDebug>
+
+namespace {
+/** Estimated fixed cost of a loaded page (renderer state, compositor, caches). */
+constexpr qint64 kPageBaseCost = 16ll * 1024 * 1024;
+
+/** Discarded pages kept around, in multiples of the capacity, before being deleted. */
+constexpr int kDiscardedFactor = 2;
+
+/** Measures the JavaScript heap and document of a page, in bytes. */
+const QString kMeasureScript = QStringLiteral(
+    "(function () {"
+    "  var heap = (window.performance && performance.memory) ? performance.memory.usedJSHeapSize : 0;"
+    "  var html = document.documentElement ? document.documentElement.outerHTML.length * 2 : 0;"
+    "  return heap + html;"
+    "})()");
+}
+
+/**
+ * @brief Constructs a PreviewPageCache.
+ *
+ * @param profile The profile pages are created in.
+ * @param view The view the active page is shown in.
+ * @param parent The parent QObject.
+ */
+PreviewPageCache::PreviewPageCache(QWebEngineProfile *profile, QWebEngineView *view, QObject *parent)
+    : QObject(parent)
+    , m_profile(profile)
+    , m_view(view)
+    , m_idlePage(new QWebEnginePage(profile, this))
+{
+    m_view->setPage(m_idlePage);
+}
+
+/**
+ * @brief Destroys the cache and all of its pages.
+ */
+PreviewPageCache::~PreviewPageCache()
+{
+    // The view must not be left pointing at a deleted page
+    if (m_view) {
+        m_view->setPage(m_idlePage);
+    }
+    for (Entry *entry : qAsConst(m_entries)) {
+        delete entry->page;
+        delete entry;
+    }
+    m_entries.clear();
+}
+
+/**
+ * @brief Sets how many pages are kept loaded, including the active one.
+ *
+ * @param pages The number of pages, at least 1.
+ */
+void PreviewPageCache::setCapacity(int pages)
+{
+    m_capacity = qMax(1, pages);
+    trim();
+}
+
+/**
+ * @brief Sets the estimated memory the loaded pages may use.
+ *
+ * @param bytes The budget in bytes.
+ */
+void PreviewPageCache::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    trim();
+}
+
+/**
+ * @brief Shows the page of an editor, creating it if needed.
+ *
+ * A page that was discarded, or that was hidden while other files changed,
+ * has its bridge invalidated so the next render reloads it. Otherwise the page
+ * is shown exactly as it was left.
+ *
+ * @param key The editor the page belongs to; its destruction removes the page.
+ * @return The bridge of the activated page.
+ */
+PreviewBridge *PreviewPageCache::activate(QObject *key)
+{
+    Entry *entry = nullptr;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i)->key == key) {
+            entry = m_entries.takeAt(i);
+            break;
+        }
+    }
+
+    if (!entry) {
+        entry = createEntry(key);
+    } else if (m_view->page() != entry->page
+               && (entry->page->lifecycleState() == QWebEnginePage::LifecycleState::Discarded
+                   || entry->revision != m_revision)) {
+        // Edits made while the page is on screen reach it; others may not have
+        entry->bridge->invalidate();
+    }
+
+    // Remember what the page that is leaving the screen has seen
+    if (!m_entries.isEmpty() && m_view->page() == m_entries.first()->page) {
+        m_entries.first()->revision = m_revision;
+    }
+
+    m_entries.prepend(entry);
+    entry->revision = m_revision;
+    if (m_view->page() != entry->page) {
+        entry->page->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+        m_view->setPage(entry->page);
+    }
+
+    trim();
+    return entry->bridge;
+}
+
+/**
+ * @brief Returns the bridge of the page on screen.
+ *
+ * @return The bridge, or nullptr if no editor is active.
+ */
+PreviewBridge *PreviewPageCache::currentBridge() const
+{
+    if (m_entries.isEmpty() || m_view->page() != m_entries.first()->page) {
+        return nullptr;
+    }
+    return m_entries.first()->bridge;
+}
+
+/**
+ * @brief Creates the page, channel and bridge for an editor.
+ *
+ * @param key The editor the page belongs to.
+ * @return The new entry; the caller inserts it into the list.
+ */
+PreviewPageCache::Entry *PreviewPageCache::createEntry(QObject *key)
+{
+    auto *entry = new Entry;
+    entry->key = key;
+    entry->page = new QWebEnginePage(m_profile, this);
+    entry->channel = new QWebChannel(entry->page);
+    entry->bridge = new PreviewBridge(entry->page);
+    entry->estimatedBytes = kPageBaseCost;
+
+    // Publish the live preview bridge and inject its runtime into the page
+    entry->page->setWebChannel(entry->channel, QWebEngineScript::ApplicationWorld);
+    entry->channel->registerObject(QStringLiteral("rapidPreview"), entry->bridge);
+    entry->bridge->attachPage(entry->page);
+
+    QWebEnginePage *page = entry->page;
+    connect(page, &QWebEnginePage::loadFinished, this, [this, page](bool ok) {
+        if (ok) {
+            measure(page);
+        }
+    });
+    connect(key, &QObject::destroyed, this, [this, key]() { remove(key); });
+
+    emit bridgeCreated(entry->bridge);
+    return entry;
+}
+
+/**
+ * @brief Deletes the page of an editor that went away.
+ *
+ * @param key The editor.
+ */
+void PreviewPageCache::remove(QObject *key)
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        Entry *entry = m_entries.at(i);
+        if (entry->key != key) {
+            continue;
+        }
+        if (m_view->page() == entry->page) {
+            m_view->setPage(m_idlePage);
+        }
+        m_entries.removeAt(i);
+        entry->page->deleteLater();
+        delete entry;
+        return;
+    }
+}
+
+/**
+ * @brief Updates the memory estimate of a page after it has loaded.
+ *
+ * @param page The page that has loaded.
+ */
+void PreviewPageCache::measure(QWebEnginePage *page)
+{
+    QPointer<QWebEnginePage> guard(page);
+    page->runJavaScript(kMeasureScript, QWebEngineScript::ApplicationWorld,
+                        [this, guard](const QVariant &result) {
+        if (!guard) {
+            return;
+        }
+        for (Entry *entry : qAsConst(m_entries)) {
+            if (entry->page == guard) {
+                entry->estimatedBytes = kPageBaseCost + result.toLongLong();
+                trim();
+                return;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Freezes or discards hidden pages to respect the capacity and budget.
+ *
+ * The page on screen is never touched. Hidden pages are frozen, most recently
+ * used first, while they fit; the rest are discarded, and discarded pages far
+ * down the list are deleted outright.
+ */
+void PreviewPageCache::trim()
+{
+    int loadedPages = 0;
+    qint64 loadedBytes = 0;
+
+    for (int i = 0; i < m_entries.size(); ++i) {
+        Entry *entry = m_entries.at(i);
+        QWebEnginePage *page = entry->page;
+
+        if (page == m_view->page()) {
+            ++loadedPages;
+            loadedBytes += entry->estimatedBytes;
+            continue;
+        }
+
+        const bool fits = loadedPages < m_capacity && loadedBytes + entry->estimatedBytes <= m_memoryBudget;
+        const auto state = page->lifecycleState();
+        if (fits && state != QWebEnginePage::LifecycleState::Discarded) {
+            ++loadedPages;
+            loadedBytes += entry->estimatedBytes;
+            if (state == QWebEnginePage::LifecycleState::Active && !page->isVisible()) {
+                page->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+            }
+        } else if (state != QWebEnginePage::LifecycleState::Discarded && !page->isVisible()) {
+            page->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+        }
+    }
+
+    // Keep the pool bounded: even discarded pages hold their history
+    while (m_entries.size() > m_capacity * kDiscardedFactor) {
+        Entry *entry = m_entries.last();
+        if (entry->page == m_view->page()) {
+            break;
+        }
+        m_entries.removeLast();
+        entry->page->deleteLater();
+        delete entry;
+    }
+}
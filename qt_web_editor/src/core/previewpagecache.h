@@ -0,0 +1,133 @@
+/**
+ * @file previewpagecache.h
+ * @brief Declaration of the PreviewPageCache class.
+ *
+ * This file contains the PreviewPageCache class which keeps a rendered preview
+ * page per editor so that switching tabs does not reload the preview.
+ */
+
+#ifndef PREVIEWPAGECACHE_H
+#define PREVIEWPAGECACHE_H
+
+#include <QObject>
+#include <QList>
+
+class QWebChannel;
+class QWebEnginePage;
+class QWebEngineProfile;
+class QWebEngineView;
+class PreviewBridge;
+
+/**
+ * @brief The PreviewPageCache class pools preview pages, one per editor.
+ *
+ * Each editor gets its own QWebEnginePage with its own web channel and
+ * PreviewBridge. Activating an editor shows its page in the preview view; a page
+ * that is still loaded comes back with its scroll position and script state
+ * intact, and the bridge can keep patching it in place.
+ *
+ * Pages are kept in most-recently-used order. The page on screen is Active.
+ * Hidden pages are Frozen, which keeps their state but stops their scripts, for
+ * as long as they fit both the page limit and the memory budget; beyond that
+ * they are Discarded, which lets the web engine free them. A discarded page,
+ * or one whose resources may have changed while it was hidden, is invalidated
+ * when it is activated so the next render loads it afresh.
+ *
+ * The memory used by a page is an estimate: a fixed cost per page plus the
+ * page's JavaScript heap and document size, measured after each load.
+ */
+class PreviewPageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a PreviewPageCache.
+     *
+     * @param profile The profile pages are created in.
+     * @param view The view the active page is shown in.
+     * @param parent The parent QObject.
+     */
+    PreviewPageCache(QWebEngineProfile *profile, QWebEngineView *view, QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the cache and all of its pages.
+     */
+    ~PreviewPageCache() override;
+
+    /**
+     * @brief Sets how many pages are kept loaded, including the active one.
+     *
+     * @param pages The number of pages, at least 1.
+     */
+    void setCapacity(int pages);
+
+    /** @return The number of pages kept loaded. */
+    int capacity() const { return m_capacity; }
+
+    /**
+     * @brief Sets the estimated memory the loaded pages may use.
+     *
+     * @param bytes The budget in bytes.
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /** @return The estimated memory the loaded pages may use, in bytes. */
+    qint64 memoryBudget() const { return m_memoryBudget; }
+
+    /**
+     * @brief Shows the page of an editor, creating it if needed.
+     *
+     * @param key The editor the page belongs to; its destruction removes the page.
+     * @return The bridge of the activated page.
+     */
+    PreviewBridge *activate(QObject *key);
+
+    /** @return The bridge of the page on screen, or nullptr. */
+    PreviewBridge *currentBridge() const;
+
+    /**
+     * @brief Notes that the contents of some file in the workspace changed.
+     *
+     * Hidden pages may be showing stale resources afterwards; they are reloaded
+     * the next time they are activated.
+     */
+    void noteWorkspaceChanged() { ++m_revision; }
+
+signals:
+    /**
+     * @brief Emitted when a page and its bridge have been created.
+     *
+     * @param bridge The bridge of the new page.
+     */
+    void bridgeCreated(PreviewBridge *bridge);
+
+private:
+    /**
+     * @brief A cached page and the objects that belong to it.
+     */
+    struct Entry
+    {
+        QObject *key = nullptr;          /**< The editor the page belongs to. */
+        QWebEnginePage *page = nullptr;  /**< The preview page. */
+        QWebChannel *channel = nullptr;  /**< The page's web channel. */
+        PreviewBridge *bridge = nullptr; /**< The page's live preview bridge. */
+        qint64 estimatedBytes = 0;       /**< Estimated memory used by the page. */
+        quint64 revision = 0;            /**< Workspace revision when last on screen. */
+    };
+
+    Entry *createEntry(QObject *key);
+    void remove(QObject *key);
+    void measure(QWebEnginePage *page);
+    void trim();
+
+    QWebEngineProfile *m_profile;          /**< Profile of all pages. */
+    QWebEngineView *m_view;                /**< View the active page is shown in. */
+    QWebEnginePage *m_idlePage = nullptr;  /**< Shown when no editor is active. */
+    QList<Entry*> m_entries;               /**< Cached pages, most recently used first. */
+    int m_capacity = 8;                    /**< Number of pages kept loaded. */
+    qint64 m_memoryBudget = 512ll * 1024 * 1024; /**< Estimated memory budget in bytes. */
+    quint64 m_revision = 0;                /**< Counts workspace changes. */
+};
+
+#endif // PREVIEWPAGECACHE_H
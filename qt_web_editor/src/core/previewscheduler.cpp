@@ -0,0 +1,161 @@
+/**
+ * @file previewscheduler.cpp
+ * @brief Implementation of the PreviewScheduler class.
+ *
+ * This file contains the implementation of the scheduler that turns a stream
+ * of editor changes into a bounded number of preview renders.
+ */
+
+#include "previewscheduler.h"
+
+#include <QtGlobal>
+
+namespace {
+/** Debounce applied before the first render latency has been measured. */
+constexpr int kInitialDebounceMs = 250;
+/** A load that has not finished after this long is considered lost. */
+constexpr int kLoadWatchdogMs = 10000;
+/** Weight of the newest sample in the latency moving average. */
+constexpr double kLatencySmoothing = 0.3;
+/** Multiple of the average latency used as the debounce delay. */
+constexpr double kDebounceFactor = 1.5;
+}
+
+/**
+ * @brief Constructs a PreviewScheduler with the given parent.
+ *
+ * Sets up the single-shot debounce timer and the watchdog that clears the
+ * in-flight state should the web engine never report a finished load.
+ *
+ * @param parent The parent QObject.
+ */
+PreviewScheduler::PreviewScheduler(QObject *parent)
+    : QObject(parent)
+    , m_debounceTimer(new QTimer(this))
+    , m_watchdogTimer(new QTimer(this))
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(kInitialDebounceMs);
+    connect(m_debounceTimer, &QTimer::timeout, this, &PreviewScheduler::dispatch);
+
+    m_watchdogTimer->setSingleShot(true);
+    m_watchdogTimer->setInterval(kLoadWatchdogMs);
+    connect(m_watchdogTimer, &QTimer::timeout, this, [this]() {
+        loadFinished(false);
+    });
+}
+
+/**
+ * @brief Sets the bounds the adaptive debounce delay is clamped to.
+ *
+ * @param minimumMs The shortest delay between an edit and a render.
+ * @param maximumMs The longest delay between an edit and a render.
+ */
+void PreviewScheduler::setDebounceBounds(int minimumMs, int maximumMs)
+{
+    m_minimumDebounce = qMax(0, minimumMs);
+    m_maximumDebounce = qMax(m_minimumDebounce, maximumMs);
+    m_debounceTimer->setInterval(qBound(m_minimumDebounce, m_debounceTimer->interval(), m_maximumDebounce));
+}
+
+/**
+ * @brief Requests a render after the adaptive debounce delay.
+ */
+void PreviewScheduler::schedule()
+{
+    ++m_requestedGeneration;
+    m_debounceTimer->start();
+}
+
+/**
+ * @brief Requests a render as soon as no other load is in flight.
+ */
+void PreviewScheduler::scheduleNow()
+{
+    ++m_requestedGeneration;
+    m_debounceTimer->stop();
+    dispatch();
+}
+
+/**
+ * @brief Drops any render that has been requested but not yet dispatched.
+ */
+void PreviewScheduler::cancel()
+{
+    m_debounceTimer->stop();
+    m_renderPending = false;
+    m_dispatchedGeneration = m_requestedGeneration;
+}
+
+/**
+ * @brief Notifies the scheduler that the requested render started a load.
+ */
+void PreviewScheduler::loadStarted()
+{
+    m_loadInFlight = true;
+    m_watchdogTimer->start();
+}
+
+/**
+ * @brief Notifies the scheduler that the current load has finished.
+ *
+ * Records the render latency and, if edits arrived while loading, dispatches
+ * a single render for the newest state.
+ *
+ * @param ok Whether the load succeeded.
+ */
+void PreviewScheduler::loadFinished(bool ok)
+{
+    // Loads we did not start (e.g. link navigation inside the preview) are ignored
+    if (!m_loadInFlight) {
+        return;
+    }
+
+    m_loadInFlight = false;
+    m_watchdogTimer->stop();
+
+    const qint64 latency = m_renderClock.elapsed();
+    if (ok) {
+        recordLatency(latency);
+    }
+    emit renderCompleted(m_dispatchedGeneration, latency);
+
+    // A pending render waits for the debounce timer if it is still running
+    if (m_renderPending && !m_debounceTimer->isActive()) {
+        dispatch();
+    }
+}
+
+/**
+ * @brief Emits renderRequested() unless a load is already in flight.
+ */
+void PreviewScheduler::dispatch()
+{
+    if (m_loadInFlight) {
+        m_renderPending = true;
+        return;
+    }
+
+    m_renderPending = false;
+    m_dispatchedGeneration = m_requestedGeneration;
+    m_renderClock.start();
+    emit renderRequested(m_dispatchedGeneration);
+}
+
+/**
+ * @brief Folds a latency sample into the average and adapts the debounce.
+ *
+ * @param latencyMs The measured latency of the last render.
+ */
+void PreviewScheduler::recordLatency(qint64 latencyMs)
+{
+    if (m_averageLatency <= 0.0) {
+        m_averageLatency = latencyMs;
+    } else {
+        m_averageLatency = kLatencySmoothing * latencyMs
+                         + (1.0 - kLatencySmoothing) * m_averageLatency;
+    }
+
+    const int interval = qRound(m_averageLatency * kDebounceFactor);
+    m_debounceTimer->setInterval(qBound(m_minimumDebounce, interval, m_maximumDebounce));
+}
@@ -0,0 +1,141 @@
+/**
+ * @file previewscheduler.h
+ * @brief Declaration of the PreviewScheduler class.
+ *
+ * This file contains the PreviewScheduler class which coalesces editor changes
+ * into preview renders, adapts its debounce delay to the observed render cost
+ * and guarantees that at most one web engine load is in flight at a time.
+ */
+
+#ifndef PREVIEWSCHEDULER_H
+#define PREVIEWSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief The PreviewScheduler class decides when the live preview is rendered.
+ *
+ * Every edit calls schedule(), which only (re)starts a debounce timer. When the
+ * timer fires, renderRequested() is emitted once for all edits made since the
+ * previous render. The receiver builds the page and reports the start and the
+ * end of the resulting load through loadStarted() and loadFinished().
+ *
+ * While a load is in flight no new render is requested; further edits are
+ * collapsed into a single pending render which is dispatched as soon as the
+ * current load finishes, so intermediate (stale) states are never rendered.
+ *
+ * The debounce delay follows an exponential moving average of the measured
+ * render latency, keeping the preview snappy for small pages while avoiding
+ * back-to-back reloads of expensive ones.
+ */
+class PreviewScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a PreviewScheduler with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit PreviewScheduler(QObject *parent = nullptr);
+
+    /**
+     * @brief Sets the bounds the adaptive debounce delay is clamped to.
+     *
+     * @param minimumMs The shortest delay between an edit and a render.
+     * @param maximumMs The longest delay between an edit and a render.
+     */
+    void setDebounceBounds(int minimumMs, int maximumMs);
+
+    /** @return The delay currently applied between an edit and a render. */
+    int debounceInterval() const { return m_debounceTimer->interval(); }
+
+    /** @return The smoothed render latency in milliseconds. */
+    qint64 averageLatency() const { return qRound64(m_averageLatency); }
+
+    /** @return True while a preview load is in progress. */
+    bool isLoadInFlight() const { return m_loadInFlight; }
+
+    /** @return The generation of the most recent render request. */
+    quint64 generation() const { return m_requestedGeneration; }
+
+public slots:
+    /**
+     * @brief Requests a render after the adaptive debounce delay.
+     *
+     * Repeated calls before the delay expires are coalesced into one render.
+     */
+    void schedule();
+
+    /**
+     * @brief Requests a render as soon as no other load is in flight.
+     *
+     * Used for explicit refreshes such as switching tabs, where waiting for
+     * the debounce delay would only be perceived as lag.
+     */
+    void scheduleNow();
+
+    /**
+     * @brief Drops any render that has been requested but not yet dispatched.
+     */
+    void cancel();
+
+    /**
+     * @brief Notifies the scheduler that the requested render started a load.
+     */
+    void loadStarted();
+
+    /**
+     * @brief Notifies the scheduler that the current load has finished.
+     *
+     * @param ok Whether the load succeeded.
+     */
+    void loadFinished(bool ok);
+
+signals:
+    /**
+     * @brief Emitted when the preview should be rendered from current content.
+     *
+     * @param generation The generation of the newest coalesced request.
+     */
+    void renderRequested(quint64 generation);
+
+    /**
+     * @brief Emitted when a render has completed.
+     *
+     * @param generation The generation that was rendered.
+     * @param latencyMs Time from dispatch to load completion in milliseconds.
+     */
+    void renderCompleted(quint64 generation, qint64 latencyMs);
+
+private:
+    /**
+     * @brief Emits renderRequested() unless a load is already in flight.
+     */
+    void dispatch();
+
+    /**
+     * @brief Folds a latency sample into the average and adapts the debounce.
+     *
+     * @param latencyMs The measured latency of the last render.
+     */
+    void recordLatency(qint64 latencyMs);
+
+    QTimer *m_debounceTimer;   /**< Coalesces edits into a single render. */
+    QTimer *m_watchdogTimer;   /**< Recovers if a load never reports completion. */
+    QElapsedTimer m_renderClock; /**< Measures the latency of the current render. */
+
+    int m_minimumDebounce = 60;     /**< Lower bound for the debounce delay. */
+    int m_maximumDebounce = 1000;   /**< Upper bound for the debounce delay. */
+    double m_averageLatency = 0.0;  /**< Exponential moving average of render latency. */
+
+    quint64 m_requestedGeneration = 0;  /**< Incremented for each edit. */
+    quint64 m_dispatchedGeneration = 0; /**< Generation handed to the last render. */
+    bool m_loadInFlight = false;        /**< True while the web engine is loading. */
+    bool m_renderPending = false;       /**< A render was requested during a load. */
+};
+
+#endif // PREVIEWSCHEDULER_H
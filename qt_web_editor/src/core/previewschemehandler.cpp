@@ -0,0 +1,284 @@
+/**
+ * @file previewschemehandler.cpp
+ * @brief Implementation of the PreviewSchemeHandler class.
+ *
+ * This file contains the implementation of the rapid:// URL scheme handler that
+ * feeds the preview from open editor buffers and from disk.
+ */
+
+#include "previewschemehandler.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QMimeDatabase>
+#include <QStringEncoder>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+#include <QDebug>
+
+#include <cstring>
+
+namespace {
+/** Host part of every rapid:// URL. */
+const QString kWorkspaceHost = QStringLiteral("workspace");
+
+/** Number of characters encoded per read from a pinned document. */
+constexpr qsizetype kEncodeChunkSize = 64 * 1024;
+
+/**
+ * @brief A read-only device that encodes a string to UTF-8 as it is read.
+ *
+ * The string is shared, not copied, and never converted in one piece, so
+ * serving a large buffer does not need a second full-size byte array.
+ */
+class Utf8StreamDevice : public QIODevice
+{
+public:
+    explicit Utf8StreamDevice(const QString &text, QObject *parent = nullptr)
+        : QIODevice(parent)
+        , m_text(text)
+        , m_encoder(QStringConverter::Utf8)
+    {
+        open(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+    bool atEnd() const override
+    {
+        return m_textPosition >= m_text.size() && m_chunkPosition >= m_chunk.size()
+            && QIODevice::atEnd();
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        // Remaining characters are an estimate; every character takes at least one byte
+        return (m_chunk.size() - m_chunkPosition) + (m_text.size() - m_textPosition)
+            + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        qint64 copied = 0;
+        while (copied < maxSize) {
+            if (m_chunkPosition >= m_chunk.size()) {
+                if (m_textPosition >= m_text.size()) {
+                    break;
+                }
+                const qsizetype length = qMin(kEncodeChunkSize, m_text.size() - m_textPosition);
+                m_chunk = m_encoder.encode(QStringView(m_text).mid(m_textPosition, length));
+                m_textPosition += length;
+                m_chunkPosition = 0;
+                continue;
+            }
+
+            const qint64 count = qMin<qint64>(maxSize - copied, m_chunk.size() - m_chunkPosition);
+            std::memcpy(data + copied, m_chunk.constData() + m_chunkPosition, size_t(count));
+            copied += count;
+            m_chunkPosition += count;
+        }
+        return (copied == 0 && maxSize > 0) ? -1 : copied;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    QString m_text;
+    QStringEncoder m_encoder;
+    QByteArray m_chunk;
+    qsizetype m_textPosition = 0;
+    qsizetype m_chunkPosition = 0;
+};
+
+/**
+ * @brief A read-only device over a snapshot of an editor buffer.
+ *
+ * The snapshot is UTF-8 already, so reads copy its bytes straight out of the
+ * shared pieces; nothing is converted and no full-size copy is made.
+ */
+class SnapshotDevice : public QIODevice
+{
+public:
+    explicit SnapshotDevice(const TextSnapshot &text, QObject *parent = nullptr)
+        : QIODevice(parent)
+        , m_text(text)
+    {
+        open(QIODevice::ReadOnly);
+    }
+
+    qint64 size() const override { return m_text.size(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (pos() >= m_text.size()) {
+            return -1;
+        }
+        return m_text.read(pos(), data, maxSize);
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    TextSnapshot m_text;
+};
+}
+
+/**
+ * @brief Constructs a PreviewSchemeHandler with the given parent.
+ *
+ * @param parent The parent QObject.
+ */
+PreviewSchemeHandler::PreviewSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+}
+
+/**
+ * @brief Registers the rapid:// scheme with Qt WebEngine.
+ *
+ * The scheme uses host syntax so all workspace files share one origin and
+ * may fetch each other, just like pages served from a local web server.
+ */
+void PreviewSchemeHandler::registerUrlScheme()
+{
+    QWebEngineUrlScheme scheme(schemeName());
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed
+                    | QWebEngineUrlScheme::CorsEnabled
+                    | QWebEngineUrlScheme::ContentSecurityPolicyIgnored);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+/**
+ * @brief Returns the name of the URL scheme served by this handler.
+ *
+ * @return The scheme name.
+ */
+QByteArray PreviewSchemeHandler::schemeName()
+{
+    return QByteArrayLiteral("rapid");
+}
+
+/**
+ * @brief Builds the rapid:// URL for a local file.
+ *
+ * @param filePath Absolute path of the file.
+ * @return The URL under which the preview requests the file.
+ */
+QUrl PreviewSchemeHandler::urlForFile(const QString &filePath)
+{
+    QUrl url;
+    url.setScheme(QString::fromLatin1(schemeName()));
+    url.setHost(kWorkspaceHost);
+    url.setPath(QUrl::fromLocalFile(QFileInfo(filePath).absoluteFilePath()).path());
+    return url;
+}
+
+/**
+ * @brief Maps a rapid:// URL back to the local file it stands for.
+ *
+ * @param url A URL produced by urlForFile() or resolved against one.
+ * @return The local file path, or an empty string for foreign URLs.
+ */
+QString PreviewSchemeHandler::fileForUrl(const QUrl &url)
+{
+    if (url.scheme() != QLatin1String(schemeName()) || url.host() != kWorkspaceHost) {
+        return QString();
+    }
+
+    QUrl local;
+    local.setScheme(QStringLiteral("file"));
+    local.setPath(url.path());
+    return local.toLocalFile();
+}
+
+/**
+ * @brief Guesses the content type of a file from its name.
+ *
+ * @param filePath The file path.
+ * @return The MIME type, with a UTF-8 charset for text types.
+ */
+QByteArray PreviewSchemeHandler::contentTypeForFile(const QString &filePath)
+{
+    static const QMimeDatabase mimeDatabase;
+    const QMimeType mimeType = mimeDatabase.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension);
+
+    QByteArray contentType = mimeType.name().toLatin1();
+    if (mimeType.inherits(QStringLiteral("text/plain")) || contentType == "application/javascript"
+        || contentType == "application/json") {
+        contentType += "; charset=utf-8";
+    }
+    return contentType;
+}
+
+/**
+ * @brief Sets the callback used to find unsaved editor contents.
+ *
+ * @param provider The buffer lookup callback.
+ */
+void PreviewSchemeHandler::setBufferProvider(BufferProvider provider)
+{
+    m_bufferProvider = std::move(provider);
+}
+
+/**
+ * @brief Pins the exact HTML to serve for the document about to be loaded.
+ *
+ * @param url The URL of the document.
+ * @param html The HTML to serve for it.
+ */
+void PreviewSchemeHandler::setPinnedDocument(const QUrl &url, const QString &html)
+{
+    m_pinnedUrl = url;
+    m_pinnedHtml = html;
+}
+
+/**
+ * @brief Answers a request for a rapid:// URL.
+ *
+ * @param job The request job.
+ */
+void PreviewSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    if (job->requestMethod() != "GET") {
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    const QUrl url = job->requestUrl().adjusted(QUrl::RemoveFragment);
+    const QString filePath = fileForUrl(url);
+    if (filePath.isEmpty()) {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    QIODevice *device = nullptr;
+    QByteArray contentType;
+
+    if (url == m_pinnedUrl) {
+        device = new Utf8StreamDevice(m_pinnedHtml);
+        contentType = QByteArrayLiteral("text/html; charset=utf-8");
+    } else {
+        TextSnapshot contents;
+        if (m_bufferProvider && m_bufferProvider(filePath, &contents)) {
+            device = new SnapshotDevice(contents);
+        } else {
+            auto *file = new QFile(filePath);
+            if (!file->open(QIODevice::ReadOnly)) {
+                delete file;
+                job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+                return;
+            }
+            device = file;
+        }
+        contentType = contentTypeForFile(filePath);
+    }
+
+    // The device has to stay alive for as long as the job reads from it
+    connect(job, &QObject::destroyed, device, &QObject::deleteLater);
+    job->reply(contentType, device);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file previewschemehandler.h
+ * @brief Declaration of the PreviewSchemeHandler class.
+ *
+ * This file contains the PreviewSchemeHandler class which serves workspace files
+ * to the preview through the rapid:// URL scheme, preferring the unsaved contents
+ * of open editors over the files on disk.
+ */
+
+#ifndef PREVIEWSCHEMEHANDLER_H
+#define PREVIEWSCHEMEHANDLER_H
+
+#include "../utils/piecetable.h"
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+
+#include <functional>
+
+class QWebEngineUrlRequestJob;
+
+/**
+ * @brief The PreviewSchemeHandler class serves preview documents and their resources.
+ *
+ * Loading the preview from a rapid:// URL instead of QWebEnginePage::setHtml()
+ * avoids the 2 MB limit and the data: URL encoding of setHtml(), and gives every
+ * page a real location so that relative links, stylesheets, scripts and images
+ * resolve against the directory the document lives in.
+ *
+ * A URL such as rapid://workspace/home/me/site/index.html maps to the local file
+ * /home/me/site/index.html. Each request is answered, in order of preference, from
+ * the pinned document (the exact source the preview was asked to show), from the
+ * unsaved buffer of an open editor, or from the file on disk. Replies are streamed
+ * from a QIODevice; buffers are read straight from a UTF-8 snapshot of the editor.
+ */
+class PreviewSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Looks up the unsaved contents of an open file.
+     *
+     * Returns true and fills @p contents if an editor holds unsaved changes
+     * for the file at the given path.
+     */
+    using BufferProvider = std::function<bool(const QString &filePath, TextSnapshot *contents)>;
+
+    /**
+     * @brief Constructs a PreviewSchemeHandler with the given parent.
+     *
+     * @param parent The parent QObject.
+     */
+    explicit PreviewSchemeHandler(QObject *parent = nullptr);
+
+    /**
+     * @brief Registers the rapid:// scheme with Qt WebEngine.
+     *
+     * Must be called before the application object is constructed.
+     */
+    static void registerUrlScheme();
+
+    /** @return The name of the URL scheme served by this handler. */
+    static QByteArray schemeName();
+
+    /**
+     * @brief Builds the rapid:// URL for a local file.
+     *
+     * @param filePath Absolute path of the file.
+     * @return The URL under which the preview requests the file.
+     */
+    static QUrl urlForFile(const QString &filePath);
+
+    /**
+     * @brief Maps a rapid:// URL back to the local file it stands for.
+     *
+     * @param url A URL produced by urlForFile() or resolved against one.
+     * @return The local file path, or an empty string for foreign URLs.
+     */
+    static QString fileForUrl(const QUrl &url);
+
+    /**
+     * @brief Guesses the content type of a file from its name.
+     *
+     * @param filePath The file path.
+     * @return The MIME type, with a UTF-8 charset for text types.
+     */
+    static QByteArray contentTypeForFile(const QString &filePath);
+
+    /**
+     * @brief Sets the callback used to find unsaved editor contents.
+     *
+     * @param provider The buffer lookup callback.
+     */
+    void setBufferProvider(BufferProvider provider);
+
+    /**
+     * @brief Pins the exact HTML to serve for the document about to be loaded.
+     *
+     * Serving the pinned source rather than the live buffer guarantees the page
+     * matches what the live preview runtime believes is loaded, even if the user
+     * keeps typing while the load is in progress.
+     *
+     * @param url The URL of the document.
+     * @param html The HTML to serve for it.
+     */
+    void setPinnedDocument(const QUrl &url, const QString &html);
+
+    /**
+     * @brief Answers a request for a rapid:// URL.
+     *
+     * @param job The request job.
+     */
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    BufferProvider m_bufferProvider;  /**< Finds unsaved contents of open files. */
+    QUrl m_pinnedUrl;                 /**< URL of the pinned document. */
+    QString m_pinnedHtml;             /**< Source served for the pinned document. */
+};
+
+#endif // PREVIEWSCHEMEHANDLER_H
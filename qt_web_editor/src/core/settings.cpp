@@ -70,6 +70,11 @@ void Settings::load()
     m_lineNumbers = m_settings->value("lineNumbers", true).toBool();
     m_tabSize = m_settings->value("tabSize", 4).toInt();
     m_useSpacesForTabs = m_settings->value("useSpacesForTabs", true).toBool();
+    m_saveDurability = static_cast<FileSaver::Durability>(qBound(
+        int(FileSaver::Durability::Direct),
+        m_settings->value("saveDurability", int(FileSaver::Durability::Atomic)).toInt(),
+        int(FileSaver::Durability::Full)));
+    m_tabMemoryBudget = qMax(1, m_settings->value("memoryBudget", 1024).toInt());
     
     // Load window state
     m_lastOpenedPath = m_settings->value("lastOpenedPath", QStandardPaths::writableLocation(QStandardPaths::HomeLocation)).toString();
@@ -79,6 +84,11 @@ void Settings::load()
     
     m_settings->endGroup();
     
+    m_settings->beginGroup("Preview");
+    m_previewCacheSize = qMax(1, m_settings->value("cacheSize", 8).toInt());
+    m_previewCacheBudget = qMax(1, m_settings->value("cacheBudget", 512).toInt());
+    m_settings->endGroup();
+    
     qDebug() << "Loaded settings:";
     qDebug() << "  Theme:" << themeName;
     qDebug() << "  Font:" << m_editorFont.toString();
@@ -86,6 +96,9 @@ void Settings::load()
     qDebug() << "  Line numbers:" << m_lineNumbers;
     qDebug() << "  Tab size:" << m_tabSize;
     qDebug() << "  Use spaces for tabs:" << m_useSpacesForTabs;
+    qDebug() << "  Save durability:" << int(m_saveDurability);
+    qDebug() << "  Tab memory budget:" << m_tabMemoryBudget << "MB";
+    qDebug() << "  Preview cache:" << m_previewCacheSize << "pages," << m_previewCacheBudget << "MB";
     qDebug() << "  Last opened path:" << m_lastOpenedPath;
 }
 
@@ -108,9 +121,16 @@ void Settings::save()
     m_settings->setValue("lineNumbers", m_lineNumbers);
     m_settings->setValue("tabSize", m_tabSize);
     m_settings->setValue("useSpacesForTabs", m_useSpacesForTabs);
+    m_settings->setValue("saveDurability", int(m_saveDurability));
+    m_settings->setValue("memoryBudget", m_tabMemoryBudget);
     m_settings->setValue("lastOpenedPath", m_lastOpenedPath);
     m_settings->endGroup();
     
+    m_settings->beginGroup("Preview");
+    m_settings->setValue("cacheSize", m_previewCacheSize);
+    m_settings->setValue("cacheBudget", m_previewCacheBudget);
+    m_settings->endGroup();
+    
     // Force sync to write to disk immediately
     m_settings->sync();
     if (m_settings->status() != QSettings::NoError) {
@@ -223,3 +243,63 @@ void Settings::setUseSpacesForTabs(bool useSpaces)
         emit useSpacesForTabsChanged(useSpaces);
     }
 }
+
+/**
+ * @brief Sets how many rendered preview pages are kept.
+ * 
+ * Updates the preview cache size and emits previewCacheSizeChanged() if it has changed.
+ * 
+ * @param pages The number of pages, at least 1.
+ */
+void Settings::setPreviewCacheSize(int pages)
+{
+    if (m_previewCacheSize != pages && pages > 0) {
+        m_previewCacheSize = pages;
+        emit previewCacheSizeChanged(pages);
+    }
+}
+
+/**
+ * @brief Sets the estimated memory cached preview pages may use.
+ * 
+ * Updates the preview cache budget and emits previewCacheBudgetChanged() if it has changed.
+ * 
+ * @param megabytes The budget in megabytes, at least 1.
+ */
+void Settings::setPreviewCacheBudget(int megabytes)
+{
+    if (m_previewCacheBudget != megabytes && megabytes > 0) {
+        m_previewCacheBudget = megabytes;
+        emit previewCacheBudgetChanged(megabytes);
+    }
+}
+
+/**
+ * @brief Sets the estimated memory open tabs may use before idle ones hibernate.
+ * 
+ * Updates the tab memory budget and emits tabMemoryBudgetChanged() if it has changed.
+ * 
+ * @param megabytes The budget in megabytes, at least 1.
+ */
+void Settings::setTabMemoryBudget(int megabytes)
+{
+    if (m_tabMemoryBudget != megabytes && megabytes > 0) {
+        m_tabMemoryBudget = megabytes;
+        emit tabMemoryBudgetChanged(megabytes);
+    }
+}
+
+/**
+ * @brief Sets how files are written when saved.
+ * 
+ * Updates the save durability policy and emits saveDurabilityChanged() if it has changed.
+ * 
+ * @param durability The durability policy.
+ */
+void Settings::setSaveDurability(FileSaver::Durability durability)
+{
+    if (m_saveDurability != durability) {
+        m_saveDurability = durability;
+        emit saveDurabilityChanged(durability);
+    }
+}
@@ -14,6 +14,8 @@
 #include <QString>
 #include <QSettings>
 
+#include "filesaver.h"
+
 /**
  * @brief The Settings class manages application settings and preferences.
  * 
@@ -83,6 +85,18 @@ public:
     
     /** @return True if spaces should be used instead of tab characters. */
     bool useSpacesForTabs() const { return m_useSpacesForTabs; }
+    
+    /** @return The number of rendered preview pages kept for quick tab switching. */
+    int previewCacheSize() const { return m_previewCacheSize; }
+    
+    /** @return The estimated memory, in megabytes, cached preview pages may use. */
+    int previewCacheBudget() const { return m_previewCacheBudget; }
+    
+    /** @return The estimated memory, in megabytes, open tabs may use before idle ones hibernate. */
+    int tabMemoryBudget() const { return m_tabMemoryBudget; }
+    
+    /** @return How files are written when saved. */
+    FileSaver::Durability saveDurability() const { return m_saveDurability; }
 
     /**
      * @brief Sets the application theme.
@@ -146,6 +160,34 @@ public:
      */
     void setUseSpacesForTabs(bool useSpaces);
     
+    /**
+     * @brief Sets how many rendered preview pages are kept.
+     * 
+     * @param pages The number of pages, at least 1.
+     */
+    void setPreviewCacheSize(int pages);
+    
+    /**
+     * @brief Sets the estimated memory cached preview pages may use.
+     * 
+     * @param megabytes The budget in megabytes, at least 1.
+     */
+    void setPreviewCacheBudget(int megabytes);
+    
+    /**
+     * @brief Sets the estimated memory open tabs may use before idle ones hibernate.
+     * 
+     * @param megabytes The budget in megabytes, at least 1.
+     */
+    void setTabMemoryBudget(int megabytes);
+    
+    /**
+     * @brief Sets how files are written when saved.
+     * 
+     * @param durability The durability policy.
+     */
+    void setSaveDurability(FileSaver::Durability durability);
+    
     /**
      * @brief Gets the path to the settings file.
      * 
@@ -217,6 +259,34 @@ signals:
      * @param useSpaces True if spaces should be used instead of tabs.
      */
     void useSpacesForTabsChanged(bool useSpaces);
+    
+    /**
+     * @brief Emitted when the preview cache size changes.
+     * 
+     * @param pages The new number of cached pages.
+     */
+    void previewCacheSizeChanged(int pages);
+    
+    /**
+     * @brief Emitted when the preview cache memory budget changes.
+     * 
+     * @param megabytes The new budget in megabytes.
+     */
+    void previewCacheBudgetChanged(int megabytes);
+    
+    /**
+     * @brief Emitted when the memory budget of open tabs changes.
+     * 
+     * @param megabytes The new budget in megabytes.
+     */
+    void tabMemoryBudgetChanged(int megabytes);
+    
+    /**
+     * @brief Emitted when the save durability policy changes.
+     * 
+     * @param durability The new policy.
+     */
+    void saveDurabilityChanged(FileSaver::Durability durability);
 
 private:
     QSettings *m_settings;                /**< The QSettings instance for persistent storage. */
@@ -229,6 +299,10 @@ private:
     bool m_lineNumbers{true};            /**< Whether line numbers are shown. */
     int m_tabSize{4};                    /**< Number of spaces per tab. */
     bool m_useSpacesForTabs{true};       /**< Whether to use spaces instead of tabs. */
+    int m_previewCacheSize{8};           /**< Number of rendered preview pages kept. */
+    int m_previewCacheBudget{512};       /**< Memory budget of cached preview pages, in MB. */
+    int m_tabMemoryBudget{1024};         /**< Memory budget of open tabs, in MB. */
+    FileSaver::Durability m_saveDurability{FileSaver::Durability::Atomic}; /**< How files are written when saved. */
     QStringList m_recentFiles;           /**< List of recently opened files. */
 };
 
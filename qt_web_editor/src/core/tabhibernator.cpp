@@ -0,0 +1,223 @@
+/**
+ * @file tabhibernator.cpp
+ * @brief Implementation of the TabHibernator class.
+ *
+ * This file contains the memory accounting of the open tabs and the swap of
+ * idle editors for placeholders holding their compressed text.
+ */
+
+#include "tabhibernator.h"
+#include "editorwidget.h"
+#include "tabplaceholder.h"
+
+#include <QFileInfo>
+#include <QPointer>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QTabWidget>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+/** Interval between checks of the budget, which editing can push over. */
+constexpr int kCheckIntervalMs = 5000;
+
+/** Default budget of the open tabs. */
+constexpr qint64 kDefaultBudgetBytes = 1024LL * 1024 * 1024;
+
+/** Share of its estimate an editor is expected to keep once hibernated, in percent. */
+constexpr qint64 kCompressedPercent = 10;
+}
+
+/**
+ * @brief Constructs a TabHibernator for the tabs of a tab widget.
+ *
+ * @param tabs The tabs.
+ * @param pool The pool the text is compressed on.
+ * @param parent The parent QObject.
+ */
+TabHibernator::TabHibernator(QTabWidget *tabs, QThreadPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_tabs(tabs)
+    , m_pool(pool)
+    , m_checkTimer(new QTimer(this))
+    , m_memoryBudget(kDefaultBudgetBytes)
+{
+    m_checkTimer->setInterval(kCheckIntervalMs);
+    connect(m_checkTimer, &QTimer::timeout, this, &TabHibernator::enforceBudget);
+    m_checkTimer->start();
+}
+
+/**
+ * @brief Sets the estimated memory the open tabs may use.
+ *
+ * A lower budget is enforced right away.
+ *
+ * @param bytes The budget in bytes.
+ */
+void TabHibernator::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = qMax<qint64>(1, bytes);
+    enforceBudget();
+}
+
+/**
+ * @brief Estimates the memory the open tabs use.
+ *
+ * Editors count their own estimate and hibernated tabs their compressed text.
+ * Files shown read-only are mapped, not held, and do not count.
+ *
+ * @return The estimated size in bytes.
+ */
+qint64 TabHibernator::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < m_tabs->count(); ++i) {
+        QWidget *tab = m_tabs->widget(i);
+        if (auto editor = qobject_cast<EditorWidget*>(tab)) {
+            bytes += editor->estimatedMemory();
+        } else if (auto placeholder = qobject_cast<TabPlaceholder*>(tab)) {
+            bytes += placeholder->hibernatedText().size();
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Notes that a tab was shown, making it the most recently used.
+ *
+ * Showing a tab may push the tabs over the budget, which is then enforced.
+ *
+ * @param tab The tab's widget.
+ */
+void TabHibernator::noteActivated(QWidget *tab)
+{
+    m_lastUse.insert(tab, ++m_useCounter);
+    enforceBudget();
+}
+
+/**
+ * @brief Hibernates the least recently used tabs while over the budget.
+ *
+ * A tab never shown counts as used when first seen here, so tabs loaded ahead
+ * of activation are not the first to go. Hibernation completes in the
+ * background; the editors on their way are counted at the size they are
+ * expected to shrink to.
+ */
+void TabHibernator::enforceBudget()
+{
+    QHash<QWidget*, quint64> lastUse;
+    QVector<EditorWidget*> candidates;
+    qint64 usage = 0;
+    for (int i = 0; i < m_tabs->count(); ++i) {
+        QWidget *tab = m_tabs->widget(i);
+        lastUse.insert(tab, m_lastUse.value(tab, m_useCounter));
+        if (auto editor = qobject_cast<EditorWidget*>(tab)) {
+            const qint64 estimate = editor->estimatedMemory();
+            if (m_compressing.contains(editor)) {
+                usage += estimate * kCompressedPercent / 100;
+                continue;
+            }
+            usage += estimate;
+            if (canHibernate(editor)) {
+                candidates.append(editor);
+            }
+        } else if (auto placeholder = qobject_cast<TabPlaceholder*>(tab)) {
+            usage += placeholder->hibernatedText().size();
+        }
+    }
+    // Closed tabs are forgotten
+    m_lastUse.swap(lastUse);
+
+    std::sort(candidates.begin(), candidates.end(), [this](EditorWidget *a, EditorWidget *b) {
+        return m_lastUse.value(a) < m_lastUse.value(b);
+    });
+    for (EditorWidget *editor : qAsConst(candidates)) {
+        if (usage <= m_memoryBudget) {
+            break;
+        }
+        usage -= editor->estimatedMemory() * (100 - kCompressedPercent) / 100;
+        hibernate(editor);
+    }
+
+    emit memoryUsageChanged(memoryUsage(), m_memoryBudget);
+}
+
+/**
+ * @brief Checks whether an editor may be hibernated now.
+ *
+ * @param editor The editor.
+ * @return True for an idle, unmodified editor of a file, other than the current one.
+ */
+bool TabHibernator::canHibernate(const EditorWidget *editor) const
+{
+    return editor != m_tabs->currentWidget()
+        && !editor->filePath().isEmpty()
+        && !editor->isModified()
+        && !editor->isLoading()
+        && !editor->isSaving();
+}
+
+/**
+ * @brief Compresses the text of an editor in the background.
+ *
+ * The snapshot is taken here and compressed on the pool; the swap happens
+ * back on this thread, and only if the editor is still as it was.
+ *
+ * @param editor The editor.
+ */
+void TabHibernator::hibernate(EditorWidget *editor)
+{
+    m_compressing.insert(editor);
+    const QPointer<EditorWidget> target(editor);
+    const TextSnapshot text = editor->snapshot();
+    m_pool->start([this, target, editor, text]() {
+        const QByteArray compressed = qCompress(text.toUtf8(), 1);
+        QMetaObject::invokeMethod(this, [this, target, editor, text, compressed]() {
+            m_compressing.remove(editor);
+            if (target) {
+                finishHibernation(target, text.revision(), compressed);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+/**
+ * @brief Replaces an editor by a placeholder holding its compressed text.
+ *
+ * The placeholder takes the editor's tab, cursor and scroll position. An
+ * editor edited, shown or busy since its text was taken is left alone.
+ *
+ * @param editor The editor.
+ * @param revision Revision of the text compressed.
+ * @param compressed The compressed text.
+ */
+void TabHibernator::finishHibernation(EditorWidget *editor, quint64 revision, const QByteArray &compressed)
+{
+    const int index = m_tabs->indexOf(editor);
+    if (index < 0 || editor->revision() != revision || !canHibernate(editor)) {
+        return;
+    }
+
+    const QString filePath = editor->filePath();
+    auto placeholder = new TabPlaceholder(filePath, editor->textCursor().position(),
+                                          editor->verticalScrollBar()->value(),
+                                          QFileInfo(filePath).lastModified());
+    placeholder->setHibernatedText(compressed);
+
+    // The current tab is another one and stays so
+    {
+        const QSignalBlocker blocker(m_tabs);
+        m_tabs->insertTab(index, placeholder, m_tabs->tabIcon(index), m_tabs->tabText(index));
+        m_tabs->setTabToolTip(index, m_tabs->tabToolTip(index + 1));
+        m_tabs->removeTab(index + 1);
+    }
+    m_lastUse.insert(placeholder, m_lastUse.take(editor));
+    editor->deleteLater();
+
+    emit tabHibernated(placeholder);
+    emit memoryUsageChanged(memoryUsage(), m_memoryBudget);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file tabhibernator.h
+ * @brief Declaration of the TabHibernator class.
+ *
+ * This file contains the TabHibernator class which keeps the memory held by
+ * open tabs within a budget by hibernating the least recently used ones.
+ */
+
+#ifndef TABHIBERNATOR_H
+#define TABHIBERNATOR_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+class EditorWidget;
+class QTabWidget;
+class QThreadPool;
+class QTimer;
+class QWidget;
+class TabPlaceholder;
+
+/**
+ * @brief The TabHibernator class hibernates idle tabs to respect a memory budget.
+ *
+ * The memory of the open tabs is estimated from their editors and the
+ * compressed text of tabs already hibernated. While it is over the budget,
+ * the least recently shown editors are hibernated: their text is compressed
+ * on a background thread and the editor, with its layout, formats and undo
+ * history, is replaced by a TabPlaceholder holding the compressed text.
+ * Showing the tab again brings the text back, usually much faster than
+ * reading and decoding the file.
+ *
+ * Only editors of a saved file without unsaved edits are hibernated, and
+ * never the current one or one being loaded or saved.
+ */
+class TabHibernator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a TabHibernator for the tabs of a tab widget.
+     *
+     * @param tabs The tabs.
+     * @param pool The pool the text is compressed on.
+     * @param parent The parent QObject.
+     */
+    TabHibernator(QTabWidget *tabs, QThreadPool *pool, QObject *parent = nullptr);
+
+    /**
+     * @brief Sets the estimated memory the open tabs may use.
+     *
+     * @param bytes The budget in bytes.
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /** @return The estimated memory the open tabs may use, in bytes. */
+    qint64 memoryBudget() const { return m_memoryBudget; }
+
+    /**
+     * @brief Estimates the memory the open tabs use.
+     *
+     * @return The estimated size in bytes.
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Notes that a tab was shown, making it the most recently used.
+     *
+     * @param tab The tab's widget.
+     */
+    void noteActivated(QWidget *tab);
+
+public slots:
+    /**
+     * @brief Hibernates the least recently used tabs while over the budget.
+     */
+    void enforceBudget();
+
+signals:
+    /**
+     * @brief Emitted when the estimated memory use may have changed.
+     *
+     * @param usedBytes The estimated memory the open tabs use.
+     * @param budgetBytes The budget.
+     */
+    void memoryUsageChanged(qint64 usedBytes, qint64 budgetBytes);
+
+    /**
+     * @brief Emitted when an editor was replaced by a placeholder.
+     *
+     * @param placeholder The placeholder now in the editor's tab.
+     */
+    void tabHibernated(TabPlaceholder *placeholder);
+
+private:
+    /**
+     * @brief Checks whether an editor may be hibernated now.
+     *
+     * @param editor The editor.
+     * @return True for an idle, unmodified editor of a file, other than the current one.
+     */
+    bool canHibernate(const EditorWidget *editor) const;
+
+    /**
+     * @brief Compresses the text of an editor in the background.
+     *
+     * @param editor The editor.
+     */
+    void hibernate(EditorWidget *editor);
+
+    /**
+     * @brief Replaces an editor by a placeholder holding its compressed text.
+     *
+     * @param editor The editor.
+     * @param revision Revision of the text compressed.
+     * @param compressed The compressed text.
+     */
+    void finishHibernation(EditorWidget *editor, quint64 revision, const QByteArray &compressed);
+
+    QTabWidget *m_tabs;                  /**< The tabs. */
+    QThreadPool *m_pool;                 /**< Where text is compressed. */
+    QTimer *m_checkTimer;                /**< Re-checks the budget as tabs grow. */
+    qint64 m_memoryBudget;               /**< Estimated memory the tabs may use. */
+    quint64 m_useCounter = 0;            /**< Source of the use stamps. */
+    QHash<QWidget*, quint64> m_lastUse;  /**< When each tab was last shown. */
+    QSet<QWidget*> m_compressing;        /**< Editors whose text is being compressed. */
+};
+
+#endif // TABHIBERNATOR_H
@@ -0,0 +1,39 @@
+/**
+ * @file tabplaceholder.cpp
+ * @brief Implementation of the TabPlaceholder class.
+ */
+
+#include "tabplaceholder.h"
+
+#include <QFileInfo>
+
+/**
+ * @brief Constructs a placeholder for a file.
+ *
+ * Nothing is read from the file.
+ *
+ * @param filePath The file.
+ * @param cursorPosition Position of the cursor in the file.
+ * @param firstVisibleLine Line at the top of the view.
+ * @param lastModified When the file was last modified as the position was recorded.
+ * @param parent The parent widget.
+ */
+TabPlaceholder::TabPlaceholder(const QString &filePath, int cursorPosition, int firstVisibleLine,
+                               const QDateTime &lastModified, QWidget *parent)
+    : QWidget(parent)
+    , m_filePath(filePath)
+    , m_cursorPosition(cursorPosition)
+    , m_firstVisibleLine(firstVisibleLine)
+    , m_lastModified(lastModified)
+{
+}
+
+/**
+ * @brief Checks whether the recorded position still applies to the file.
+ *
+ * @return True if the file has not been modified since the position was recorded.
+ */
+bool TabPlaceholder::isFileUnchanged() const
+{
+    return m_lastModified.isValid() && QFileInfo(m_filePath).lastModified() == m_lastModified;
+}
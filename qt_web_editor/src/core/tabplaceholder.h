@@ -0,0 +1,90 @@
+/**
+ * @file tabplaceholder.h
+ * @brief Declaration of the TabPlaceholder class.
+ *
+ * This file contains the TabPlaceholder class which holds the tab of a
+ * restored file until the file is first shown.
+ */
+
+#ifndef TABPLACEHOLDER_H
+#define TABPLACEHOLDER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QWidget>
+
+/**
+ * @brief The TabPlaceholder class stands in for a restored tab that has not been shown yet.
+ *
+ * Restoring a session creates a placeholder per file instead of an editor: it
+ * only remembers the file, where the cursor and the view were, and when the
+ * file was last modified. The file is read, decoded and highlighted when its
+ * tab is first activated, or earlier while the application is idle, and the
+ * placeholder is then replaced by the editor.
+ *
+ * A placeholder also stands in for a hibernated tab: an unmodified editor put
+ * away to save memory. It then holds the text compressed, and brings it back
+ * without reading the file unless the file was modified since.
+ */
+class TabPlaceholder : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a placeholder for a file.
+     *
+     * @param filePath The file.
+     * @param cursorPosition Position of the cursor in the file.
+     * @param firstVisibleLine Line at the top of the view.
+     * @param lastModified When the file was last modified as the position was recorded.
+     * @param parent The parent widget.
+     */
+    TabPlaceholder(const QString &filePath, int cursorPosition, int firstVisibleLine,
+                   const QDateTime &lastModified, QWidget *parent = nullptr);
+
+    /** @return The file. */
+    QString filePath() const { return m_filePath; }
+
+    /** @return Position of the cursor in the file. */
+    int cursorPosition() const { return m_cursorPosition; }
+
+    /** @return Line at the top of the view. */
+    int firstVisibleLine() const { return m_firstVisibleLine; }
+
+    /**
+     * @brief Checks whether the recorded position still applies to the file.
+     * @return True if the file has not been modified since the position was recorded.
+     */
+    bool isFileUnchanged() const;
+
+    /** @return True once the file is being read ahead of activation. */
+    bool isPrewarming() const { return m_prewarming; }
+
+    /** @brief Notes that the file is being read ahead of activation. */
+    void setPrewarming() { m_prewarming = true; }
+
+    /** @return True if the placeholder holds the text of a hibernated tab. */
+    bool isHibernated() const { return !m_hibernatedText.isEmpty(); }
+
+    /** @return The text of the hibernated tab, compressed with qCompress(). */
+    QByteArray hibernatedText() const { return m_hibernatedText; }
+
+    /**
+     * @brief Keeps the text of a hibernated tab.
+     *
+     * @param compressed The UTF-8 text, compressed with qCompress().
+     */
+    void setHibernatedText(const QByteArray &compressed) { m_hibernatedText = compressed; }
+
+private:
+    QString m_filePath;        /**< The file. */
+    int m_cursorPosition;      /**< Position of the cursor in the file. */
+    int m_firstVisibleLine;    /**< Line at the top of the view. */
+    QDateTime m_lastModified;  /**< Modification time of the file when the position was recorded. */
+    bool m_prewarming = false; /**< Whether the file is being read ahead of activation. */
+    QByteArray m_hibernatedText; /**< Compressed text of a hibernated tab. */
+};
+
+#endif // TABPLACEHOLDER_H
@@ -8,6 +8,7 @@
  */
 
 #include "core/application.h"
+#include "core/previewschemehandler.h"
 #include <QApplication>
 #include <QDebug>
 #include <QMessageBox>
@@ -25,6 +26,9 @@
  */
 int main(int argc, char *argv[]) {
     try {
+        // Custom URL schemes must be known before the web engine starts
+        PreviewSchemeHandler::registerUrlScheme();
+
         // Initialize the application
         Application app(argc, argv);
         
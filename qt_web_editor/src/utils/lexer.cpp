@@ -0,0 +1,722 @@
+/**
+ * @file lexer.cpp
+ * @brief Implementation of the Lexer class.
+ *
+ * This file contains the single-pass state machines for HTML, CSS and
+ * JavaScript and the perfect-hash keyword tables they use.
+ */
+
+#include "lexer.h"
+
+#include <climits>
+#include <initializer_list>
+#include <utility>
+
+namespace {
+using Token = Lexer::Token;
+using TokenType = Lexer::TokenType;
+
+/**
+ * @brief A keyword set with a collision-free hash.
+ *
+ * The hash mixes the length and a few characters of a word with a multiplier.
+ * On construction, multipliers are tried until every keyword lands in its own
+ * slot, so a lookup is one hash and at most one comparison.
+ */
+class KeywordTable
+{
+public:
+    KeywordTable(std::initializer_list<std::pair<const char *, TokenType>> keywords)
+    {
+        for (const auto &keyword : keywords) {
+            m_words.append({QString::fromLatin1(keyword.first), keyword.second});
+        }
+
+        int size = 1;
+        while (size < m_words.size() * 2) {
+            size <<= 1;
+        }
+
+        // Look for a multiplier that separates all keywords; grow the table if none does
+        for (;;) {
+            for (quint32 seed = 1; seed < 100000; seed += 2) {
+                if (build(seed, size)) {
+                    return;
+                }
+            }
+            size <<= 1;
+        }
+    }
+
+    /**
+     * @brief Looks up a word.
+     *
+     * @param text Points at the first character of the word.
+     * @param length Length of the word.
+     * @param type Receives the token type of a keyword.
+     * @return True if the word is a keyword.
+     */
+    bool lookup(const QChar *text, int length, TokenType *type) const
+    {
+        if (length < m_minLength || length > m_maxLength) {
+            return false;
+        }
+        const int slot = m_slots.at(hash(text, length, m_seed, m_mask));
+        if (slot < 0) {
+            return false;
+        }
+        const Entry &entry = m_words.at(slot);
+        if (QStringView(text, length) != entry.word) {
+            return false;
+        }
+        *type = entry.type;
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        QString word;
+        TokenType type;
+    };
+
+    static quint32 hash(const QChar *text, int length, quint32 seed, quint32 mask)
+    {
+        quint32 h = quint32(length);
+        h = h * 31 + text[0].unicode();
+        h = h * 31 + text[length - 1].unicode();
+        if (length > 2) {
+            h = h * 31 + text[1].unicode();
+            h = h * 31 + text[length - 2].unicode();
+        }
+        return ((h * seed) >> 7) & mask;
+    }
+
+    bool build(quint32 seed, int size)
+    {
+        m_slots.fill(-1, size);
+        m_minLength = INT_MAX;
+        m_maxLength = 0;
+        for (int i = 0; i < m_words.size(); ++i) {
+            const QString &word = m_words.at(i).word;
+            int &slot = m_slots[hash(word.constData(), word.size(), seed, quint32(size - 1))];
+            if (slot >= 0) {
+                return false;
+            }
+            slot = i;
+            m_minLength = qMin(m_minLength, int(word.size()));
+            m_maxLength = qMax(m_maxLength, int(word.size()));
+        }
+        m_seed = seed;
+        m_mask = quint32(size - 1);
+        return true;
+    }
+
+    QVector<Entry> m_words;
+    QVector<int> m_slots;
+    quint32 m_seed = 1;
+    quint32 m_mask = 0;
+    int m_minLength = 0;
+    int m_maxLength = 0;
+};
+
+const KeywordTable &jsKeywords()
+{
+    static const KeywordTable table = {
+        {"break", Lexer::Keyword}, {"case", Lexer::Keyword}, {"catch", Lexer::Keyword},
+        {"class", Lexer::Keyword}, {"const", Lexer::Keyword}, {"continue", Lexer::Keyword},
+        {"debugger", Lexer::Keyword}, {"default", Lexer::Keyword}, {"delete", Lexer::Keyword},
+        {"do", Lexer::Keyword}, {"else", Lexer::Keyword}, {"export", Lexer::Keyword},
+        {"extends", Lexer::Keyword}, {"finally", Lexer::Keyword}, {"for", Lexer::Keyword},
+        {"function", Lexer::Keyword}, {"if", Lexer::Keyword}, {"import", Lexer::Keyword},
+        {"in", Lexer::Keyword}, {"instanceof", Lexer::Keyword}, {"new", Lexer::Keyword},
+        {"return", Lexer::Keyword}, {"super", Lexer::Keyword}, {"switch", Lexer::Keyword},
+        {"this", Lexer::Keyword}, {"throw", Lexer::Keyword}, {"try", Lexer::Keyword},
+        {"typeof", Lexer::Keyword}, {"var", Lexer::Keyword}, {"void", Lexer::Keyword},
+        {"while", Lexer::Keyword}, {"with", Lexer::Keyword}, {"yield", Lexer::Keyword},
+        {"let", Lexer::Keyword}, {"async", Lexer::Keyword}, {"await", Lexer::Keyword},
+        {"of", Lexer::Keyword}, {"static", Lexer::Keyword},
+        {"true", Lexer::Value}, {"false", Lexer::Value}, {"null", Lexer::Value},
+        {"undefined", Lexer::Value}, {"NaN", Lexer::Value}, {"Infinity", Lexer::Value}
+    };
+    return table;
+}
+
+inline bool isAsciiLetter(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+inline bool isDigit(QChar c)
+{
+    const ushort u = c.unicode();
+    return u >= '0' && u <= '9';
+}
+
+inline bool isSpace(QChar c)
+{
+    const ushort u = c.unicode();
+    return u == ' ' || u == '\t' || (u > 127 && c.isSpace());
+}
+
+inline bool isIdentifierStart(QChar c)
+{
+    const ushort u = c.unicode();
+    return isAsciiLetter(c) || u == '_' || u == '$' || (u > 127 && c.isLetter());
+}
+
+inline bool isIdentifierPart(QChar c)
+{
+    return isIdentifierStart(c) || isDigit(c);
+}
+
+inline bool isCssNameChar(QChar c)
+{
+    const ushort u = c.unicode();
+    return isAsciiLetter(c) || isDigit(c) || u == '-' || u == '_' || u > 127;
+}
+
+inline bool isTagNameChar(QChar c)
+{
+    const ushort u = c.unicode();
+    return isAsciiLetter(c) || isDigit(c) || u == '-' || u == '_' || u == ':';
+}
+
+inline void addToken(QVector<Token> *tokens, int start, int end, TokenType type)
+{
+    if (end > start) {
+        tokens->append({start, end - start, type});
+    }
+}
+
+/** Returns the index of the first non-space character at or after @p i. */
+inline int skipSpaces(const QChar *text, int i, int end)
+{
+    while (i < end && isSpace(text[i])) {
+        ++i;
+    }
+    return i;
+}
+
+/** Returns the index just past "* /" at or after @p i, or -1. */
+int findBlockCommentEnd(const QChar *text, int i, int end)
+{
+    for (; i + 1 < end; ++i) {
+        if (text[i] == QLatin1Char('*') && text[i + 1] == QLatin1Char('/')) {
+            return i + 2;
+        }
+    }
+    return -1;
+}
+
+/** Returns the index just past the closing quote, or -1 if the string is unterminated. */
+int findStringEnd(const QChar *text, int i, int end, QChar quote)
+{
+    for (; i < end; ++i) {
+        if (text[i] == QLatin1Char('\\')) {
+            ++i;
+        } else if (text[i] == quote) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+/** Returns the index just past the closing quote, or @p end if the string is unterminated. */
+inline int scanString(const QChar *text, int i, int end, QChar quote)
+{
+    const int close = findStringEnd(text, i, end, quote);
+    return close < 0 ? end : close;
+}
+
+// --- JavaScript -------------------------------------------------------------
+
+enum JsState {
+    JsNormal = 0,
+    JsBlockComment = 1,
+    JsTemplate = 2
+};
+
+/**
+ * @brief Tokenizes the JavaScript in [begin, end) of a line.
+ *
+ * @return The state at @p end.
+ */
+int lexJavaScript(const QChar *text, int begin, int end, int state, QVector<Token> *tokens)
+{
+    int i = begin;
+
+    if (state == JsBlockComment) {
+        const int close = findBlockCommentEnd(text, i, end);
+        if (close < 0) {
+            addToken(tokens, i, end, Lexer::Comment);
+            return JsBlockComment;
+        }
+        addToken(tokens, i, close, Lexer::Comment);
+        i = close;
+    } else if (state == JsTemplate) {
+        const int close = findStringEnd(text, i, end, QLatin1Char('`'));
+        if (close < 0) {
+            addToken(tokens, i, end, Lexer::String);
+            return JsTemplate;
+        }
+        addToken(tokens, i, close, Lexer::String);
+        i = close;
+    }
+
+    while (i < end) {
+        const QChar c = text[i];
+        const ushort u = c.unicode();
+
+        if (isSpace(c)) {
+            ++i;
+        } else if (u == '/' && i + 1 < end && text[i + 1] == QLatin1Char('/')) {
+            addToken(tokens, i, end, Lexer::Comment);
+            return JsNormal;
+        } else if (u == '/' && i + 1 < end && text[i + 1] == QLatin1Char('*')) {
+            const int close = findBlockCommentEnd(text, i + 2, end);
+            if (close < 0) {
+                addToken(tokens, i, end, Lexer::Comment);
+                return JsBlockComment;
+            }
+            addToken(tokens, i, close, Lexer::Comment);
+            i = close;
+        } else if (u == '"' || u == '\'') {
+            const int close = scanString(text, i + 1, end, c);
+            addToken(tokens, i, close, Lexer::String);
+            i = close;
+        } else if (u == '`') {
+            const int close = findStringEnd(text, i + 1, end, c);
+            if (close < 0) {
+                addToken(tokens, i, end, Lexer::String);
+                return JsTemplate;
+            }
+            addToken(tokens, i, close, Lexer::String);
+            i = close;
+        } else if (isDigit(c) || (u == '.' && i + 1 < end && isDigit(text[i + 1]))) {
+            const int start = i++;
+            while (i < end) {
+                const QChar d = text[i];
+                if (isIdentifierPart(d) || d == QLatin1Char('.')) {
+                    ++i;
+                } else if ((d == QLatin1Char('+') || d == QLatin1Char('-'))
+                           && (text[i - 1] == QLatin1Char('e') || text[i - 1] == QLatin1Char('E'))) {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            addToken(tokens, start, i, Lexer::Number);
+        } else if (isIdentifierStart(c)) {
+            const int start = i++;
+            while (i < end && isIdentifierPart(text[i])) {
+                ++i;
+            }
+            TokenType type;
+            if (jsKeywords().lookup(text + start, i - start, &type)) {
+                addToken(tokens, start, i, type);
+            } else {
+                const int next = skipSpaces(text, i, end);
+                if (next < end && text[next] == QLatin1Char('(')) {
+                    addToken(tokens, start, i, Lexer::Function);
+                }
+            }
+        } else {
+            ++i;
+        }
+    }
+    return JsNormal;
+}
+
+// --- CSS --------------------------------------------------------------------
+
+/*
+ * CSS state: bit 0 is set inside a block comment, the remaining bits hold the
+ * nesting depth of braces, so properties can be told apart from selectors.
+ */
+constexpr int kCssCommentBit = 1;
+constexpr int kCssMaxDepth = 0xff;
+
+/**
+ * @brief Tokenizes the CSS in [begin, end) of a line.
+ *
+ * @return The state at @p end.
+ */
+int lexCss(const QChar *text, int begin, int end, int state, QVector<Token> *tokens)
+{
+    int depth = state >> 1;
+    int i = begin;
+
+    if (state & kCssCommentBit) {
+        const int close = findBlockCommentEnd(text, i, end);
+        if (close < 0) {
+            addToken(tokens, i, end, Lexer::Comment);
+            return state;
+        }
+        addToken(tokens, i, close, Lexer::Comment);
+        i = close;
+    }
+
+    while (i < end) {
+        const QChar c = text[i];
+        const ushort u = c.unicode();
+
+        if (isSpace(c)) {
+            ++i;
+        } else if (u == '/' && i + 1 < end && text[i + 1] == QLatin1Char('*')) {
+            const int close = findBlockCommentEnd(text, i + 2, end);
+            if (close < 0) {
+                addToken(tokens, i, end, Lexer::Comment);
+                return (depth << 1) | kCssCommentBit;
+            }
+            addToken(tokens, i, close, Lexer::Comment);
+            i = close;
+        } else if (u == '"' || u == '\'') {
+            const int close = scanString(text, i + 1, end, c);
+            addToken(tokens, i, close, Lexer::String);
+            i = close;
+        } else if (u == '{') {
+            depth = qMin(depth + 1, kCssMaxDepth);
+            ++i;
+        } else if (u == '}') {
+            depth = qMax(depth - 1, 0);
+            ++i;
+        } else if (u == '@') {
+            const int start = i++;
+            while (i < end && isCssNameChar(text[i])) {
+                ++i;
+            }
+            addToken(tokens, start, i, Lexer::Keyword);
+        } else if (u == '#' && depth > 0) {
+            // Hex colour
+            const int start = i++;
+            while (i < end && isCssNameChar(text[i])) {
+                ++i;
+            }
+            addToken(tokens, start, i, Lexer::Value);
+        } else if (depth > 0 && (isDigit(c)
+                                 || ((u == '.' || u == '-' || u == '+') && i + 1 < end && isDigit(text[i + 1])))) {
+            // Number with an optional unit
+            const int start = i++;
+            while (i < end && (isDigit(text[i]) || text[i] == QLatin1Char('.'))) {
+                ++i;
+            }
+            while (i < end && (isAsciiLetter(text[i]) || text[i] == QLatin1Char('%'))) {
+                ++i;
+            }
+            addToken(tokens, start, i, Lexer::Number);
+        } else if (u == ':' && depth == 0) {
+            // Pseudo-class or pseudo-element
+            const int start = i++;
+            if (i < end && text[i] == QLatin1Char(':')) {
+                ++i;
+            }
+            while (i < end && isCssNameChar(text[i])) {
+                ++i;
+            }
+            addToken(tokens, start, i, Lexer::Function);
+        } else if (isCssNameChar(c) || ((u == '.' || u == '#') && depth == 0)) {
+            const int start = i++;
+            while (i < end && isCssNameChar(text[i])) {
+                ++i;
+            }
+            if (depth == 0) {
+                addToken(tokens, start, i, Lexer::Tag);
+            } else {
+                const int next = skipSpaces(text, i, end);
+                if (next < end && text[next] == QLatin1Char(':')) {
+                    addToken(tokens, start, i, Lexer::Attribute);
+                } else if (next < end && text[next] == QLatin1Char('(')) {
+                    addToken(tokens, start, i, Lexer::Function);
+                }
+            }
+        } else {
+            ++i;
+        }
+    }
+    return depth << 1;
+}
+
+// --- HTML -------------------------------------------------------------------
+
+/*
+ * HTML state layout:
+ *   bits 0-3  the HTML mode below
+ *   bits 4-5  the element whose start tag is open (script or style)
+ *   bits 8+   the state of the embedded JavaScript or CSS lexer
+ */
+enum HtmlMode {
+    HtmlText = 0,
+    HtmlComment = 1,
+    HtmlTag = 2,
+    HtmlDoubleQuoted = 3,
+    HtmlSingleQuoted = 4,
+    HtmlScript = 5,
+    HtmlStyle = 6
+};
+
+constexpr int kHtmlModeMask = 0x0f;
+constexpr int kHtmlOpenScript = 0x10;
+constexpr int kHtmlOpenStyle = 0x20;
+constexpr int kHtmlOpenMask = 0x30;
+constexpr int kHtmlSubStateShift = 8;
+
+/** Case-insensitively checks for an ASCII word at @p i. */
+bool matchesAt(const QChar *text, int i, int end, QLatin1String word)
+{
+    if (end - i < word.size()) {
+        return false;
+    }
+    for (int k = 0; k < word.size(); ++k) {
+        if (text[i + k].toLower().unicode() != ushort(word[k].unicode())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Returns the index of the end tag of an element with raw text content, or @p end. */
+int findRawTextEnd(const QChar *text, int i, int end, QLatin1String endTag)
+{
+    for (; i < end; ++i) {
+        if (text[i] == QLatin1Char('<') && matchesAt(text, i, end, endTag)) {
+            return i;
+        }
+    }
+    return end;
+}
+
+/** Scans an attribute value quoted with @p quote; returns the index past it, or -1. */
+int findQuote(const QChar *text, int i, int end, QChar quote)
+{
+    for (; i < end; ++i) {
+        if (text[i] == quote) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+int lexHtml(const QChar *text, int end, int state, QVector<Token> *tokens)
+{
+    int mode = state & kHtmlModeMask;
+    int open = state & kHtmlOpenMask;
+    int subState = state >> kHtmlSubStateShift;
+    bool afterEquals = false;
+    int i = 0;
+
+    while (i < end || (mode == HtmlScript || mode == HtmlStyle)) {
+        switch (mode) {
+        case HtmlComment: {
+            int close = -1;
+            for (int k = i; k + 2 < end; ++k) {
+                if (text[k] == QLatin1Char('-') && text[k + 1] == QLatin1Char('-') && text[k + 2] == QLatin1Char('>')) {
+                    close = k + 3;
+                    break;
+                }
+            }
+            if (close < 0) {
+                addToken(tokens, i, end, Lexer::Comment);
+                return HtmlComment;
+            }
+            addToken(tokens, i, close, Lexer::Comment);
+            i = close;
+            mode = HtmlText;
+            break;
+        }
+
+        case HtmlDoubleQuoted:
+        case HtmlSingleQuoted: {
+            const QChar quote = mode == HtmlDoubleQuoted ? QLatin1Char('"') : QLatin1Char('\'');
+            const int close = findQuote(text, i, end, quote);
+            if (close < 0) {
+                addToken(tokens, i, end, Lexer::Value);
+                return mode | open;
+            }
+            addToken(tokens, i, close, Lexer::Value);
+            i = close;
+            mode = HtmlTag;
+            break;
+        }
+
+        case HtmlScript:
+        case HtmlStyle: {
+            const bool script = mode == HtmlScript;
+            const int close = findRawTextEnd(text, i, end, script ? QLatin1String("</script")
+                                                                  : QLatin1String("</style"));
+            subState = script ? lexJavaScript(text, i, close, subState, tokens)
+                              : lexCss(text, i, close, subState, tokens);
+            if (close == end) {
+                return mode | (subState << kHtmlSubStateShift);
+            }
+            i = close;
+            subState = 0;
+            mode = HtmlText;
+            break;
+        }
+
+        case HtmlTag: {
+            const QChar c = text[i];
+            const ushort u = c.unicode();
+            if (isSpace(c)) {
+                ++i;
+            } else if (u == '>') {
+                ++i;
+                mode = open == kHtmlOpenScript ? HtmlScript : open == kHtmlOpenStyle ? HtmlStyle : HtmlText;
+                open = 0;
+                afterEquals = false;
+            } else if (u == '/' && i + 1 < end && text[i + 1] == QLatin1Char('>')) {
+                i += 2;
+                mode = HtmlText;
+                open = 0;
+                afterEquals = false;
+            } else if (u == '=') {
+                afterEquals = true;
+                ++i;
+            } else if (u == '"' || u == '\'') {
+                mode = u == '"' ? HtmlDoubleQuoted : HtmlSingleQuoted;
+                const int close = findQuote(text, i + 1, end, c);
+                if (close < 0) {
+                    addToken(tokens, i, end, Lexer::Value);
+                    return mode | open;
+                }
+                addToken(tokens, i, close, Lexer::Value);
+                i = close;
+                mode = HtmlTag;
+                afterEquals = false;
+            } else {
+                const int start = i++;
+                while (i < end && !isSpace(text[i]) && text[i] != QLatin1Char('>')
+                       && text[i] != QLatin1Char('=') && text[i] != QLatin1Char('"')
+                       && text[i] != QLatin1Char('\'')
+                       && !(text[i] == QLatin1Char('/') && i + 1 < end && text[i + 1] == QLatin1Char('>'))) {
+                    ++i;
+                }
+                addToken(tokens, start, i, afterEquals ? Lexer::Value : Lexer::Attribute);
+                afterEquals = false;
+            }
+            break;
+        }
+
+        case HtmlText:
+        default: {
+            const QChar c = text[i];
+            if (c == QLatin1Char('<')) {
+                if (matchesAt(text, i, end, QLatin1String("<!--"))) {
+                    addToken(tokens, i, i + 4, Lexer::Comment);
+                    i += 4;
+                    mode = HtmlComment;
+                } else if (i + 1 < end && text[i + 1] == QLatin1Char('!')) {
+                    // DOCTYPE and other declarations
+                    int close = i + 2;
+                    while (close < end && text[close] != QLatin1Char('>')) {
+                        ++close;
+                    }
+                    close = qMin(close + 1, end);
+                    addToken(tokens, i, close, Lexer::Keyword);
+                    i = close;
+                } else {
+                    const bool endTag = i + 1 < end && text[i + 1] == QLatin1Char('/');
+                    const int nameStart = i + (endTag ? 2 : 1);
+                    int nameEnd = nameStart;
+                    while (nameEnd < end && isTagNameChar(text[nameEnd])) {
+                        ++nameEnd;
+                    }
+                    if (nameEnd == nameStart || !isAsciiLetter(text[nameStart])) {
+                        ++i;
+                        break;
+                    }
+                    addToken(tokens, i, nameEnd, Lexer::Tag);
+                    open = 0;
+                    if (!endTag) {
+                        const QStringView name(text + nameStart, nameEnd - nameStart);
+                        if (name.compare(QLatin1String("script"), Qt::CaseInsensitive) == 0) {
+                            open = kHtmlOpenScript;
+                        } else if (name.compare(QLatin1String("style"), Qt::CaseInsensitive) == 0) {
+                            open = kHtmlOpenStyle;
+                        }
+                    }
+                    i = nameEnd;
+                    mode = HtmlTag;
+                    afterEquals = false;
+                }
+            } else if (c == QLatin1Char('&')) {
+                int k = i + 1;
+                while (k < end && (isAsciiLetter(text[k]) || isDigit(text[k]) || text[k] == QLatin1Char('#'))) {
+                    ++k;
+                }
+                if (k < end && k > i + 1 && text[k] == QLatin1Char(';')) {
+                    addToken(tokens, i, k + 1, Lexer::Value);
+                    i = k + 1;
+                } else {
+                    ++i;
+                }
+            } else {
+                // Plain text runs up to the next markup character
+                ++i;
+                while (i < end && text[i] != QLatin1Char('<') && text[i] != QLatin1Char('&')) {
+                    ++i;
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    return mode | open;
+}
+}
+
+/**
+ * @brief Maps a language name as used by SyntaxHighlighter to a language.
+ *
+ * @param name The language name (e.g. "html", "css", "javascript", "js").
+ * @return The language, or Language::Plain if it is not supported.
+ */
+Lexer::Language Lexer::languageFromName(const QString &name)
+{
+    const QString language = name.toLower();
+    if (language == "html" || language == "htm") {
+        return Language::Html;
+    }
+    if (language == "css") {
+        return Language::Css;
+    }
+    if (language == "javascript" || language == "js") {
+        return Language::JavaScript;
+    }
+    return Language::Plain;
+}
+
+/**
+ * @brief Tokenizes one line.
+ *
+ * @param language The language of the line.
+ * @param text The line, without its line terminator.
+ * @param state The state at the end of the previous line; negative for none.
+ * @param tokens Receives the tokens of the line, in order. It is cleared first.
+ * @return The state at the end of this line.
+ */
+int Lexer::tokenize(Language language, QStringView text, int state, QVector<Token> *tokens)
+{
+    tokens->clear();
+    if (state < 0) {
+        state = 0;
+    }
+
+    const QChar *data = text.data();
+    const int length = int(text.size());
+
+    switch (language) {
+    case Language::Html:
+        return lexHtml(data, length, state, tokens);
+    case Language::Css:
+        return lexCss(data, 0, length, state, tokens);
+    case Language::JavaScript:
+        return lexJavaScript(data, 0, length, state, tokens);
+    case Language::Plain:
+        break;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file lexer.h
+ * @brief Declaration of the Lexer class.
+ *
+ * This file contains the Lexer class which splits lines of HTML, CSS and
+ * JavaScript into highlighting tokens in a single linear pass.
+ */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief The Lexer class tokenizes source code one line at a time.
+ *
+ * Each language is a small hand-written state machine that walks a line once,
+ * character by character. Constructs that span lines (comments, template
+ * literals, open tags, embedded scripts and stylesheets) are carried from one
+ * line to the next in an integer state, which is what QSyntaxHighlighter keeps
+ * as the block state. Keywords are recognised with a perfect-hash lookup, so
+ * identifying one costs a hash and a single string comparison.
+ *
+ * The lexer has no side effects and keeps no state of its own; the same line
+ * with the same incoming state always yields the same tokens.
+ */
+class Lexer
+{
+public:
+    /**
+     * @brief The languages the lexer understands.
+     */
+    enum class Language {
+        Plain,      /**< No highlighting. */
+        Html,       /**< HTML, including embedded scripts and stylesheets. */
+        Css,        /**< CSS stylesheets. */
+        JavaScript  /**< JavaScript. */
+    };
+
+    /**
+     * @brief The kinds of tokens the highlighter formats.
+     */
+    enum TokenType : quint8 {
+        Keyword,
+        Tag,
+        Attribute,
+        Value,
+        Comment,
+        String,
+        Number,
+        Function,
+        TokenTypeCount
+    };
+
+    /**
+     * @brief A highlighted span of a line.
+     */
+    struct Token
+    {
+        int start;        /**< Offset of the first character in the line. */
+        int length;       /**< Number of characters. */
+        TokenType type;   /**< What the span is. */
+    };
+
+    /**
+     * @brief Maps a language name as used by SyntaxHighlighter to a language.
+     *
+     * @param name The language name (e.g. "html", "css", "javascript", "js").
+     * @return The language, or Language::Plain if it is not supported.
+     */
+    static Language languageFromName(const QString &name);
+
+    /**
+     * @brief Tokenizes one line.
+     *
+     * @param language The language of the line.
+     * @param text The line, without its line terminator.
+     * @param state The state at the end of the previous line; negative for none.
+     * @param tokens Receives the tokens of the line, in order. It is cleared first.
+     * @return The state at the end of this line.
+     */
+    static int tokenize(Language language, QStringView text, int state, QVector<Token> *tokens);
+};
+
+#endif // LEXER_H
@@ -0,0 +1,161 @@
+/**
+ * @file lineindex.cpp
+ * @brief Implementation of the LineIndex class.
+ *
+ * This file contains the newline scanner and the line lookups.
+ */
+
+#include "lineindex.h"
+#include "simd.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+/**
+ * @brief Records a line break.
+ *
+ * @param offset Offset of the '\n'.
+ * @param state Progress of the scan, updated.
+ * @param checkpoints Receives the start of the next line if it is a checkpoint.
+ */
+inline void addLineBreak(qint64 offset, LineIndex::ScanState *state, QVector<qint64> *checkpoints)
+{
+    state->maxLineLength = qMax(state->maxLineLength, offset - state->lineStart);
+    state->lineStart = offset + 1;
+    if (state->lineCount % LineIndex::kStride == 0) {
+        checkpoints->append(state->lineStart);
+    }
+    ++state->lineCount;
+}
+}
+
+/**
+ * @brief Scans part of a buffer for line breaks.
+ *
+ * @param data The whole buffer.
+ * @param begin Offset where this step starts; the previous step ended here.
+ * @param end Offset where this step ends.
+ * @param state Progress of the scan, updated.
+ * @param checkpoints Receives the checkpoints found in this step.
+ */
+void LineIndex::scan(const char *data, qint64 begin, qint64 end, ScanState *state,
+                     QVector<qint64> *checkpoints)
+{
+    qint64 i = begin;
+#ifdef RAPID_HAVE_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (i + 16 <= end) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        uint mask = uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask) {
+            addLineBreak(i + qCountTrailingZeroBits(mask), state, checkpoints);
+            mask &= mask - 1;
+        }
+        i += 16;
+    }
+#endif
+    for (; i < end; ++i) {
+        if (data[i] == '\n') {
+            addLineBreak(i, state, checkpoints);
+        }
+    }
+}
+
+/**
+ * @brief Accounts for the last line once the whole buffer has been scanned.
+ *
+ * @param size Size of the buffer.
+ * @param state Progress of the scan, updated.
+ */
+void LineIndex::finish(qint64 size, ScanState *state)
+{
+    state->maxLineLength = qMax(state->maxLineLength, size - state->lineStart);
+}
+
+/**
+ * @brief Returns the end of the line starting at @p lineStart.
+ *
+ * @param data The buffer.
+ * @param size Size of the buffer.
+ * @param lineStart Offset of the line.
+ * @return Offset of the line's '\n', or @p size for the last line.
+ */
+qint64 LineIndex::lineEnd(const char *data, qint64 size, qint64 lineStart)
+{
+    const void *newline = std::memchr(data + lineStart, '\n', size_t(size - lineStart));
+    return newline ? static_cast<const char *>(newline) - data : size;
+}
+
+/**
+ * @brief Constructs an index of an empty buffer.
+ */
+LineIndex::LineIndex()
+{
+    clear();
+}
+
+/**
+ * @brief Forgets all lines.
+ */
+void LineIndex::clear()
+{
+    m_checkpoints = {0};
+    m_lineCount = 1;
+    m_indexedBytes = 0;
+    m_maxLineLength = 0;
+}
+
+/**
+ * @brief Adds the result of a scan step.
+ *
+ * @param checkpoints The checkpoints found in the step.
+ * @param state Progress of the scan after the step.
+ * @param indexedBytes Offset the scan has reached.
+ */
+void LineIndex::append(const QVector<qint64> &checkpoints, const ScanState &state, qint64 indexedBytes)
+{
+    m_checkpoints += checkpoints;
+    m_lineCount = state.lineCount;
+    m_indexedBytes = indexedBytes;
+    m_maxLineLength = state.maxLineLength;
+}
+
+/**
+ * @brief Returns the offset of a line.
+ *
+ * @param data The buffer.
+ * @param line The line, less than lineCount().
+ * @return Offset of the first byte of the line.
+ */
+qint64 LineIndex::lineStart(const char *data, qint64 line) const
+{
+    Q_ASSERT(line >= 0 && line < m_lineCount);
+
+    qint64 offset = m_checkpoints.at(line / kStride);
+    for (qint64 skip = line % kStride; skip > 0; --skip) {
+        offset = static_cast<const char *>(std::memchr(data + offset, '\n', size_t(m_indexedBytes - offset))) - data + 1;
+    }
+    return offset;
+}
+
+/**
+ * @brief Returns the line that contains a byte.
+ *
+ * @param data The buffer.
+ * @param offset Offset of the byte, less than indexedBytes().
+ * @return The line.
+ */
+qint64 LineIndex::lineForOffset(const char *data, qint64 offset) const
+{
+    const auto checkpoint = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), offset) - 1;
+    qint64 line = (checkpoint - m_checkpoints.cbegin()) * kStride;
+    qint64 position = *checkpoint;
+    while (const void *newline = std::memchr(data + position, '\n', size_t(offset - position))) {
+        position = static_cast<const char *>(newline) - data + 1;
+        ++line;
+    }
+    return line;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file lineindex.h
+ * @brief Declaration of the LineIndex class.
+ *
+ * This file contains the LineIndex class which maps line numbers to byte
+ * offsets in a file that is too large to hold as text.
+ */
+
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <QVector>
+
+/**
+ * @brief The LineIndex class finds lines in a buffer of bytes.
+ *
+ * Rather than the start of every line, only the start of every kStride-th
+ * line is stored (a checkpoint), which keeps the index of a file with a
+ * hundred million lines to a few megabytes. A line is found by going to the
+ * checkpoint before it and stepping over at most kStride - 1 line breaks.
+ *
+ * The index is built with scan(), typically on a worker thread, in as many
+ * steps as convenient; the checkpoints of each step are then handed to the
+ * index with append(). Newlines are found sixteen bytes at a time with SSE2
+ * where the compiler targets it.
+ *
+ * Lines are separated by '\n'; a '\r' before it is part of the line.
+ */
+class LineIndex
+{
+public:
+    /** Number of lines from one checkpoint to the next. */
+    static constexpr qint64 kStride = 128;
+
+    /**
+     * @brief Progress of a scan, carried from one step to the next.
+     */
+    struct ScanState
+    {
+        qint64 lineCount = 1;      /**< Lines started so far. */
+        qint64 lineStart = 0;      /**< Offset of the line being scanned. */
+        qint64 maxLineLength = 0;  /**< Length in bytes of the longest complete line. */
+    };
+
+    /**
+     * @brief Scans part of a buffer for line breaks.
+     *
+     * @param data The whole buffer.
+     * @param begin Offset where this step starts; the previous step ended here.
+     * @param end Offset where this step ends.
+     * @param state Progress of the scan, updated.
+     * @param checkpoints Receives the checkpoints found in this step.
+     */
+    static void scan(const char *data, qint64 begin, qint64 end, ScanState *state,
+                     QVector<qint64> *checkpoints);
+
+    /**
+     * @brief Accounts for the last line once the whole buffer has been scanned.
+     *
+     * @param size Size of the buffer.
+     * @param state Progress of the scan, updated.
+     */
+    static void finish(qint64 size, ScanState *state);
+
+    /**
+     * @brief Returns the end of the line starting at @p lineStart.
+     *
+     * @param data The buffer.
+     * @param size Size of the buffer.
+     * @param lineStart Offset of the line.
+     * @return Offset of the line's '\n', or @p size for the last line.
+     */
+    static qint64 lineEnd(const char *data, qint64 size, qint64 lineStart);
+
+    /**
+     * @brief Constructs an index of an empty buffer.
+     */
+    LineIndex();
+
+    /**
+     * @brief Forgets all lines.
+     */
+    void clear();
+
+    /**
+     * @brief Adds the result of a scan step.
+     *
+     * @param checkpoints The checkpoints found in the step.
+     * @param state Progress of the scan after the step.
+     * @param indexedBytes Offset the scan has reached.
+     */
+    void append(const QVector<qint64> &checkpoints, const ScanState &state, qint64 indexedBytes);
+
+    /** @return Number of lines found so far. */
+    qint64 lineCount() const { return m_lineCount; }
+
+    /** @return Number of bytes scanned so far. */
+    qint64 indexedBytes() const { return m_indexedBytes; }
+
+    /** @return Length in bytes of the longest line found so far. */
+    qint64 maxLineLength() const { return m_maxLineLength; }
+
+    /**
+     * @brief Returns the offset of a line.
+     *
+     * @param data The buffer.
+     * @param line The line, less than lineCount().
+     * @return Offset of the first byte of the line.
+     */
+    qint64 lineStart(const char *data, qint64 line) const;
+
+    /**
+     * @brief Returns the line that contains a byte.
+     *
+     * @param data The buffer.
+     * @param offset Offset of the byte, less than indexedBytes().
+     * @return The line.
+     */
+    qint64 lineForOffset(const char *data, qint64 offset) const;
+
+private:
+    QVector<qint64> m_checkpoints;  /**< Offset of every kStride-th line. */
+    qint64 m_lineCount = 1;         /**< Lines found so far. */
+    qint64 m_indexedBytes = 0;      /**< Bytes scanned so far. */
+    qint64 m_maxLineLength = 0;     /**< Longest line found so far. */
+};
+
+#endif // LINEINDEX_H
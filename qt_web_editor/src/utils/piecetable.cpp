@@ -0,0 +1,358 @@
+/**
+ * @file piecetable.cpp
+ * @brief Implementation of the PieceTable and TextSnapshot classes.
+ *
+ * This file contains the piece bookkeeping of the table and the readers of
+ * its snapshots.
+ */
+
+#include "piecetable.h"
+
+#include <cstring>
+
+namespace {
+/**
+ * @brief Counts the UTF-16 code units of UTF-8 text.
+ *
+ * Every byte but a continuation byte starts a character, and only characters
+ * of four bytes take two code units.
+ *
+ * @param data The text.
+ * @param size Size of the text in bytes.
+ * @return The length in UTF-16 code units.
+ */
+qint64 utf16Length(const char *data, qint64 size)
+{
+    qint64 length = 0;
+    for (qint64 i = 0; i < size; ++i) {
+        const uchar c = static_cast<uchar>(data[i]);
+        if ((c & 0xC0) != 0x80) {
+            length += c >= 0xF0 ? 2 : 1;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Finds the byte where a UTF-16 position falls in UTF-8 text.
+ *
+ * @param data The text.
+ * @param size Size of the text in bytes.
+ * @param length Length of the text in UTF-16 code units.
+ * @param position The position in UTF-16 code units.
+ * @return The offset in bytes.
+ */
+qint64 byteOffset(const char *data, qint64 size, qint64 length, qint64 position)
+{
+    // Only ASCII takes as many bytes as code units
+    if (size == length) {
+        return position;
+    }
+    qint64 offset = 0;
+    while (position > 0 && offset < size) {
+        const uchar c = static_cast<uchar>(data[offset]);
+        const int bytes = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        position -= bytes == 4 ? 2 : 1;
+        offset += bytes;
+    }
+    return qMin(offset, size);
+}
+}
+
+/**
+ * @brief Returns the bytes of a piece.
+ *
+ * @param index The piece, from 0 to pieceCount() - 1.
+ * @return The UTF-8 bytes of the piece.
+ */
+QByteArrayView TextSnapshot::piece(int index) const
+{
+    const Piece &p = m_pieces.at(index);
+    return QByteArrayView(p.data, p.size);
+}
+
+/**
+ * @brief Copies bytes of the text.
+ *
+ * @param offset Offset in bytes where copying starts.
+ * @param data Receives the bytes.
+ * @param maxSize Maximum number of bytes to copy.
+ * @return Number of bytes copied.
+ */
+qint64 TextSnapshot::read(qint64 offset, char *data, qint64 maxSize) const
+{
+    qint64 copied = 0;
+    qint64 pieceStart = 0;
+    for (const Piece &p : m_pieces) {
+        if (copied == maxSize) {
+            break;
+        }
+        if (pieceStart + p.size > offset) {
+            const qint64 from = qMax<qint64>(offset - pieceStart, 0);
+            const qint64 count = qMin(p.size - from, maxSize - copied);
+            std::memcpy(data + copied, p.data + from, count);
+            copied += count;
+        }
+        pieceStart += p.size;
+    }
+    return copied;
+}
+
+/**
+ * @brief Returns part of the text.
+ *
+ * @param position Start of the part in UTF-16 code units.
+ * @param length Length of the part in UTF-16 code units.
+ * @return The text.
+ */
+QString TextSnapshot::text(qint64 position, qint64 length) const
+{
+    position = qBound<qint64>(0, position, m_length);
+    length = qBound<qint64>(0, length, m_length - position);
+    if (length == 0) {
+        return QString();
+    }
+
+    // Byte offsets of both ends
+    const qint64 end = position + length;
+    qint64 from = -1;
+    qint64 to = m_size;
+    qint64 pieceStart = 0;
+    qint64 pieceOffset = 0;
+    for (const Piece &p : m_pieces) {
+        if (from < 0 && position < pieceStart + p.length) {
+            from = pieceOffset + byteOffset(p.data, p.size, p.length, position - pieceStart);
+        }
+        if (end <= pieceStart + p.length) {
+            to = pieceOffset + byteOffset(p.data, p.size, p.length, end - pieceStart);
+            break;
+        }
+        pieceStart += p.length;
+        pieceOffset += p.size;
+    }
+
+    QByteArray bytes(to - from, Qt::Uninitialized);
+    read(from, bytes.data(), bytes.size());
+    return QString::fromUtf8(bytes);
+}
+
+/**
+ * @brief Returns the whole text as UTF-8.
+ *
+ * @return The bytes of every piece, in order.
+ */
+QByteArray TextSnapshot::toUtf8() const
+{
+    QByteArray bytes(m_size, Qt::Uninitialized);
+    read(0, bytes.data(), m_size);
+    return bytes;
+}
+
+/**
+ * @brief Returns the whole text.
+ *
+ * @return The text decoded from UTF-8.
+ */
+QString TextSnapshot::toString() const
+{
+    return QString::fromUtf8(toUtf8());
+}
+
+/**
+ * @brief Finds the piece holding a position.
+ *
+ * @param position The position in UTF-16 code units.
+ * @param pieceStart Receives the position where the piece starts.
+ * @return The index of the piece, or pieceCount() at the end of the text.
+ */
+int TextSnapshot::findPiece(qint64 position, qint64 *pieceStart) const
+{
+    qint64 start = 0;
+    for (int i = 0; i < m_pieces.size(); ++i) {
+        if (position < start + m_pieces.at(i).length) {
+            *pieceStart = start;
+            return i;
+        }
+        start += m_pieces.at(i).length;
+    }
+    *pieceStart = start;
+    return m_pieces.size();
+}
+
+/**
+ * @brief Constructs an empty table.
+ */
+PieceTable::PieceTable()
+{
+    m_text.m_storage = std::make_shared<TextSnapshot::Storage>();
+}
+
+/**
+ * @brief Replaces the whole text; it becomes the original text.
+ *
+ * The table starts on fresh storage, so snapshots taken before keep theirs.
+ *
+ * @param text The new text.
+ */
+void PieceTable::setText(QStringView text)
+{
+    auto storage = std::make_shared<TextSnapshot::Storage>();
+    storage->original = text.toUtf8();
+
+    m_text.m_storage = storage;
+    m_text.m_pieces.clear();
+    m_text.m_size = storage->original.size();
+    m_text.m_length = text.size();
+    ++m_text.m_revision;
+    m_blockFree = nullptr;
+    m_blockAvailable = 0;
+
+    appendPieces(0, storage->original.constData(), storage->original.size());
+}
+
+/**
+ * @brief Empties the table.
+ */
+void PieceTable::clear()
+{
+    setText(QStringView());
+}
+
+/**
+ * @brief Inserts text.
+ *
+ * The text is appended to the add buffer. When it continues the piece just
+ * before the position, as when typing, that piece is extended instead of a
+ * new one being made.
+ *
+ * @param position Where to insert, in UTF-16 code units.
+ * @param text The text to insert.
+ */
+void PieceTable::insert(qint64 position, QStringView text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    position = qBound<qint64>(0, position, m_text.m_length);
+
+    const QByteArray bytes = text.toUtf8();
+    const qint64 size = bytes.size();
+    const int index = split(position);
+
+    m_text.m_size += size;
+    m_text.m_length += text.size();
+    ++m_text.m_revision;
+
+    // The current block has bytes in it, so only an added piece can end at m_blockFree
+    if (index > 0 && size <= m_blockAvailable && m_blockAvailable < kBlockSize) {
+        TextSnapshot::Piece &before = m_text.m_pieces[index - 1];
+        if (before.data + before.size == m_blockFree && before.size + size <= kMaxPieceSize) {
+            std::memcpy(m_blockFree, bytes.constData(), size);
+            before.size += size;
+            before.length += text.size();
+            m_blockFree += size;
+            m_blockAvailable -= size;
+            return;
+        }
+    }
+
+    char *data = nullptr;
+    if (size > kBlockSize) {
+        // Large pastes get a block of their own
+        m_text.m_storage->blocks.emplace_back(new char[size]);
+        data = m_text.m_storage->blocks.back().get();
+    } else {
+        if (size > m_blockAvailable) {
+            m_text.m_storage->blocks.emplace_back(new char[kBlockSize]);
+            m_blockFree = m_text.m_storage->blocks.back().get();
+            m_blockAvailable = kBlockSize;
+        }
+        data = m_blockFree;
+        m_blockFree += size;
+        m_blockAvailable -= size;
+    }
+    std::memcpy(data, bytes.constData(), size);
+    appendPieces(index, data, size);
+}
+
+/**
+ * @brief Removes text.
+ *
+ * @param position Start of the text to remove, in UTF-16 code units.
+ * @param length Length of the text to remove, in UTF-16 code units.
+ */
+void PieceTable::remove(qint64 position, qint64 length)
+{
+    position = qBound<qint64>(0, position, m_text.m_length);
+    length = qBound<qint64>(0, length, m_text.m_length - position);
+    if (length == 0) {
+        return;
+    }
+
+    ++m_text.m_revision;
+    const int first = split(position);
+    const int last = split(position + length);
+    for (int i = first; i < last; ++i) {
+        m_text.m_size -= m_text.m_pieces.at(i).size;
+        m_text.m_length -= m_text.m_pieces.at(i).length;
+    }
+    m_text.m_pieces.remove(first, last - first);
+}
+
+/**
+ * @brief Makes a piece start at a position, splitting the piece around it.
+ *
+ * @param position The position in UTF-16 code units.
+ * @return The index of the piece starting at the position.
+ */
+int PieceTable::split(qint64 position)
+{
+    qint64 pieceStart = 0;
+    const int index = m_text.findPiece(position, &pieceStart);
+    if (index == m_text.m_pieces.size() || pieceStart == position) {
+        return index;
+    }
+
+    TextSnapshot::Piece &head = m_text.m_pieces[index];
+    const qint64 offset = byteOffset(head.data, head.size, head.length, position - pieceStart);
+
+    TextSnapshot::Piece tail;
+    tail.data = head.data + offset;
+    tail.size = head.size - offset;
+    tail.length = utf16Length(tail.data, tail.size);
+    head.size = offset;
+    head.length -= tail.length;
+
+    m_text.m_pieces.insert(index + 1, tail);
+    return index + 1;
+}
+
+/**
+ * @brief Inserts pieces for stored bytes, cutting them to kMaxPieceSize.
+ *
+ * Cuts fall between UTF-8 sequences. The totals of the text are not updated.
+ *
+ * @param index Where to insert the pieces.
+ * @param data The bytes, in the storage.
+ * @param size Number of bytes.
+ * @return The index after the last piece inserted.
+ */
+int PieceTable::appendPieces(int index, const char *data, qint64 size)
+{
+    while (size > 0) {
+        qint64 count = qMin(size, kMaxPieceSize);
+        while (count < size && count > 0 && (static_cast<uchar>(data[count]) & 0xC0) == 0x80) {
+            --count;
+        }
+
+        TextSnapshot::Piece piece;
+        piece.data = data;
+        piece.size = count;
+        piece.length = utf16Length(data, count);
+        m_text.m_pieces.insert(index++, piece);
+
+        data += count;
+        size -= count;
+    }
+    return index;
+}
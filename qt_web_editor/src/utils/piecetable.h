@@ -0,0 +1,217 @@
+/**
+ * @file piecetable.h
+ * @brief Declaration of the PieceTable and TextSnapshot classes.
+ *
+ * This file contains the PieceTable class which keeps a text as UTF-8 pieces,
+ * and the TextSnapshot class which is a frozen, shareable view of it.
+ */
+
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QMetaType>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The TextSnapshot class is an immutable copy of a PieceTable.
+ *
+ * Taking a snapshot costs O(1): it shares the bytes of the table and the list
+ * of pieces is implicitly shared until the table is edited again. The bytes
+ * are never modified or moved once written, so a snapshot can be read on any
+ * thread while the table goes on being edited on the GUI thread.
+ *
+ * Every edit of the table gives it a new revision, which snapshots carry: two
+ * snapshots of a table with the same revision hold the same text, so work
+ * done for one snapshot need not be repeated for the next.
+ *
+ * Positions and lengths are in UTF-16 code units, as in QString and
+ * QTextDocument; size() is in bytes of UTF-8.
+ */
+class TextSnapshot
+{
+public:
+    /** @brief Constructs an empty snapshot. */
+    TextSnapshot() = default;
+
+    /** @return Size of the text in bytes of UTF-8. */
+    qint64 size() const { return m_size; }
+
+    /** @return Length of the text in UTF-16 code units. */
+    qint64 length() const { return m_length; }
+
+    /** @return True if the text is empty. */
+    bool isEmpty() const { return m_size == 0; }
+
+    /** @return Revision of the table the snapshot was taken from; 0 before the first edit. */
+    quint64 revision() const { return m_revision; }
+
+    /** @return Number of pieces the text is made of. */
+    int pieceCount() const { return m_pieces.size(); }
+
+    /**
+     * @brief Returns the bytes of a piece; pieces never split a UTF-8 sequence.
+     *
+     * @param index The piece, from 0 to pieceCount() - 1.
+     * @return The UTF-8 bytes of the piece.
+     */
+    QByteArrayView piece(int index) const;
+
+    /**
+     * @brief Copies bytes of the text.
+     *
+     * @param offset Offset in bytes where copying starts.
+     * @param data Receives the bytes.
+     * @param maxSize Maximum number of bytes to copy.
+     * @return Number of bytes copied.
+     */
+    qint64 read(qint64 offset, char *data, qint64 maxSize) const;
+
+    /**
+     * @brief Returns part of the text.
+     *
+     * @param position Start of the part in UTF-16 code units.
+     * @param length Length of the part in UTF-16 code units.
+     * @return The text.
+     */
+    QString text(qint64 position, qint64 length) const;
+
+    /** @return The whole text as UTF-8. */
+    QByteArray toUtf8() const;
+
+    /** @return The whole text. */
+    QString toString() const;
+
+private:
+    friend class PieceTable;
+
+    /**
+     * @brief The bytes shared by a table and its snapshots.
+     *
+     * The original text is kept as loaded; typed and pasted text goes to
+     * fixed-size blocks that are appended to and never reallocated.
+     */
+    struct Storage
+    {
+        QByteArray original;                         /**< Text the table was set to. */
+        std::vector<std::unique_ptr<char[]>> blocks; /**< Text added since. */
+    };
+
+    /**
+     * @brief A run of the text stored contiguously.
+     */
+    struct Piece
+    {
+        const char *data = nullptr; /**< First byte, in the storage. */
+        qint64 size = 0;            /**< Size in bytes. */
+        qint64 length = 0;          /**< Length in UTF-16 code units. */
+    };
+
+    int findPiece(qint64 position, qint64 *pieceStart) const;
+
+    std::shared_ptr<Storage> m_storage; /**< Bytes the pieces point into. */
+    QVector<Piece> m_pieces;            /**< The text, in order. */
+    qint64 m_size = 0;                  /**< Total size in bytes. */
+    qint64 m_length = 0;                /**< Total length in UTF-16 code units. */
+    quint64 m_revision = 0;             /**< Revision of the table. */
+};
+
+Q_DECLARE_METATYPE(TextSnapshot)
+
+/**
+ * @brief The PieceTable class stores an editable text as UTF-8.
+ *
+ * The text is a list of pieces pointing either into the original text, which
+ * is stored once as it was set, or into an append-only add buffer holding
+ * everything inserted since. An edit only splits and inserts pieces; no byte
+ * is moved. Characters typed one after the other extend a single piece, and
+ * pieces are kept under kMaxPieceSize so that finding a position stays cheap
+ * in large texts.
+ *
+ * Web sources are mostly ASCII, which takes half the space in UTF-8 that it
+ * takes in a QString.
+ */
+class PieceTable
+{
+public:
+    /** Largest size of a piece in bytes. */
+    static constexpr qint64 kMaxPieceSize = 64 * 1024;
+
+    /** Size of a block of the add buffer in bytes. */
+    static constexpr qint64 kBlockSize = 64 * 1024;
+
+    /**
+     * @brief Constructs an empty table.
+     */
+    PieceTable();
+
+    /**
+     * @brief Replaces the whole text; it becomes the original text.
+     *
+     * Snapshots taken before keep the previous text.
+     *
+     * @param text The new text.
+     */
+    void setText(QStringView text);
+
+    /**
+     * @brief Empties the table.
+     */
+    void clear();
+
+    /**
+     * @brief Inserts text.
+     *
+     * @param position Where to insert, in UTF-16 code units.
+     * @param text The text to insert.
+     */
+    void insert(qint64 position, QStringView text);
+
+    /**
+     * @brief Removes text.
+     *
+     * @param position Start of the text to remove, in UTF-16 code units.
+     * @param length Length of the text to remove, in UTF-16 code units.
+     */
+    void remove(qint64 position, qint64 length);
+
+    /** @return Size of the text in bytes of UTF-8. */
+    qint64 size() const { return m_text.size(); }
+
+    /** @return Length of the text in UTF-16 code units. */
+    qint64 length() const { return m_text.length(); }
+
+    /** @return Revision of the text; every edit increases it. */
+    quint64 revision() const { return m_text.revision(); }
+
+    /**
+     * @brief Returns part of the text.
+     *
+     * @param position Start of the part in UTF-16 code units.
+     * @param length Length of the part in UTF-16 code units.
+     * @return The text.
+     */
+    QString text(qint64 position, qint64 length) const { return m_text.text(position, length); }
+
+    /** @return The whole text. */
+    QString toString() const { return m_text.toString(); }
+
+    /** @return The current text, in O(1). */
+    TextSnapshot snapshot() const { return m_text; }
+
+private:
+    int split(qint64 position);
+    int appendPieces(int index, const char *data, qint64 size);
+
+    TextSnapshot m_text;           /**< Pieces of the current text and their storage. */
+    char *m_blockFree = nullptr;   /**< First unused byte of the current add block. */
+    qint64 m_blockAvailable = 0;   /**< Unused bytes in the current add block. */
+};
+
+#endif // PIECETABLE_H
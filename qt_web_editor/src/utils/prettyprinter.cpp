@@ -0,0 +1,260 @@
+/**
+ * @file prettyprinter.cpp
+ * @brief Implementation of the PrettyPrinter class.
+ *
+ * This file contains the single-pass reformatter for CSS and JavaScript.
+ */
+
+#include "prettyprinter.h"
+
+namespace {
+/**
+ * @brief Builds the reformatted text line by line.
+ */
+class Writer
+{
+public:
+    Writer(int indentSize, qsizetype sizeHint)
+        : m_indentSize(indentSize)
+    {
+        m_out.reserve(sizeHint + sizeHint / 4);
+    }
+
+    /** Writes text, indenting it if it starts a line. */
+    void write(QStringView text)
+    {
+        if (m_lineStart) {
+            m_out.append(QString(m_depth * m_indentSize, QLatin1Char(' ')));
+            m_lineStart = false;
+        } else if (m_space) {
+            m_out.append(QLatin1Char(' '));
+        }
+        m_space = false;
+        m_out.append(text);
+    }
+
+    /** Ends the current line, unless it is empty. */
+    void newline()
+    {
+        if (!m_lineStart) {
+            m_out.append(QLatin1Char('\n'));
+            m_lineStart = true;
+        }
+        m_space = false;
+    }
+
+    /** Separates the next text from the previous one by a space. */
+    void space() { m_space = !m_lineStart; }
+
+    void indent() { ++m_depth; }
+    void outdent() { m_depth = qMax(0, m_depth - 1); }
+
+    QString result()
+    {
+        newline();
+        return m_out;
+    }
+
+private:
+    QString m_out;
+    int m_indentSize;
+    int m_depth = 0;
+    bool m_lineStart = true;
+    bool m_space = false;
+};
+
+/**
+ * @brief Finds the end of a string or template literal.
+ *
+ * @param source The source.
+ * @param start Offset of the opening quote.
+ * @return Offset just past the closing quote, or the end of the source.
+ */
+qsizetype skipString(QStringView source, qsizetype start)
+{
+    const QChar quote = source[start];
+    for (qsizetype i = start + 1; i < source.size(); ++i) {
+        if (source[i] == QLatin1Char('\\')) {
+            ++i;
+        } else if (source[i] == quote) {
+            return i + 1;
+        } else if (source[i] == QLatin1Char('\n') && quote != QLatin1Char('`')) {
+            return i;
+        }
+    }
+    return source.size();
+}
+
+/**
+ * @brief Finds the end of a regular expression literal.
+ *
+ * @param source The source.
+ * @param start Offset of the opening slash.
+ * @return Offset just past the closing slash, or of the line break ending an unterminated literal.
+ */
+qsizetype skipRegExp(QStringView source, qsizetype start)
+{
+    bool inClass = false;
+    for (qsizetype i = start + 1; i < source.size(); ++i) {
+        const QChar c = source[i];
+        if (c == QLatin1Char('\\')) {
+            ++i;
+        } else if (c == QLatin1Char('[')) {
+            inClass = true;
+        } else if (c == QLatin1Char(']')) {
+            inClass = false;
+        } else if (c == QLatin1Char('/') && !inClass) {
+            return i + 1;
+        } else if (c == QLatin1Char('\n')) {
+            return i;
+        }
+    }
+    return source.size();
+}
+
+/**
+ * @brief Checks whether a slash starts a regular expression rather than a division.
+ *
+ * @param previous The last character written before it that is not whitespace.
+ * @return True if a value cannot precede the slash.
+ */
+bool startsRegExp(QChar previous)
+{
+    return previous.isNull() || QStringView(u"(,=:[!&|?{};+-*%<>~^").contains(previous);
+}
+
+/**
+ * @brief Checks whether a character can be copied as part of an ordinary run.
+ */
+bool isPlain(QChar c)
+{
+    return !c.isSpace() && !QStringView(u"{}();,'\"`/").contains(c);
+}
+}
+
+/**
+ * @brief Checks whether a language can be reformatted.
+ *
+ * @param language The language.
+ * @return True for CSS and JavaScript, which includes JSON.
+ */
+bool PrettyPrinter::supports(Lexer::Language language)
+{
+    return language == Lexer::Language::Css || language == Lexer::Language::JavaScript;
+}
+
+/**
+ * @brief Reformats source code.
+ *
+ * @param language The language of the source; see supports().
+ * @param source The source.
+ * @param indentSize Number of spaces per level of indentation.
+ * @return The reformatted source.
+ */
+QString PrettyPrinter::format(Lexer::Language language, QStringView source, int indentSize)
+{
+    const bool javaScript = language == Lexer::Language::JavaScript;
+    Writer writer(indentSize, source.size());
+    int parens = 0;
+    QChar previous;
+
+    qsizetype i = 0;
+    while (i < source.size()) {
+        const QChar c = source[i];
+
+        if (c.isSpace()) {
+            // Line breaks of the source are kept; other whitespace collapses
+            bool lineBreak = false;
+            for (; i < source.size() && source[i].isSpace(); ++i) {
+                lineBreak |= source[i] == QLatin1Char('\n');
+            }
+            if (lineBreak) {
+                writer.newline();
+            } else {
+                writer.space();
+            }
+            continue;
+        }
+
+        const QChar next = i + 1 < source.size() ? source[i + 1] : QChar();
+        qsizetype end = i + 1;
+
+        if (c == QLatin1Char('"') || c == QLatin1Char('\'') || (javaScript && c == QLatin1Char('`'))) {
+            end = skipString(source, i);
+            writer.write(source.mid(i, end - i));
+        } else if (c == QLatin1Char('/') && next == QLatin1Char('*')) {
+            const qsizetype close = source.indexOf(u"*/", i + 2);
+            end = close < 0 ? source.size() : close + 2;
+            writer.write(source.mid(i, end - i));
+        } else if (javaScript && c == QLatin1Char('/') && next == QLatin1Char('/')) {
+            const qsizetype close = source.indexOf(QLatin1Char('\n'), i);
+            end = close < 0 ? source.size() : close;
+            writer.write(source.mid(i, end - i));
+            writer.newline();
+        } else if (javaScript && c == QLatin1Char('/') && startsRegExp(previous)) {
+            end = skipRegExp(source, i);
+            writer.write(source.mid(i, end - i));
+        } else if (c == QLatin1Char('{')) {
+            // Empty blocks stay on one line
+            qsizetype close = i + 1;
+            while (close < source.size() && source[close].isSpace()) {
+                ++close;
+            }
+            writer.space();
+            if (close < source.size() && source[close] == QLatin1Char('}')) {
+                writer.write(u"{}");
+                end = close + 1;
+            } else {
+                writer.write(u"{");
+                writer.indent();
+                writer.newline();
+            }
+        } else if (c == QLatin1Char('}')) {
+            writer.outdent();
+            writer.newline();
+            writer.write(u"}");
+
+            // Keep "},", "});" and "} else" together
+            qsizetype after = i + 1;
+            while (after < source.size() && source[after] == QLatin1Char(' ')) {
+                ++after;
+            }
+            const QStringView rest = source.mid(after);
+            if (rest.startsWith(u"else") || rest.startsWith(u"catch") || rest.startsWith(u"finally")
+                || rest.startsWith(u"while")) {
+                writer.space();
+            } else if (!rest.startsWith(QLatin1Char(',')) && !rest.startsWith(QLatin1Char(';'))
+                       && !rest.startsWith(QLatin1Char(')')) && !rest.startsWith(QLatin1Char('.'))) {
+                writer.newline();
+            }
+        } else if (c == QLatin1Char(';')) {
+            writer.write(u";");
+            // The clauses of a for loop stay on one line
+            if (parens > 0) {
+                writer.space();
+            } else {
+                writer.newline();
+            }
+        } else if (c == QLatin1Char(',')) {
+            writer.write(u",");
+            writer.space();
+        } else if (c == QLatin1Char('(')) {
+            ++parens;
+            writer.write(u"(");
+        } else if (c == QLatin1Char(')')) {
+            parens = qMax(0, parens - 1);
+            writer.write(u")");
+        } else {
+            // An ordinary run: identifiers, numbers, operators
+            while (end < source.size() && isPlain(source[end])) {
+                ++end;
+            }
+            writer.write(source.mid(i, end - i));
+        }
+
+        previous = source[end - 1];
+        i = end;
+    }
+
+    return writer.result();
+}
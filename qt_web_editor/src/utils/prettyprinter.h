@@ -0,0 +1,49 @@
+/**
+ * @file prettyprinter.h
+ * @brief Declaration of the PrettyPrinter class.
+ *
+ * This file contains the PrettyPrinter class which lays out minified CSS and
+ * JavaScript one statement per line for reading.
+ */
+
+#ifndef PRETTYPRINTER_H
+#define PRETTYPRINTER_H
+
+#include "lexer.h"
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief The PrettyPrinter class reformats minified stylesheets and scripts.
+ *
+ * The output is meant to be read, not saved: line breaks are added after
+ * opening braces, closing braces and statements, blocks are indented, and the
+ * whitespace of the source is collapsed. Strings, template literals, comments
+ * and regular expression literals are copied unchanged. The source is walked
+ * once, so reformatting a file of several megabytes takes a fraction of a
+ * second.
+ */
+class PrettyPrinter
+{
+public:
+    /**
+     * @brief Checks whether a language can be reformatted.
+     *
+     * @param language The language.
+     * @return True for CSS and JavaScript, which includes JSON.
+     */
+    static bool supports(Lexer::Language language);
+
+    /**
+     * @brief Reformats source code.
+     *
+     * @param language The language of the source; see supports().
+     * @param source The source.
+     * @param indentSize Number of spaces per level of indentation.
+     * @return The reformatted source.
+     */
+    static QString format(Lexer::Language language, QStringView source, int indentSize = 4);
+};
+
+#endif // PRETTYPRINTER_H
@@ -0,0 +1,18 @@
+/**
+ * @file simd.h
+ * @brief Detection of the SIMD instruction sets the scanners may use.
+ *
+ * Defines RAPID_HAVE_SSE2 and includes the SSE2 intrinsics when the compiler
+ * targets x86-64 or otherwise enables SSE2. Code using it keeps a scalar path
+ * for other targets.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define RAPID_HAVE_SSE2
+#endif
+
+#endif // SIMD_H
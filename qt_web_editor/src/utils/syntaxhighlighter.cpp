@@ -7,8 +7,92 @@
  */
 
 #include "syntaxhighlighter.h"
+#include <QCoreApplication>
 #include <QDebug>
-#include <QRegularExpression>
+#include <QPointer>
+#include <QSignalBlocker>
+#include <QTextBlock>
+#include <QTextBlockUserData>
+#include <QTextDocument>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace {
+/** Block state of a block the background pass has not reached yet. */
+constexpr int kPendingState = -2;
+
+/** Entry state of a block never lexed; no lexer state is this low. */
+constexpr int kUnknownState = INT_MIN;
+
+/** Edits touching more blocks than this move the frontier back rather than marking them dirty. */
+constexpr int kMaxDirtyBlocks = 256;
+
+/** Characters of a block that are highlighted; the rest of a longer line stays plain. */
+constexpr int kMaxHighlightedLength = 10000;
+
+/** Characters sent to the worker in one job. */
+constexpr int kMaxJobCharacters = 256 * 1024;
+
+/** Blocks sent to the worker in one job. */
+constexpr int kMaxJobBlocks = 4096;
+
+/**
+ * @brief What a block was last lexed from, and what came out.
+ */
+struct BlockMemo : public QTextBlockUserData
+{
+    Lexer::Language language = Lexer::Language::Plain;  /**< Lexer used. */
+    int entryState = kUnknownState;                     /**< State of the previous block. */
+    size_t textHash = 0;                                /**< Hash of the highlighted text. */
+    int exitState = -1;                                 /**< State the block ended in. */
+    QVector<Lexer::Token> tokens;                       /**< Tokens of the block. */
+    bool applied = false;                               /**< Whether the tokens are the block's formats. */
+};
+
+/**
+ * @brief Returns the thread pool blocks are lexed on.
+ *
+ * It belongs to the application and is shared by all highlighters, each of
+ * which has at most one job on it at a time.
+ */
+QThreadPool *lexerPool()
+{
+    static QThreadPool *pool = []() {
+        auto *pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(2);
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * @brief Hashes the part of a block that is highlighted.
+ */
+size_t hashSegment(QStringView text)
+{
+    return qHash(text.left(kMaxHighlightedLength));
+}
+
+/**
+ * @brief Gets the memo of a block if it still holds for the block.
+ *
+ * @param data The user data of the block.
+ * @param language The lexer in use.
+ * @param entryState The state the previous block ends in.
+ * @param text The text of the block.
+ * @return The memo, or nullptr if the block has to be lexed.
+ */
+BlockMemo *matchingMemo(QTextBlockUserData *data, Lexer::Language language, int entryState,
+                        QStringView text)
+{
+    auto memo = static_cast<BlockMemo *>(data);
+    if (!memo || memo->language != language || memo->entryState != entryState
+        || memo->textHash != hashSegment(text)) {
+        return nullptr;
+    }
+    return memo;
+}
+}
 
 /**
  * @brief Constructs a SyntaxHighlighter with the given parent document.
@@ -18,8 +102,23 @@
  * @param parent The parent QTextDocument that will be highlighted.
  */
 SyntaxHighlighter::SyntaxHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+    : QSyntaxHighlighter(static_cast<QObject *>(parent))
+    , m_chunkTimer(new QTimer(this))
 {
+    // Jobs are sent once the event loop is idle, after the edits of an
+    // event have all been seen
+    m_chunkTimer->setInterval(0);
+    m_chunkTimer->setSingleShot(true);
+    connect(m_chunkTimer, &QTimer::timeout, this, &SyntaxHighlighter::highlightNextChunk);
+    
+    // Connect before QSyntaxHighlighter does, so the frontier and the dirty
+    // range are adjusted before the edited blocks are reformatted
+    if (parent) {
+        m_blockCount = parent->blockCount();
+        connect(parent, &QTextDocument::contentsChange, this, &SyntaxHighlighter::handleContentsChange);
+        setDocument(parent);
+    }
+    
     // Setup text formats
     m_keywordFormat.setForeground(Qt::darkBlue);
     m_keywordFormat.setFontWeight(QFont::Bold);
@@ -37,223 +136,537 @@ SyntaxHighlighter::SyntaxHighlighter(QTextDocument *parent)
     m_numberFormat.setForeground(Qt::darkMagenta);
     m_functionFormat.setForeground(Qt::blue);
     m_functionFormat.setFontItalic(true);
+
+    updateFormatTable();
 }
 
 /**
  * @brief Sets the programming language for syntax highlighting.
  * 
- * Configures the highlighter with the appropriate rules for the specified language
- * and triggers rehighlighting of the document.
+ * Selects the lexer for the specified language and triggers rehighlighting
+ * of the document.
  * 
  * @param language The language to set (e.g., "html", "css", "javascript").
  */
 void SyntaxHighlighter::setLanguage(const QString &language)
 {
     m_language = language.toLower();
-    m_rules.clear();
+    m_lexerLanguage = Lexer::languageFromName(m_language);
     
-    if (m_language == "html") {
-        setupHtmlRules();
-    } else if (m_language == "css") {
-        setupCssRules();
-    } else if (m_language == "javascript" || m_language == "js") {
-        setupJsRules();
+    if (m_lexerLanguage == Lexer::Language::Plain) {
+        // Clearing the formats is cheap; no need to do it in the background
+        m_chunkTimer->stop();
+        ++m_revision;
+        m_readyLimit = document() ? document()->blockCount() : 0;
+        m_dirtyFirst = INT_MAX;
+        m_dirtyLast = -1;
+        rehighlight();
+        return;
     }
     
-    rehighlight();
+    restartHighlighting();
 }
 
 /**
- * @brief Highlights the given text block according to the current syntax rules.
+ * @brief Tells the highlighter which blocks a view of the document shows.
  * 
- * This method is called by Qt's syntax highlighting system for each block of text
- * that needs to be highlighted. It applies all registered highlighting rules
- * and handles multi-line comments.
+ * These blocks are highlighted ahead of the background pass, and blocks
+ * lexed while off screen get their formats as they scroll into view. Views
+ * sharing the document each have their own range.
  * 
- * @param text The text block to be highlighted.
+ * @param view The view; its range is dropped when it is destroyed.
+ * @param firstBlock Number of the first visible block.
+ * @param lastBlock Number of the last visible block.
  */
-void SyntaxHighlighter::highlightBlock(const QString &text)
+void SyntaxHighlighter::setVisibleBlocks(QObject *view, int firstBlock, int lastBlock)
 {
-    // Apply syntax highlighting rules
-    for (const HighlightingRule &rule : qAsConst(m_rules)) {
-        QRegularExpressionMatchIterator it = rule.pattern.globalMatch(text);
-        while (it.hasNext()) {
-            QRegularExpressionMatch match = it.next();
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
-        }
+    if (!m_visibleRanges.contains(view)) {
+        connect(view, &QObject::destroyed, this, [this, view]() { m_visibleRanges.remove(view); });
     }
+    m_visibleRanges.insert(view, qMakePair(firstBlock, lastBlock));
     
-    // Handle multi-line comments
-    setCurrentBlockState(0);
-    
-    int startIndex = 0;
-    if (previousBlockState() != 1) {
-        startIndex = text.indexOf(m_commentStartExpression);
+    if (m_lexerLanguage != Lexer::Language::Plain && !m_chunkTimer->isActive()) {
+        m_chunkTimer->start();
     }
-    
-    while (startIndex >= 0) {
-        QRegularExpressionMatch match = m_commentEndExpression.match(text, startIndex);
-        int endIndex = match.capturedStart();
-        int commentLength;
-        
-        if (endIndex == -1) {
-            setCurrentBlockState(1);
-            commentLength = text.length() - startIndex;
-        } else {
-            commentLength = endIndex - startIndex + match.capturedLength();
+}
+
+/**
+ * @brief Forgets the blocks a view shows, once it no longer shows the document.
+ * 
+ * @param view The view.
+ */
+void SyntaxHighlighter::removeView(QObject *view)
+{
+    if (m_visibleRanges.remove(view)) {
+        disconnect(view, &QObject::destroyed, this, nullptr);
+    }
+}
+
+/**
+ * @brief Checks whether a block is shown by any view.
+ * 
+ * @param blockNumber Number of the block.
+ * @return true if the block is on screen.
+ */
+bool SyntaxHighlighter::isBlockVisible(int blockNumber) const
+{
+    for (const QPair<int, int> &range : m_visibleRanges) {
+        if (blockNumber >= range.first && blockNumber <= range.second) {
+            return true;
         }
-        
-        setFormat(startIndex, commentLength, m_commentFormat);
-        startIndex = text.indexOf(m_commentStartExpression, startIndex + commentLength);
     }
+    return false;
 }
 
 /**
- * @brief Adds a new highlighting rule with the given pattern and format.
+ * @brief Checks whether the whole document has been highlighted.
  * 
- * Creates a new highlighting rule that will be applied to all text matching
- * the specified regular expression pattern.
+ * @return true if no block is waiting for the background pass.
+ */
+bool SyntaxHighlighter::isHighlightingComplete() const
+{
+    return m_lexerLanguage == Lexer::Language::Plain
+        || !document()
+        || (m_readyLimit >= document()->blockCount() && m_dirtyFirst > m_dirtyLast);
+}
+
+/**
+ * @brief Checks whether a block is waiting for the background pass.
  * 
- * @param pattern The regular expression pattern to match.
- * @param format The text format to apply to matching text.
+ * @param block The block.
+ * @return true if the block has not been highlighted in its current context yet.
  */
-void SyntaxHighlighter::addRule(const QString &pattern, const QTextCharFormat &format)
+bool SyntaxHighlighter::isBlockPending(const QTextBlock &block) const
 {
-    HighlightingRule rule;
-    rule.pattern = QRegularExpression(pattern);
-    rule.format = format;
-    m_rules.append(rule);
+    if (isHighlightingComplete()) {
+        return false;
+    }
+    const int blockNumber = block.blockNumber();
+    return blockNumber >= m_readyLimit || (blockNumber >= m_dirtyFirst && blockNumber <= m_dirtyLast);
 }
 
 /**
- * @brief Adds multiple keywords that share the same text format.
+ * @brief Highlights the given text block with the lexer of the current language.
  * 
- * Creates highlighting rules for each keyword in the list, ensuring they are
- * matched as whole words only.
+ * This method is called by Qt's syntax highlighting system for each block of text
+ * that needs to be highlighted. It never lexes: a block whose memo was lexed
+ * from the state the previous block ends in, with the same text, gets the
+ * memo's tokens as formats and its end state. Any other block keeps what it
+ * has and waits for the worker.
+ * 
+ * @param text The text block to be highlighted.
+ */
+void SyntaxHighlighter::highlightBlock(const QString &text)
+{
+    if (m_lexerLanguage == Lexer::Language::Plain) {
+        setCurrentBlockState(0);
+        return;
+    }
+    
+    // Minified sources can hold megabytes on one line; formatting all of it
+    // would make every layout of the line slow, so only its start is lexed
+    BlockMemo *memo = matchingMemo(currentBlockUserData(), m_lexerLanguage, previousBlockState(), text);
+    if (!memo) {
+        const int blockNumber = currentBlock().blockNumber();
+        if (blockNumber < m_readyLimit) {
+            m_dirtyFirst = qMin(m_dirtyFirst, blockNumber);
+            m_dirtyLast = qMax(m_dirtyLast, blockNumber);
+        }
+        keepBlockPending();
+        if (!m_chunkTimer->isActive()) {
+            m_chunkTimer->start();
+        }
+        return;
+    }
+    
+    for (const Lexer::Token &token : qAsConst(memo->tokens)) {
+        setFormat(token.start, token.length, m_formats[token.type]);
+    }
+    memo->applied = true;
+    setCurrentBlockState(memo->exitState);
+}
+
+/**
+ * @brief Leaves the current block to the worker.
  * 
- * @param keywords List of keywords to highlight.
- * @param format The text format to apply to all keywords.
+ * QSyntaxHighlighter moves on to the next block only when the state of this
+ * one changes, so keeping the state ends the reformatting here. The block
+ * keeps the tokens it was last lexed into, which are likely still right and
+ * look better than none; a block never lexed stays plain.
  */
-void SyntaxHighlighter::addKeywords(const QStringList &keywords, const QTextCharFormat &format)
+void SyntaxHighlighter::keepBlockPending()
 {
-    for (const QString &keyword : keywords) {
-        addRule(QStringLiteral("\\b%1\\b").arg(keyword), format);
+    const int state = currentBlockState();
+    const auto memo = static_cast<BlockMemo *>(currentBlockUserData());
+    if (memo && memo->language == m_lexerLanguage && state != kPendingState) {
+        for (const Lexer::Token &token : qAsConst(memo->tokens)) {
+            setFormat(token.start, token.length, m_formats[token.type]);
+        }
     }
+    setCurrentBlockState(state < 0 ? kPendingState : state);
+}
+
+/**
+ * @brief Starts highlighting the document from the top in the background.
+ */
+void SyntaxHighlighter::restartHighlighting()
+{
+    ++m_revision;
+    m_readyLimit = 0;
+    m_convergedLimit = 0;
+    m_dirtyFirst = INT_MAX;
+    m_dirtyLast = -1;
+    m_blockCount = document() ? document()->blockCount() : 0;
+    m_chunkTimer->start();
 }
 
 /**
- * @brief Sets up highlighting rules for HTML documents.
+ * @brief Applies lexed blocks on screen, then sends the next blocks to the worker.
  * 
- * Configures syntax highlighting rules specific to HTML, including:
- * - Tags
- * - Attributes
- * - Attribute values
- * - Comments
- * - DOCTYPE declarations
+ * The blocks on screen come first: those lexed while off screen get their
+ * formats, and those still to lex are sent before anything else. Then come
+ * the dirty range and the frontier. Only one job is on the worker at a time;
+ * its result schedules the next one.
  */
-void SyntaxHighlighter::setupHtmlRules()
+void SyntaxHighlighter::highlightNextChunk()
 {
-    // HTML tags
-    addRule(QStringLiteral("<\\/?[a-zA-Z0-9_:-]+"), m_tagFormat);
+    QTextDocument *doc = document();
+    if (!doc || m_lexerLanguage == Lexer::Language::Plain) {
+        return;
+    }
+    
+    // Applying formats is not an edit; keep listeners of the document from
+    // taking it for one
+    const QSignalBlocker blocker(doc);
     
-    // HTML attributes
-    addRule(QStringLiteral("\\b[a-zA-Z0-9_:-]+(?=\\s*=\")"), m_attributeFormat);
-    addRule(QStringLiteral("\\b[a-zA-Z0-9_:-]+(?=\\s*=')"), m_attributeFormat);
-    addRule(QStringLiteral("\\b[a-zA-Z0-9_:-]+(?=\\s*=[^'\"])"), m_attributeFormat);
+    // Each view's range, noting the first block still to lex in any of them
+    int visibleToLex = -1;
+    int visibleLast = -1;
+    for (const QPair<int, int> &range : qAsConst(m_visibleRanges)) {
+        QTextBlock block = doc->findBlockByNumber(qMax(0, range.first));
+        for (; block.isValid() && block.blockNumber() <= range.second; block = block.next()) {
+            const BlockMemo *memo = matchingMemo(block.userData(), m_lexerLanguage,
+                                                 block.previous().userState(), block.text());
+            if (!memo) {
+                if (visibleToLex < 0 || block.blockNumber() < visibleToLex) {
+                    visibleToLex = block.blockNumber();
+                    visibleLast = range.second;
+                }
+                break;
+            }
+            if (!memo->applied || block.userState() != memo->exitState) {
+                rehighlightBlock(block);
+            }
+        }
+    }
+    if (visibleToLex >= 0 && visibleToLex < m_readyLimit) {
+        m_dirtyFirst = qMin(m_dirtyFirst, visibleToLex);
+        m_dirtyLast = qMax(m_dirtyLast, visibleToLex);
+    }
     
-    // Attribute values
-    addRule(QStringLiteral("\"[^\"]*\""), m_valueFormat);
-    addRule(QStringLiteral("'[^']*'"), m_valueFormat);
+    if (m_lexing) {
+        return;
+    }
+    
+    if (visibleToLex >= m_readyLimit) {
+        // Lexed from a state that may not hold once the frontier gets here;
+        // the blocks are no longer as they were
+        m_convergedLimit = qMin(m_convergedLimit, visibleToLex);
+        startLexing(LexJob::Visible, visibleToLex, visibleLast, INT_MAX, INT_MAX);
+    } else if (m_dirtyFirst <= m_dirtyLast) {
+        // Blocks behind the frontier and past the edit are as they were
+        startLexing(LexJob::Dirty, m_dirtyFirst, m_readyLimit - 1, m_dirtyLast + 1, m_readyLimit);
+    } else if (m_readyLimit < doc->blockCount()) {
+        startLexing(LexJob::Frontier, m_readyLimit, doc->blockCount() - 1, m_readyLimit, m_convergedLimit);
+    }
+}
+
+/**
+ * @brief Sends a run of blocks to the worker.
+ * 
+ * The text of the blocks is copied, up to a bounded size, with what they
+ * were last lexed from so the worker can tell where the highlighting stops
+ * changing.
+ * 
+ * @param kind Why the blocks are lexed.
+ * @param firstBlock Number of the first block.
+ * @param lastBlock Number of the last block that may be sent.
+ * @param convergeFrom First block the job may stop at.
+ * @param convergeTo Block the job may stop before.
+ */
+void SyntaxHighlighter::startLexing(LexJob::Kind kind, int firstBlock, int lastBlock,
+                                    int convergeFrom, int convergeTo)
+{
+    QTextBlock block = document()->findBlockByNumber(firstBlock);
+    if (!block.isValid() || lastBlock < firstBlock) {
+        return;
+    }
     
-    // Comments
-    m_commentStartExpression = QRegularExpression("<!--");
-    m_commentEndExpression = QRegularExpression("-->");
+    LexJob job;
+    job.kind = kind;
+    job.revision = m_revision;
+    job.language = m_lexerLanguage;
+    job.firstBlock = firstBlock;
+    job.entryState = block.previous().userState();
+    job.convergeFrom = convergeFrom;
+    job.convergeTo = convergeTo;
     
-    // Special characters
-    addRule("&[a-zA-Z0-9]+;", m_valueFormat);
+    int characters = 0;
+    for (; block.isValid() && block.blockNumber() <= lastBlock; block = block.next()) {
+        if (job.texts.size() >= kMaxJobBlocks || characters >= kMaxJobCharacters) {
+            break;
+        }
+        const QString text = block.text().left(kMaxHighlightedLength);
+        const auto memo = static_cast<const BlockMemo *>(block.userData());
+        const bool known = memo && memo->language == m_lexerLanguage;
+        job.knownEntryStates.append(known ? memo->entryState : kUnknownState);
+        job.knownHashes.append(known ? memo->textHash : 0);
+        job.texts.append(text);
+        characters += text.size();
+    }
     
-    // DOCTYPE
-    addRule("<!DOCTYPE[^>]*>", m_keywordFormat);
+    m_lexing = true;
+    m_jobFirst = firstBlock;
+    m_jobEnd = firstBlock + int(job.texts.size());
+    m_jobEdited = false;
+    const QPointer<SyntaxHighlighter> target(this);
+    lexerPool()->start([target, job]() {
+        bool converged = false;
+        const QVector<LexedBlock> blocks = lexBlocks(job, &converged);
+        // The highlighter may be gone by then; the application outlives it
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [target, job, blocks, converged]() {
+            if (target) {
+                target->applyLexedBlocks(job, blocks, converged);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 /**
- * @brief Sets up highlighting rules for CSS stylesheets.
+ * @brief Lexes the blocks of a job; runs on the worker thread.
  * 
- * Configures syntax highlighting rules specific to CSS, including:
- * - Properties
- * - Values
- * - Selectors
- * - At-rules
- * - Comments
+ * A block that was last lexed from the state it now starts from, with the
+ * same text, ends the job if it lies where the job may stop: the blocks from
+ * there on are known to be as they were.
+ * 
+ * @param job The job.
+ * @param converged Set if the job stopped at a block already lexed the same way.
+ * @return The lexed blocks, from the first block of the job.
  */
-void SyntaxHighlighter::setupCssRules()
+QVector<SyntaxHighlighter::LexedBlock> SyntaxHighlighter::lexBlocks(const LexJob &job, bool *converged)
 {
-    // CSS properties
-    addRule(QStringLiteral("\\b[a-zA-Z-]+\\s*:"), m_attributeFormat);
+    QVector<LexedBlock> blocks;
+    blocks.reserve(job.texts.size());
     
-    // CSS selectors
-    addRule(QStringLiteral("\\b([a-zA-Z0-9_][a-zA-Z0-9_>-]*)\\s*{"), m_tagFormat);
+    int state = job.entryState;
+    for (int i = 0; i < job.texts.size(); ++i) {
+        const int blockNumber = job.firstBlock + i;
+        const size_t textHash = hashSegment(job.texts[i]);
+        if (blockNumber >= job.convergeFrom && blockNumber < job.convergeTo
+            && job.knownEntryStates[i] == state && job.knownHashes[i] == textHash) {
+            *converged = true;
+            break;
+        }
+        
+        LexedBlock block;
+        block.entryState = state;
+        block.textHash = textHash;
+        block.exitState = Lexer::tokenize(job.language, job.texts[i], state, &block.tokens);
+        state = block.exitState;
+        blocks.append(std::move(block));
+    }
+    return blocks;
+}
+
+/**
+ * @brief Stores the blocks lexed by the worker and formats those on screen.
+ * 
+ * A result from before highlighting restarted, or for another language, is
+ * dropped. Otherwise the blocks are where edits made while the job was on the
+ * worker moved them, and those from an edited one on are dropped and sent
+ * again. Blocks off screen only get their memo and end state; their formats
+ * are applied when they are shown.
+ * 
+ * @param job The job.
+ * @param blocks The lexed blocks.
+ * @param converged Whether the job stopped at a block already lexed the same way.
+ */
+void SyntaxHighlighter::applyLexedBlocks(const LexJob &job, const QVector<LexedBlock> &blocks, bool converged)
+{
+    m_lexing = false;
+    QTextDocument *doc = document();
+    if (!doc || job.revision != m_revision || job.language != m_lexerLanguage) {
+        m_chunkTimer->start();
+        return;
+    }
     
-    // CSS values
-    addRule(QStringLiteral("#[0-9a-fA-F]+"), m_valueFormat); // Hex colors
-    addRule(QStringLiteral("\\b[0-9]+(\\.[0-9]+)?(px|em|%|in|cm|mm|pt|pc|ex|ch|rem|vh|vw|vmin|vmax)?\\b"), m_numberFormat);
-    addRule(QStringLiteral("\\b(url|rgb|rgba|hsl|hsla|linear-gradient|radial-gradient)\\s*\\("), m_functionFormat);
+    const QSignalBlocker blocker(doc);
     
-    // CSS at-rules
-    addRule(QStringLiteral("@\\w+"), m_keywordFormat);
+    // The job only stopped early if the block it stopped at is untouched
+    const int first = m_jobFirst;
+    const int count = qMin(int(blocks.size()), m_jobEnd - m_jobFirst);
+    converged = converged && blocks.size() < m_jobEnd - m_jobFirst;
     
-    // CSS pseudo-classes and pseudo-elements
-    addRule(QStringLiteral("(:|::)\\w[\\w-]*(?=\\s*[^{]*(?:{|$))"), m_functionFormat);
+    QTextBlock block = doc->findBlockByNumber(first);
+    for (int i = 0; i < count && block.isValid(); ++i) {
+        const LexedBlock &lexed = blocks[i];
+        auto memo = static_cast<BlockMemo *>(block.userData());
+        if (!memo) {
+            memo = new BlockMemo;
+            block.setUserData(memo);
+        }
+        memo->language = job.language;
+        memo->entryState = lexed.entryState;
+        memo->textHash = lexed.textHash;
+        memo->exitState = lexed.exitState;
+        memo->tokens = lexed.tokens;
+        memo->applied = false;
+        
+        // With the state already set, formatting the block does not spill
+        // over into the next one
+        block.setUserState(lexed.exitState);
+        if (isBlockVisible(block.blockNumber())) {
+            rehighlightBlock(block);
+        }
+        block = block.next();
+    }
     
-    // Comments
-    m_commentStartExpression = QRegularExpression(QStringLiteral("/\\*"));
-    m_commentEndExpression = QRegularExpression(QStringLiteral("\\*/"));
+    const int end = first + count;
+    switch (job.kind) {
+    case LexJob::Visible:
+        break;
+    case LexJob::Dirty:
+        if (m_jobEdited) {
+            // The dirty range has changed since; the next job starts from it
+        } else if (converged || end >= m_readyLimit) {
+            m_dirtyFirst = INT_MAX;
+            m_dirtyLast = -1;
+        } else {
+            // The change of state runs on past the edit
+            m_dirtyFirst = end;
+            m_dirtyLast = qMax(m_dirtyLast, end);
+        }
+        break;
+    case LexJob::Frontier:
+        if (m_readyLimit != first) {
+            // An edit behind the frontier moved it back past the job
+            break;
+        }
+        m_readyLimit = converged ? qMax(end, m_convergedLimit) : end;
+        if (m_readyLimit >= doc->blockCount()) {
+            m_readyLimit = doc->blockCount();
+            emit highlightingFinished();
+        }
+        break;
+    }
     
-    // Strings
-    addRule(QStringLiteral("\"[^\"]*\""), m_stringFormat);
-    addRule(QStringLiteral("'[^']*'"), m_stringFormat);
+    emit pendingBlocksChanged();
+    m_chunkTimer->start();
 }
 
 /**
- * @brief Sets up highlighting rules for JavaScript code.
+ * @brief Keeps the frontier and the dirty range in step with edits.
  * 
- * Configures syntax highlighting rules specific to JavaScript, including:
- * - Keywords (if, else, function, etc.)
- * - Built-in objects and functions
- * - Numbers
- * - Strings
- * - Comments (both single and multi-line)
+ * Blocks behind the frontier keep their highlighting when lines are inserted or
+ * removed before them, so the frontier and the dirty range shift with them.
+ * The edited blocks join the dirty range, unless the edit spans many blocks;
+ * the frontier then moves back to where it starts instead. The blocks of the
+ * job on the worker, if there is one, are followed the same way.
+ * 
+ * @param position Position of the change.
+ * @param charsRemoved Number of characters removed.
+ * @param charsAdded Number of characters added.
  */
-void SyntaxHighlighter::setupJsRules()
+void SyntaxHighlighter::handleContentsChange(int position, int charsRemoved, int charsAdded)
 {
-    // JavaScript keywords
-    QStringList keywords = {
-        "break", "case", "catch", "class", "const", "continue",
-        "debugger", "default", "delete", "do", "else", "export",
-        "extends", "finally", "for", "function", "if", "import",
-        "in", "instanceof", "new", "return", "super", "switch",
-        "this", "throw", "try", "typeof", "var", "void",
-        "while", "with", "yield"
-    };
-    addKeywords(keywords, m_keywordFormat);
+    QTextDocument *doc = document();
+    if (!doc || (charsRemoved == 0 && charsAdded == 0)) {
+        return;
+    }
+    
+    const int blockCount = doc->blockCount();
+    const int delta = blockCount - m_blockCount;
+    m_blockCount = blockCount;
+    
+    if (m_lexerLanguage == Lexer::Language::Plain) {
+        m_readyLimit = blockCount;
+        return;
+    }
+    
+    const int firstBlock = doc->findBlock(position).blockNumber();
+    const int lastBlock = doc->findBlock(position + charsAdded).blockNumber();
+    if (firstBlock < 0) {
+        m_jobEnd = m_jobFirst;
+        m_jobEdited = true;
+        return;
+    }
     
-    // JavaScript literals
-    QStringList literals = {"true", "false", "null", "undefined", "NaN", "Infinity"};
-    addKeywords(literals, m_valueFormat);
+    // Keep track of where the blocks of the job on the worker are now
+    if (m_lexing) {
+        m_jobEdited = true;
+        const int oldLastBlock = lastBlock - delta;
+        if (oldLastBlock < m_jobFirst) {
+            m_jobFirst += delta;
+            m_jobEnd += delta;
+        } else if (firstBlock < m_jobEnd) {
+            m_jobEnd = qMax(m_jobFirst, firstBlock);
+        }
+    }
     
-    // Functions
-    addRule(QStringLiteral("\\b[a-zA-Z_][a-zA-Z0-9_]*\\s*\\("), m_functionFormat);
+    // Blocks the frontier may skip must be as they were; an edited one is not
+    if (firstBlock >= m_readyLimit) {
+        m_convergedLimit = qMin(m_convergedLimit, firstBlock);
+    } else if (lastBlock - firstBlock > kMaxDirtyBlocks) {
+        m_convergedLimit = qMin(m_convergedLimit, firstBlock);
+    } else {
+        m_convergedLimit = qMin(m_convergedLimit + delta, blockCount);
+    }
     
-    // Numbers
-    addRule(QStringLiteral("\\b[0-9]+(\\.[0-9]+)?([eE][+-]?[0-9]+)?\\b"), m_numberFormat);
+    // Dirty blocks after the edit move with it
+    if (m_dirtyFirst <= m_dirtyLast) {
+        if (m_dirtyFirst > firstBlock) {
+            m_dirtyFirst = qMax(firstBlock, m_dirtyFirst + delta);
+        }
+        if (m_dirtyLast > firstBlock) {
+            m_dirtyLast = qMax(firstBlock, m_dirtyLast + delta);
+        }
+    }
+    
+    if (firstBlock < m_readyLimit) {
+        if (lastBlock - firstBlock > kMaxDirtyBlocks) {
+            m_readyLimit = firstBlock;
+        } else {
+            m_readyLimit = qMax(lastBlock + 1, m_readyLimit + delta);
+            m_dirtyFirst = qMin(m_dirtyFirst, firstBlock);
+            m_dirtyLast = qMax(m_dirtyLast, lastBlock);
+        }
+        m_readyLimit = qMin(m_readyLimit, blockCount);
+    }
     
-    // Strings
-    addRule(QStringLiteral("\"[^\"]*\""), m_stringFormat);
-    addRule(QStringLiteral("'[^']*'"), m_stringFormat);
-    addRule(QStringLiteral("`[^`]*`"), m_stringFormat);
+    // Ahead of the frontier there is nothing to mark; it will get there
+    if (m_dirtyFirst >= m_readyLimit) {
+        m_dirtyFirst = INT_MAX;
+        m_dirtyLast = -1;
+    } else {
+        m_dirtyLast = qMin(m_dirtyLast, m_readyLimit - 1);
+    }
     
-    // Comments
-    addRule(QStringLiteral("//.*"), m_commentFormat);
-    m_commentStartExpression = QRegularExpression(QStringLiteral("/\\*"));
-    m_commentEndExpression = QRegularExpression(QStringLiteral("\\*/"));
+    if (!m_chunkTimer->isActive()) {
+        m_chunkTimer->start();
+    }
+}
+
+/**
+ * @brief Fills the token format table from the individual formats.
+ */
+void SyntaxHighlighter::updateFormatTable()
+{
+    m_formats[Lexer::Keyword] = m_keywordFormat;
+    m_formats[Lexer::Tag] = m_tagFormat;
+    m_formats[Lexer::Attribute] = m_attributeFormat;
+    m_formats[Lexer::Value] = m_valueFormat;
+    m_formats[Lexer::Comment] = m_commentFormat;
+    m_formats[Lexer::String] = m_stringFormat;
+    m_formats[Lexer::Number] = m_numberFormat;
+    m_formats[Lexer::Function] = m_functionFormat;
 }
@@ -9,17 +9,51 @@
 #ifndef SYNTAXHIGHLIGHTER_H
 #define SYNTAXHIGHLIGHTER_H
 
+#include <QHash>
+#include <QPair>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
-#include <QRegularExpression>
 #include <QVector>
 
+#include <climits>
+
+#include "lexer.h"
+
+class QTextBlock;
+class QTimer;
+
 /**
  * @brief The SyntaxHighlighter class provides syntax highlighting for source code.
  * 
  * This class implements syntax highlighting for multiple programming languages
- * including HTML, CSS, and JavaScript. It uses a rule-based system to apply
- * different text formats to various syntax elements like keywords, strings, and comments.
+ * including HTML, CSS, and JavaScript. Each block is split into tokens by a
+ * single-pass Lexer, and the format of each token type is applied to its span.
+ * The lexer state at the end of a block, such as an open comment or an embedded
+ * script, is kept as the block state so the next block continues from it.
+ *
+ * Lexing never runs on the GUI thread. Blocks are sent to a worker thread in
+ * jobs: a copy of their text and the state the first one starts from. The
+ * worker returns compact token arrays, one per block, which are kept in the
+ * blocks as memos along with the state and text hash they were lexed from.
+ * The GUI thread only turns the tokens of blocks on screen into formats.
+ * While a job is on the worker, edits before its blocks shift them and edits
+ * after them leave them be; only blocks from an edit inside the run on are
+ * dropped from the result and sent again. Until its tokens come back, an
+ * edited block keeps the formats it had, so typing costs the same whatever
+ * the language or the length of the line.
+ *
+ * Large documents are highlighted progressively, up to a frontier the
+ * background jobs move forward; blocks past it are pending. Blocks on screen
+ * are lexed first, provisionally if the frontier has not reached them yet, and
+ * are corrected once it does. Small edits behind the frontier mark a dirty
+ * range, lexed ahead of the frontier; large ones move the frontier back to the
+ * edit. A job stops as soon as a block it reaches was already lexed from the
+ * same state with the same text, since the blocks after it are unchanged, so
+ * opening or closing a comment at the top of a long file costs only the lines
+ * whose highlighting actually changes.
+ *
+ * Only the first ten thousand characters of a line are highlighted, so a
+ * minified file with one very long line costs no more than a normal one.
  */
 class SyntaxHighlighter : public QSyntaxHighlighter
 {
@@ -36,15 +70,61 @@ public:
     /**
      * @brief Sets the programming language for syntax highlighting.
      * 
-     * Configures the highlighter with the appropriate rules for the specified language.
+     * Selects the lexer for the specified language.
      * 
      * @param language The language to set (e.g., "html", "css", "javascript").
      */
     void setLanguage(const QString &language);
     
+    /**
+     * @brief Tells the highlighter which blocks a view of the document shows.
+     * 
+     * The blocks shown by any view are highlighted ahead of the background pass.
+     * 
+     * @param view The view; its range is dropped when it is destroyed.
+     * @param firstBlock Number of the first visible block.
+     * @param lastBlock Number of the last visible block.
+     */
+    void setVisibleBlocks(QObject *view, int firstBlock, int lastBlock);
+    
+    /**
+     * @brief Forgets the blocks a view shows, once it no longer shows the document.
+     * 
+     * @param view The view.
+     */
+    void removeView(QObject *view);
+    
+    /**
+     * @brief Checks whether the whole document has been highlighted.
+     * 
+     * @return true if no block is waiting for the background pass.
+     */
+    bool isHighlightingComplete() const;
+    
+    /**
+     * @brief Checks whether a block is waiting for the background pass.
+     * 
+     * A pending block is unformatted or shows highlighting that may be out of date.
+     * 
+     * @param block The block.
+     * @return true if the block has not been highlighted in its current context yet.
+     */
+    bool isBlockPending(const QTextBlock &block) const;
+    
+signals:
+    /**
+     * @brief Emitted when the background pass reaches the end of the document.
+     */
+    void highlightingFinished();
+    
+    /**
+     * @brief Emitted when blocks stop or start waiting for the background pass.
+     */
+    void pendingBlocksChanged();
+    
 protected:
     /**
-     * @brief Highlights the given text block according to the current syntax rules.
+     * @brief Highlights the given text block with the lexer of the current language.
      * 
      * This method is called by Qt's syntax highlighting system for each block of text
      * that needs to be highlighted.
@@ -54,47 +134,107 @@ protected:
     void highlightBlock(const QString &text) override;
     
     /**
-     * @brief Structure defining a single highlighting rule.
+     * @brief Fills the token format table from the individual formats.
+     */
+    void updateFormatTable();
+    
+    /**
+     * @brief Checks whether a block is shown by any view.
      * 
-     * Combines a regular expression pattern with a text format to be applied
-     * when the pattern is matched in the text.
+     * @param blockNumber Number of the block.
+     * @return true if the block is on screen.
      */
-    struct HighlightingRule
-    {
-        QRegularExpression pattern;  /**< Regular expression to match in the text */
-        QTextCharFormat format;      /**< Format to apply to matching text */
-    };
+    bool isBlockVisible(int blockNumber) const;
     
     /**
-     * @brief Adds a new highlighting rule with the given pattern and format.
+     * @brief Leaves the current block to the worker.
      * 
-     * @param pattern The regular expression pattern to match.
-     * @param format The text format to apply to matching text.
+     * The block keeps its state, which ends the reformatting, and its
+     * previous tokens, if any.
      */
-    void addRule(const QString &pattern, const QTextCharFormat &format);
+    void keepBlockPending();
     
     /**
-     * @brief Adds multiple keywords that share the same text format.
+     * @brief Starts highlighting the document from the top in the background.
+     */
+    void restartHighlighting();
+    
+    /**
+     * @brief Applies lexed blocks on screen, then sends the next blocks to the worker.
+     */
+    void highlightNextChunk();
+    
+    /**
+     * @brief Keeps the frontier and the dirty range in step with edits.
      * 
-     * @param keywords List of keywords to highlight.
-     * @param format The text format to apply to all keywords.
+     * @param position Position of the change.
+     * @param charsRemoved Number of characters removed.
+     * @param charsAdded Number of characters added.
      */
-    void addKeywords(const QStringList &keywords, const QTextCharFormat &format);
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
     
     /**
-     * @brief Sets up highlighting rules for HTML documents.
+     * @brief A run of blocks sent to the worker.
      */
-    void setupHtmlRules();
+    struct LexJob
+    {
+        enum Kind {
+            Visible,   /**< Blocks on screen ahead of the frontier. */
+            Dirty,     /**< Edited blocks behind the frontier. */
+            Frontier   /**< Blocks at the frontier. */
+        };
+        
+        Kind kind = Frontier;                                 /**< Why the blocks are lexed. */
+        quint64 revision = 0;                                 /**< Highlighting pass the job belongs to. */
+        Lexer::Language language = Lexer::Language::Plain;    /**< Lexer to use. */
+        int firstBlock = 0;                                   /**< Number of the first block. */
+        int entryState = -1;                                  /**< State the first block starts from. */
+        int convergeFrom = INT_MAX;                           /**< First block the job may stop at. */
+        int convergeTo = INT_MAX;                             /**< Block the job may stop before. */
+        QVector<QString> texts;                               /**< Highlighted text of each block. */
+        QVector<int> knownEntryStates;                        /**< State each block was last lexed from. */
+        QVector<size_t> knownHashes;                          /**< Text hash each block was last lexed with. */
+    };
+    
+    /**
+     * @brief A block as lexed by the worker.
+     */
+    struct LexedBlock
+    {
+        int entryState;                 /**< State the block was lexed from. */
+        size_t textHash;                /**< Hash of the highlighted text. */
+        int exitState;                  /**< State the block ended in. */
+        QVector<Lexer::Token> tokens;   /**< Tokens of the block. */
+    };
     
     /**
-     * @brief Sets up highlighting rules for CSS stylesheets.
+     * @brief Sends a run of blocks to the worker.
+     * 
+     * @param kind Why the blocks are lexed.
+     * @param firstBlock Number of the first block.
+     * @param lastBlock Number of the last block that may be sent.
+     * @param convergeFrom First block the job may stop at.
+     * @param convergeTo Block the job may stop before.
+     */
+    void startLexing(LexJob::Kind kind, int firstBlock, int lastBlock, int convergeFrom, int convergeTo);
+    
+    /**
+     * @brief Lexes the blocks of a job; runs on the worker thread.
+     * 
+     * @param job The job.
+     * @param converged Set if the job stopped at a block already lexed the same way.
+     * @return The lexed blocks, from the first block of the job.
      */
-    void setupCssRules();
+    static QVector<LexedBlock> lexBlocks(const LexJob &job, bool *converged);
     
     /**
-     * @brief Sets up highlighting rules for JavaScript code.
+     * @brief Stores the blocks lexed by the worker and formats those on screen.
+     * 
+     * @param job The job.
+     * @param blocks The lexed blocks.
+     * @param converged Whether the job stopped at a block already lexed the same way.
      */
-    void setupJsRules();
+    void applyLexedBlocks(const LexJob &job, const QVector<LexedBlock> &blocks, bool converged);
     
     // Text formats for different syntax elements
     QTextCharFormat m_keywordFormat;     /**< Format for language keywords */
@@ -106,10 +246,21 @@ protected:
     QTextCharFormat m_numberFormat;      /**< Format for numeric literals */
     QTextCharFormat m_functionFormat;    /**< Format for function names */
     
-    QVector<HighlightingRule> m_rules;   /**< List of all active highlighting rules */
+    QTextCharFormat m_formats[Lexer::TokenTypeCount];  /**< Format for each token type */
     
-    QRegularExpression m_commentStartExpression;  /**< Pattern for the start of multi-line comments */
-    QRegularExpression m_commentEndExpression;    /**< Pattern for the end of multi-line comments */
+    Lexer::Language m_lexerLanguage = Lexer::Language::Plain;  /**< Lexer used for highlighting */
+    QTimer *m_chunkTimer;                /**< Schedules the next job */
+    quint64 m_revision = 0;              /**< Bumped when highlighting restarts; older results are discarded */
+    bool m_lexing = false;               /**< Whether a job is on the worker */
+    int m_jobFirst = 0;                  /**< First block of the job on the worker, as renumbered by edits */
+    int m_jobEnd = 0;                    /**< Block after the last one of the job an edit has not touched */
+    bool m_jobEdited = false;            /**< Whether the document was edited while the job was on the worker */
+    int m_readyLimit = 0;                /**< Blocks before this number are highlighted */
+    int m_convergedLimit = 0;            /**< Blocks from the frontier to here are unchanged once one matches its memo */
+    int m_dirtyFirst = INT_MAX;          /**< First edited block behind the frontier */
+    int m_dirtyLast = -1;                /**< Last edited block behind the frontier */
+    int m_blockCount = 0;                /**< Block count before the last edit */
+    QHash<QObject*, QPair<int, int>> m_visibleRanges;  /**< First and last block on screen, per view */
     
     QString m_language;  /**< Currently selected language for syntax highlighting */
 };
@@ -0,0 +1,182 @@
+/**
+ * @file textdecoder.cpp
+ * @brief Implementation of the TextDecoder class.
+ *
+ * This file contains the encoding detection and the UTF-8 validator.
+ */
+
+#include "textdecoder.h"
+#include "simd.h"
+
+#include <QStringDecoder>
+#include <QtAlgorithms>
+
+namespace {
+/**
+ * @brief Returns the length of the ASCII run starting at @p i.
+ *
+ * @param data The bytes.
+ * @param i Where the run starts.
+ * @param size Number of bytes.
+ * @return Index of the first non-ASCII byte, or @p size.
+ */
+qsizetype skipAscii(const uchar *data, qsizetype i, qsizetype size)
+{
+#ifdef RAPID_HAVE_SSE2
+    while (i + 16 <= size) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const uint mask = uint(_mm_movemask_epi8(chunk));
+        if (mask) {
+            return i + qCountTrailingZeroBits(mask);
+        }
+        i += 16;
+    }
+#endif
+    while (i < size && data[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+/** Decodes with a decoder, normalizing line endings. */
+QString decodeWith(QStringDecoder &decoder, QByteArrayView data)
+{
+    QString text = decoder.decode(data);
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    return text;
+}
+}
+
+/**
+ * @brief Detects the encoding of @p data and decodes it.
+ *
+ * @param data The contents of a file.
+ * @return The text and the encoding that was used.
+ */
+TextDecoder::Result TextDecoder::decode(QByteArrayView data)
+{
+    Result result;
+
+    // A byte order mark is authoritative; the decoder drops it
+    result.hasBom = QStringConverter::encodingForData(data).has_value();
+    const QByteArray encoding = encodingFor(data, !result.hasBom && isValidUtf8(data));
+    QStringDecoder decoder(encoding.constData());
+    result.encoding = QString::fromLatin1(encoding);
+    result.text = decodeWith(decoder, data);
+    return result;
+}
+
+/**
+ * @brief Chooses the encoding of a file as decode() would.
+ *
+ * @param head The first bytes of the file.
+ * @param validUtf8 True if the whole file is valid UTF-8.
+ * @return The name of the encoding, as QStringDecoder accepts it.
+ */
+QByteArray TextDecoder::encodingFor(QByteArrayView head, bool validUtf8)
+{
+    if (const auto bomEncoding = QStringConverter::encodingForData(head)) {
+        return QByteArray(QStringConverter::nameForEncoding(*bomEncoding));
+    }
+
+    if (validUtf8) {
+        return QByteArrayLiteral("UTF-8");
+    }
+
+    // Not UTF-8: trust a charset declared by an HTML document
+    if (const auto htmlEncoding = QStringConverter::encodingForHtml(head)) {
+        if (*htmlEncoding != QStringConverter::Utf8) {
+            return QByteArray(QStringConverter::nameForEncoding(*htmlEncoding));
+        }
+    }
+
+    // Most stray non-UTF-8 web files are Windows-1252, which Latin-1 approximates
+    if (QStringDecoder("windows-1252").isValid()) {
+        return QByteArrayLiteral("windows-1252");
+    }
+    return QByteArrayLiteral("ISO-8859-1");
+}
+
+/**
+ * @brief Checks whether @p data is well-formed UTF-8.
+ *
+ * Overlong forms, surrogates and code points above U+10FFFF are rejected.
+ *
+ * @param data The bytes to check.
+ * @return True if the bytes are valid UTF-8.
+ */
+bool TextDecoder::isValidUtf8(QByteArrayView data)
+{
+    const auto *bytes = reinterpret_cast<const uchar *>(data.data());
+    const qsizetype size = data.size();
+    qsizetype i = 0;
+
+    while (i < size) {
+        i = skipAscii(bytes, i, size);
+        if (i >= size) {
+            break;
+        }
+
+        const uchar lead = bytes[i];
+        int length;
+        uchar min = 0x80;
+        uchar max = 0xbf;
+        if (lead >= 0xc2 && lead <= 0xdf) {
+            length = 2;
+        } else if (lead >= 0xe0 && lead <= 0xef) {
+            length = 3;
+            if (lead == 0xe0) {
+                min = 0xa0;  // Overlong
+            } else if (lead == 0xed) {
+                max = 0x9f;  // Surrogates
+            }
+        } else if (lead >= 0xf0 && lead <= 0xf4) {
+            length = 4;
+            if (lead == 0xf0) {
+                min = 0x90;  // Overlong
+            } else if (lead == 0xf4) {
+                max = 0x8f;  // Above U+10FFFF
+            }
+        } else {
+            return false;
+        }
+
+        if (i + length > size) {
+            return false;
+        }
+        // The first continuation byte carries the extra range checks
+        if (bytes[i + 1] < min || bytes[i + 1] > max) {
+            return false;
+        }
+        for (int k = 2; k < length; ++k) {
+            if ((bytes[i + k] & 0xc0) != 0x80) {
+                return false;
+            }
+        }
+        i += length;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the length of @p data without a UTF-8 sequence cut off at its end.
+ *
+ * @param data The bytes.
+ * @return The length up to the start of an incomplete trailing sequence, if any.
+ */
+qsizetype TextDecoder::completeUtf8Length(QByteArrayView data)
+{
+    const auto *bytes = reinterpret_cast<const uchar *>(data.data());
+    const qsizetype size = data.size();
+
+    // Find the lead byte of the last sequence, at most three bytes back
+    for (qsizetype i = size - 1; i >= 0 && i >= size - 3; --i) {
+        const uchar byte = bytes[i];
+        if ((byte & 0xc0) == 0x80) {
+            continue;
+        }
+        const int length = byte >= 0xf0 ? 4 : byte >= 0xe0 ? 3 : byte >= 0xc0 ? 2 : 1;
+        return i + length > size ? i : size;
+    }
+    return size;
+}
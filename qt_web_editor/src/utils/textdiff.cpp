@@ -0,0 +1,295 @@
+/**
+ * @file textdiff.cpp
+ * @brief Implementation of the TextDiff class.
+ *
+ * This file contains the line diff and the three-way merge built on it.
+ */
+
+#include "textdiff.h"
+
+#include <QHash>
+
+#include <algorithm>
+
+namespace {
+/** Number of changed lines beyond which the differing middle of two texts is replaced as a whole. */
+constexpr int kMaxEditDistance = 1024;
+
+/**
+ * @brief Runs Myers' algorithm on two lists of line ids.
+ *
+ * @param a Ids of the old lines.
+ * @param b Ids of the new lines.
+ * @param hunks Receives the changed runs, in order.
+ * @return False if the lists differ in more than kMaxEditDistance lines.
+ */
+bool myers(const QVector<int> &a, const QVector<int> &b, QVector<TextDiff::Hunk> *hunks)
+{
+    const int n = a.size();
+    const int m = b.size();
+    const int max = qMin(n + m, kMaxEditDistance);
+    const int offset = max + 1;
+
+    // Furthest x reached on each diagonal k = x - y; the frontier before each
+    // step d is kept for the way back
+    QVector<int> v(2 * max + 3, 0);
+    QVector<QVector<int>> trace;
+    bool reached = false;
+    for (int d = 0; d <= max && !reached; ++d) {
+        trace.append(v.mid(offset - d, 2 * d + 1));
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                reached = true;
+                break;
+            }
+        }
+    }
+    if (!reached) {
+        return false;
+    }
+
+    // Walk back from the end, collecting single-line insertions and deletions
+    struct Step { int x; int y; bool insertion; };
+    QVector<Step> steps;
+    int x = n;
+    int y = m;
+    for (int d = trace.size() - 1; d > 0; --d) {
+        const QVector<int> &frontier = trace.at(d);
+        const auto at = [&frontier, d](int k) { return frontier.at(k + d); };
+        const int k = x - y;
+        const int previousK = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+        const int previousX = at(previousK);
+        const int previousY = previousX - previousK;
+        while (x > previousX && y > previousY) {
+            --x;
+            --y;
+        }
+        steps.append({previousX, previousY, x == previousX});
+        x = previousX;
+        y = previousY;
+    }
+    std::reverse(steps.begin(), steps.end());
+
+    for (const Step &step : qAsConst(steps)) {
+        TextDiff::Hunk *last = hunks->isEmpty() ? nullptr : &hunks->last();
+        if (!last || last->oldStart + last->oldCount != step.x || last->newStart + last->newCount != step.y) {
+            hunks->append({step.x, 0, step.y, 0});
+            last = &hunks->last();
+        }
+        if (step.insertion) {
+            ++last->newCount;
+        } else {
+            ++last->oldCount;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Joins a run of lines.
+ */
+QString joinLines(const QVector<QStringView> &lines, int from, int to)
+{
+    qsizetype size = 0;
+    for (int i = from; i < to; ++i) {
+        size += lines.at(i).size();
+    }
+    QString text;
+    text.reserve(size);
+    for (int i = from; i < to; ++i) {
+        text.append(lines.at(i));
+    }
+    return text;
+}
+}
+
+/**
+ * @brief Splits a text into lines, each with its '\n'.
+ *
+ * @param text The text.
+ * @return Views of the lines, in order.
+ */
+QVector<QStringView> TextDiff::splitLines(QStringView text)
+{
+    QVector<QStringView> lines;
+    qsizetype start = 0;
+    while (start < text.size()) {
+        const qsizetype newline = text.indexOf(QLatin1Char('\n'), start);
+        const qsizetype end = newline < 0 ? text.size() : newline + 1;
+        lines.append(text.mid(start, end - start));
+        start = end;
+    }
+    return lines;
+}
+
+/**
+ * @brief Compares two lists of lines.
+ *
+ * @param oldLines The lines of the old text.
+ * @param newLines The lines of the new text.
+ * @return The changed runs, in order.
+ */
+QVector<TextDiff::Hunk> TextDiff::diff(const QVector<QStringView> &oldLines, const QVector<QStringView> &newLines)
+{
+    // Lines both texts start and end with are unchanged
+    int prefix = 0;
+    const int shorter = qMin(oldLines.size(), newLines.size());
+    while (prefix < shorter && oldLines.at(prefix) == newLines.at(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < shorter - prefix
+           && oldLines.at(oldLines.size() - 1 - suffix) == newLines.at(newLines.size() - 1 - suffix)) {
+        ++suffix;
+    }
+
+    const int oldCount = oldLines.size() - prefix - suffix;
+    const int newCount = newLines.size() - prefix - suffix;
+    QVector<Hunk> hunks;
+    if (oldCount == 0 && newCount == 0) {
+        return hunks;
+    }
+
+    // Compare the rest by line id
+    QHash<QStringView, int> ids;
+    QVector<int> a;
+    QVector<int> b;
+    a.reserve(oldCount);
+    b.reserve(newCount);
+    for (int i = prefix; i < prefix + oldCount; ++i) {
+        auto it = ids.find(oldLines.at(i));
+        if (it == ids.end()) {
+            it = ids.insert(oldLines.at(i), ids.size());
+        }
+        a.append(it.value());
+    }
+    for (int i = prefix; i < prefix + newCount; ++i) {
+        const auto it = ids.constFind(newLines.at(i));
+        b.append(it == ids.constEnd() ? -1 - i : it.value());
+    }
+
+    if (!myers(a, b, &hunks)) {
+        hunks = {{0, oldCount, 0, newCount}};
+    }
+    for (Hunk &hunk : hunks) {
+        hunk.oldStart += prefix;
+        hunk.newStart += prefix;
+    }
+    return hunks;
+}
+
+/**
+ * @brief Lists the edits that turn a text into another.
+ *
+ * @param oldText The text to edit.
+ * @param newText The text to obtain.
+ * @return The edits, in order; apply them from the last to the first.
+ */
+QVector<TextDiff::LineEdit> TextDiff::lineEdits(QStringView oldText, QStringView newText)
+{
+    const QVector<QStringView> newLines = splitLines(newText);
+    QVector<LineEdit> edits;
+    for (const Hunk &hunk : diff(splitLines(oldText), newLines)) {
+        edits.append({hunk.oldStart, hunk.oldCount, joinLines(newLines, hunk.newStart, hunk.newStart + hunk.newCount)});
+    }
+    return edits;
+}
+
+/**
+ * @brief Merges two texts derived from a common ancestor.
+ *
+ * Both sides are compared with the ancestor. Changes of either side that
+ * overlap or touch are taken together as one region; the region is copied
+ * from the side that changed it, or becomes a conflict if both did.
+ *
+ * @param base The common ancestor.
+ * @param mine One side.
+ * @param theirs The other side.
+ * @param mineLabel Name of @p mine in conflict markers.
+ * @param theirsLabel Name of @p theirs in conflict markers.
+ * @return The merged text.
+ */
+TextDiff::MergeResult TextDiff::merge(QStringView base, QStringView mine, QStringView theirs,
+                                      const QString &mineLabel, const QString &theirsLabel)
+{
+    const QVector<QStringView> baseLines = splitLines(base);
+    const QVector<QStringView> mineLines = splitLines(mine);
+    const QVector<QStringView> theirsLines = splitLines(theirs);
+    const QVector<Hunk> mineHunks = diff(baseLines, mineLines);
+    const QVector<Hunk> theirsHunks = diff(baseLines, theirsLines);
+
+    MergeResult result;
+    result.text.reserve(qMax(mine.size(), theirs.size()));
+
+    int position = 0;      // Next line of base to copy
+    int mineShift = 0;     // Lines mine has gained before position
+    int theirsShift = 0;   // Lines theirs has gained before position
+    int i = 0;
+    int j = 0;
+    while (i < mineHunks.size() || j < theirsHunks.size()) {
+        // A region starts with the earliest hunk and takes in every hunk touching it
+        const bool mineFirst = j >= theirsHunks.size()
+            || (i < mineHunks.size() && mineHunks.at(i).oldStart <= theirsHunks.at(j).oldStart);
+        const Hunk &first = mineFirst ? mineHunks.at(i) : theirsHunks.at(j);
+        const int start = first.oldStart;
+        int end = first.oldStart + first.oldCount;
+
+        int mineEnd = i;
+        int theirsEnd = j;
+        int mineDelta = 0;
+        int theirsDelta = 0;
+        bool grown = true;
+        while (grown) {
+            grown = false;
+            for (; mineEnd < mineHunks.size() && mineHunks.at(mineEnd).oldStart <= end; ++mineEnd, grown = true) {
+                const Hunk &hunk = mineHunks.at(mineEnd);
+                end = qMax(end, hunk.oldStart + hunk.oldCount);
+                mineDelta += hunk.newCount - hunk.oldCount;
+            }
+            for (; theirsEnd < theirsHunks.size() && theirsHunks.at(theirsEnd).oldStart <= end; ++theirsEnd, grown = true) {
+                const Hunk &hunk = theirsHunks.at(theirsEnd);
+                end = qMax(end, hunk.oldStart + hunk.oldCount);
+                theirsDelta += hunk.newCount - hunk.oldCount;
+            }
+        }
+
+        result.text.append(joinLines(baseLines, position, start));
+
+        const QString mineText = joinLines(mineLines, start + mineShift, end + mineShift + mineDelta);
+        const QString theirsText = joinLines(theirsLines, start + theirsShift, end + theirsShift + theirsDelta);
+        if (theirsEnd == j || mineText == theirsText) {
+            result.text.append(mineText);
+        } else if (mineEnd == i) {
+            result.text.append(theirsText);
+        } else {
+            ++result.conflicts;
+            const auto appendSide = [&result](const QString &text) {
+                result.text.append(text);
+                if (!text.isEmpty() && !text.endsWith(QLatin1Char('\n'))) {
+                    result.text.append(QLatin1Char('\n'));
+                }
+            };
+            result.text.append(QStringLiteral("<<<<<<< ") + mineLabel + QLatin1Char('\n'));
+            appendSide(mineText);
+            result.text.append(QStringLiteral("=======\n"));
+            appendSide(theirsText);
+            result.text.append(QStringLiteral(">>>>>>> ") + theirsLabel + QLatin1Char('\n'));
+        }
+
+        position = end;
+        mineShift += mineDelta;
+        theirsShift += theirsDelta;
+        i = mineEnd;
+        j = theirsEnd;
+    }
+    result.text.append(joinLines(baseLines, position, baseLines.size()));
+    return result;
+}
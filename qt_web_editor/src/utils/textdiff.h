@@ -0,0 +1,105 @@
+/**
+ * @file textdiff.h
+ * @brief Declaration of the TextDiff class.
+ *
+ * This file contains the TextDiff class which compares texts line by line and
+ * merges two sets of changes to a common ancestor.
+ */
+
+#ifndef TEXTDIFF_H
+#define TEXTDIFF_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief The TextDiff class compares and merges texts line by line.
+ *
+ * Lines are compared by hash with Myers' algorithm, after the lines the texts
+ * start and end with in common have been set aside, so the cost grows with the
+ * size of the change rather than the size of the texts. Very different texts
+ * are treated as one replaced block rather than being compared in full.
+ *
+ * Lines are counted from 0 and include their '\n'; a text has as many lines as
+ * a QTextDocument holding it has blocks, not counting an empty last block.
+ */
+class TextDiff
+{
+public:
+    /**
+     * @brief A run of lines of the old text replaced by a run of lines of the new one.
+     */
+    struct Hunk
+    {
+        int oldStart = 0;  /**< First line in the old text. */
+        int oldCount = 0;  /**< Number of lines removed. */
+        int newStart = 0;  /**< First line in the new text. */
+        int newCount = 0;  /**< Number of lines inserted. */
+    };
+
+    /**
+     * @brief A change to apply to the old text to turn it into the new one.
+     */
+    struct LineEdit
+    {
+        int firstLine = 0;  /**< First line replaced, in the old text. */
+        int lineCount = 0;  /**< Number of lines replaced. */
+        QString text;       /**< The replacement, whole lines. */
+    };
+
+    /**
+     * @brief The outcome of a three-way merge.
+     */
+    struct MergeResult
+    {
+        QString text;       /**< The merged text, with conflict markers. */
+        int conflicts = 0;  /**< Number of regions both sides changed differently. */
+    };
+
+    /**
+     * @brief Splits a text into lines, each with its '\n'.
+     *
+     * @param text The text.
+     * @return Views of the lines, in order.
+     */
+    static QVector<QStringView> splitLines(QStringView text);
+
+    /**
+     * @brief Compares two lists of lines.
+     *
+     * @param oldLines The lines of the old text.
+     * @param newLines The lines of the new text.
+     * @return The changed runs, in order.
+     */
+    static QVector<Hunk> diff(const QVector<QStringView> &oldLines, const QVector<QStringView> &newLines);
+
+    /**
+     * @brief Lists the edits that turn a text into another.
+     *
+     * @param oldText The text to edit.
+     * @param newText The text to obtain.
+     * @return The edits, in order; apply them from the last to the first.
+     */
+    static QVector<LineEdit> lineEdits(QStringView oldText, QStringView newText);
+
+    /**
+     * @brief Merges two texts derived from a common ancestor.
+     *
+     * Changes made on one side only are taken as they are, and identical
+     * changes made on both sides are taken once. Regions changed differently
+     * on both sides are conflicts; both versions are kept between markers as
+     * in git.
+     *
+     * @param base The common ancestor.
+     * @param mine One side.
+     * @param theirs The other side.
+     * @param mineLabel Name of @p mine in conflict markers.
+     * @param theirsLabel Name of @p theirs in conflict markers.
+     * @return The merged text.
+     */
+    static MergeResult merge(QStringView base, QStringView mine, QStringView theirs,
+                             const QString &mineLabel, const QString &theirsLabel);
+};
+
+#endif // TEXTDIFF_H